@@ -1,11 +1,10 @@
 // Module: bme680_i2c.module.cpp
 // Purpose: Manages initialization and data reading from BME680 environmental sensors over the I2C bus.
 // Functions:
-// - setupBME680(): Initializes BME680 sensors with specific settings for temperature, humidity, pressure, and gas measurements.
-// - readBME680(): Reads temperature, humidity, pressure, and VOC (Volatile Organic Compounds) data from each BME680 sensor and stores the values in provided arrays.
-
-#include "i2c.h"
-#include <Wire.h>
+// - initBME680(): Initializes a single BME680 sensor with specific settings for temperature, humidity, pressure, and gas measurements.
+// - setupBME680(): Initializes all BME680 sensors.
+// - updateBME680(): Non-blocking acquisition step; starts staggered measurements and collects finished ones.
+// - readBME680(): Stores the last temperature, humidity, pressure, and VOC (Volatile Organic Compounds) values of each sensor in provided arrays; the acquisition is left to updateBME680().
 
 #include "i2c.h"
 #include <Wire.h>
@@ -18,21 +17,59 @@ Adafruit_BME680 bme680Sensors[BME680_SENSOR_COUNT] = {
 // I2C addresses of the BME680 sensors (adjust according to your setup)
 uint8_t bme680Addresses[BME680_SENSOR_COUNT] = {0x76, 0x77, 0x78, 0x79, 0x7A};
 
+// Sensors found during setup
+bool bme680Present[BME680_SENSOR_COUNT] = {false};
+
+// Acquisition state of a single BME680 sensor
+struct BME680Channel {
+    bool measuring;                 // A measurement was started and not collected yet
+    bool gasCycle;                  // The running measurement includes the gas heater
+    bool gasHeaterEnabled;          // Heater profile currently configured in the sensor
+    unsigned long nextStart;        // Time the next measurement is due
+    unsigned long nextGas;          // Time the next gas measurement is due
+    BME680Data lastValue;           // Last collected values (voc: last gas measurement)
+    unsigned long lastValueTime;    // Time temperature, humidity and pressure were collected
+    unsigned long lastGasTime;      // Time the gas resistance was collected
+    bool hasValue;
+    bool hasGas;
+};
+
+static BME680Channel channels[BME680_SENSOR_COUNT];
+
+// Function to (re)initialize a BME680 sensor; used at setup and when the inventory scan finds a sensor again
+bool initBME680(int index) {
+    if (index < 0 || index >= BME680_SENSOR_COUNT) {
+        return false;
+    }
+
+    // Try to initialize the sensor at the given address
+    bme680Present[index] = bme680Sensors[index].begin(bme680Addresses[index]);
+    if (!bme680Present[index]) {
+        return false;
+    }
+
+    // Configure oversampling settings
+    bme680Sensors[index].setTemperatureOversampling(BME680_OS_8X);
+    bme680Sensors[index].setHumidityOversampling(BME680_OS_2X);
+    bme680Sensors[index].setPressureOversampling(BME680_OS_4X);
+    bme680Sensors[index].setIIRFilterSize(BME680_FILTER_SIZE_3);
+    bme680Sensors[index].setGasHeater(0, 0); // Gas heater is only enabled for gas cycles
+
+    // Stagger the start times so conversions spread over the interval and the bus
+    unsigned long now = millis();
+    channels[index] = {};
+    channels[index].nextStart = now + index * (BME680_READ_INTERVAL / BME680_SENSOR_COUNT);
+    channels[index].nextGas = now + index * (BME680_GAS_INTERVAL / BME680_SENSOR_COUNT);
+    return true;
+}
+
 // Function to initialize the BME680 sensors
 void setupBME680() {
     Wire.begin(); // Initialize I2C communication
     for (int i = 0; i < BME680_SENSOR_COUNT; i++) {
-        // Try to initialize the sensor at the given address
-        if (!bme680Sensors[i].begin(bme680Addresses[i])) {
+        if (!initBME680(i)) {
             sendMessage("Could not find BME680 Sensor " + String(i) + "!", "debug", 6);
         } else {
-            // Configure oversampling settings
-            bme680Sensors[i].setTemperatureOversampling(BME680_OS_8X);
-            bme680Sensors[i].setHumidityOversampling(BME680_OS_2X);
-            bme680Sensors[i].setPressureOversampling(BME680_OS_4X);
-            bme680Sensors[i].setIIRFilterSize(BME680_FILTER_SIZE_3);
-            bme680Sensors[i].setGasHeater(320, 150); // Set gas heater to 320°C for 150 ms
-
             // Send the sensor ID as an MQTT message
             String sensorID = "BME680 Sensor " + String(i) + " Address: " + String(bme680Addresses[i], HEX);
             sendMessage(sensorID, "sensor", 1); // Send the message with MQTT priority 1
@@ -40,21 +77,71 @@ void setupBME680() {
     }
 }
 
-// Function to read data from the BME680 sensors
-void readBME680(float sensors[], float hums[], float pressures[], float vocs[]) {
+// Function to run one non-blocking acquisition step for all present sensors
+void updateBME680() {
+    unsigned long now = millis();
+
     for (int i = 0; i < BME680_SENSOR_COUNT; i++) {
-        if (bme680Sensors[i].performReading()) {
-            // Store temperature value
-            sensors[15 + i] = bme680Sensors[i].temperature;
-            // Store humidity value
-            hums[15 + i] = bme680Sensors[i].humidity;
-            // Store pressure value in hPa, rounded to one decimal place
-            pressures[15 + i] = round(bme680Sensors[i].pressure / 100.0 * 10) / 10.0;
-            // Store VOC value in kΩ, rounded to the nearest whole number
-            vocs[15 + i] = round(bme680Sensors[i].gas_resistance / 1000.0);
-
-            // Optional: Send the read values as an MQTT message
-            // sendMessage("BME680 Sensor " + String(i) + " read: Temp=" + String(sensors[15 + i]) + ", Hum=" + String(hums[15 + i]) + ", Pressure=" + String(pressures[15 + i]) + ", VOC=" + String(vocs[15 + i]) + ", ID=" + String(bme680Addresses[i], HEX), "sensor", 1);
+        if (!bme680Present[i]) {
+            continue;
+        }
+        Adafruit_BME680 &sensor = bme680Sensors[i];
+        BME680Channel &channel = channels[i];
+
+        // Collect a finished measurement; endReading() does not wait once the conversion time has passed
+        if (channel.measuring && sensor.remainingReadingMillis() == 0) {
+            channel.measuring = false;
+            if (sensor.endReading()) {
+                channel.lastValue.temperature = sensor.temperature;
+                channel.lastValue.humidity = sensor.humidity;
+                // Pressure in hPa, rounded to one decimal place
+                channel.lastValue.pressure = round(sensor.pressure / 100.0 * 10) / 10.0;
+                channel.lastValueTime = now;
+                channel.hasValue = true;
+                if (channel.gasCycle && sensor.gas_resistance > 0) {
+                    // VOC value in kΩ, rounded to the nearest whole number
+                    channel.lastValue.voc = round(sensor.gas_resistance / 1000.0);
+                    channel.lastGasTime = now;
+                    channel.hasGas = true;
+                }
+            }
+        }
+
+        // Start the next measurement; conversions of different sensors overlap
+        if (!channel.measuring && (long)(now - channel.nextStart) >= 0) {
+            channel.gasCycle = (long)(now - channel.nextGas) >= 0;
+            if (channel.gasCycle != channel.gasHeaterEnabled) {
+                if (channel.gasCycle) {
+                    sensor.setGasHeater(BME680_GAS_HEATER_TEMP, BME680_GAS_HEATER_TIME);
+                } else {
+                    sensor.setGasHeater(0, 0);
+                }
+                channel.gasHeaterEnabled = channel.gasCycle;
+            }
+            if (channel.gasCycle) {
+                channel.nextGas += BME680_GAS_INTERVAL;
+            }
+            channel.measuring = sensor.beginReading() != 0;
+            channel.nextStart += BME680_READ_INTERVAL;
+            if ((long)(now - channel.nextStart) >= 0) {
+                channel.nextStart = now + BME680_READ_INTERVAL; // Fell behind, do not catch up
+            }
         }
     }
 }
+
+// Function to read data from the BME680 sensors; only copies the cached values, never touches the bus
+void readBME680(float sensors[], float hums[], float pressures[], float vocs[]) {
+    unsigned long now = millis();
+
+    for (int i = 0; i < BME680_SENSOR_COUNT; i++) {
+        const BME680Channel &channel = channels[i];
+        bool valid = bme680Present[i] && channel.hasValue && now - channel.lastValueTime <= BME680_MAX_AGE;
+        bool gasValid = bme680Present[i] && channel.hasGas && now - channel.lastGasTime <= BME680_GAS_MAX_AGE;
+
+        sensors[15 + i] = valid ? channel.lastValue.temperature : NAN;
+        hums[15 + i] = valid ? channel.lastValue.humidity : NAN;
+        pressures[15 + i] = valid ? channel.lastValue.pressure : NAN;
+        vocs[15 + i] = gasValid ? channel.lastValue.voc : NAN;
+    }
+}
@@ -0,0 +1,111 @@
+// Module: boot_module.cpp
+// Purpose: Records the start and end of every boot phase (µs since reset) and publishes them once as
+//          {"reset_reason": 1, "phases": [{"name": "sensors", "start_ms": 3.1, "duration_ms": 41.7}, ...]};
+//          phases that did not end yet have a null duration.
+// Functions:
+// - beginBootPhase(), endBootPhase(): Store the timestamps under a lock; the first call wins.
+// - isBootPhaseDone(): Checks whether the end of a phase was recorded.
+// - publishBootReport(): Publishes the report to boot_timing once the network phases are done or
+//   BOOT_REPORT_TIMEOUT has passed; returns true once it was sent.
+
+
+#include "boot_module.h"
+#include "message_module.h"
+#include "topic_module.h"
+#include "log_module.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+
+// Names of the phases in the report
+static const char* const phaseNames[BOOT_PHASE_COUNT] = {
+    "logging", "sensors", "inventory", "control", "first_control", "wifi", "ntp", "mqtt"
+};
+
+// Structure of the timestamps of a phase
+struct BootPhaseTiming {
+    int64_t start;          // µs since reset, -1 until the phase started
+    int64_t end;            // µs since reset, -1 until the phase ended
+};
+
+static BootPhaseTiming phases[BOOT_PHASE_COUNT] = {
+    {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}
+};
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+static bool reportSent = false;
+
+// Function to record the start of a phase
+void beginBootPhase(BootPhase phase) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&bootMux);
+    if (phases[phase].start < 0) {
+        phases[phase].start = now;
+    }
+    portEXIT_CRITICAL(&bootMux);
+}
+
+// Function to record the end of a phase
+void endBootPhase(BootPhase phase) {
+    int64_t now = esp_timer_get_time();
+    bool ended = false;
+    int64_t start;
+    portENTER_CRITICAL(&bootMux);
+    if (phases[phase].end < 0) {
+        phases[phase].start = phases[phase].start < 0 ? 0 : phases[phase].start;
+        phases[phase].end = now;
+        ended = true;
+    }
+    start = phases[phase].start;
+    portEXIT_CRITICAL(&bootMux);
+
+    if (ended) {
+        LOG_INFO(LOG_MODULE_MAIN, "Boot phase %s: %lu ms (at %lu ms)", phaseNames[phase],
+                 (unsigned long)((now - start) / 1000), (unsigned long)(now / 1000));
+    }
+}
+
+// Function to check whether a phase has ended
+bool isBootPhaseDone(BootPhase phase) {
+    portENTER_CRITICAL(&bootMux);
+    bool done = phases[phase].end >= 0;
+    portEXIT_CRITICAL(&bootMux);
+    return done;
+}
+
+// Function to publish the phase timings once; runs on the network task
+bool publishBootReport() {
+    if (reportSent) {
+        return true;
+    }
+    bool networkDone = isBootPhaseDone(BOOT_PHASE_NTP) && isBootPhaseDone(BOOT_PHASE_FIRST_CONTROL);
+    if (!isMQTTConnected() || (!networkDone && millis() < BOOT_REPORT_TIMEOUT)) {
+        return false;
+    }
+
+    BootPhaseTiming copy[BOOT_PHASE_COUNT];
+    portENTER_CRITICAL(&bootMux);
+    memcpy(copy, phases, sizeof(copy));
+    portEXIT_CRITICAL(&bootMux);
+
+    static char report[BOOT_REPORT_SIZE];
+    size_t length = snprintf(report, sizeof(report), "{\"reset_reason\":%d,\"phases\":[", (int)esp_reset_reason());
+    for (int i = 0; i < BOOT_PHASE_COUNT && length < sizeof(report); i++) {
+        length += snprintf(report + length, sizeof(report) - length, "%s{\"name\":\"%s\",\"start_ms\":", i > 0 ? "," : "", phaseNames[i]);
+        if (copy[i].start < 0) {
+            length += snprintf(report + length, sizeof(report) - length, "null,\"duration_ms\":null}");
+        } else if (copy[i].end < 0) {
+            length += snprintf(report + length, sizeof(report) - length, "%.1f,\"duration_ms\":null}", copy[i].start / 1000.0);
+        } else {
+            length += snprintf(report + length, sizeof(report) - length, "%.1f,\"duration_ms\":%.1f}",
+                               copy[i].start / 1000.0, (copy[i].end - copy[i].start) / 1000.0);
+        }
+    }
+    if (length + 3 > sizeof(report)) {
+        LOG_ERROR(LOG_MODULE_MAIN, "Boot report does not fit the buffer");
+        reportSent = true;
+        return true;
+    }
+    strcat(report, "]}");
+
+    reportSent = publishMessage(getOutboundTopic(TOPIC_BOOT_TIMING), report, true);
+    return reportSent;
+}
@@ -0,0 +1,43 @@
+// Module: boot_module.h
+// Purpose: Declares the boot phase instrumentation. Local phases run in setup(); network phases complete
+//          later in the background. Each phase records its start and end so time-to-first-control
+//          and connectivity delays can be tracked across firmware versions.
+// Definitions:
+// - BOOT_REPORT_TIMEOUT: Time after which the report is published even if phases are still open.
+// - BOOT_REPORT_SIZE: Size of the serialized report.
+// Enumerations:
+// - BootPhase: Measured phases.
+// Function Prototypes:
+// - beginBootPhase(), endBootPhase(): Record the start and end of a phase (any task).
+// - isBootPhaseDone(): Checks whether a phase has ended.
+// - publishBootReport(): Publishes the phase timings once (network task).
+
+
+#ifndef BOOT_MODULE_H
+#define BOOT_MODULE_H
+
+#include <Arduino.h>
+
+#define BOOT_REPORT_TIMEOUT 120000      // Publish after 2 minutes even without NTP (in ms)
+#define BOOT_REPORT_SIZE 768
+
+// Enumeration of the boot phases
+enum BootPhase : uint8_t {
+    BOOT_PHASE_LOGGING,         // Serial and log buffer
+    BOOT_PHASE_SENSORS,         // Sensor and GPIO setup
+    BOOT_PHASE_INVENTORY,       // Initial bus scan
+    BOOT_PHASE_CONTROL,         // Routing, servos, PID and task start
+    BOOT_PHASE_FIRST_CONTROL,   // From reset to the first heater decision on a valid temperature
+    BOOT_PHASE_WIFI,            // Association and IP address
+    BOOT_PHASE_NTP,             // Clock synchronized
+    BOOT_PHASE_MQTT,            // First broker connection
+    BOOT_PHASE_COUNT
+};
+
+// Function prototypes
+void beginBootPhase(BootPhase phase);
+void endBootPhase(BootPhase phase);
+bool isBootPhaseDone(BootPhase phase);
+bool publishBootReport();
+
+#endif // BOOT_MODULE_H
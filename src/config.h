@@ -1,17 +1,24 @@
 // Module: config.h
 // Purpose: Contains configuration settings for WiFi, MQTT, debug modes, and zone definitions.
 // Definitions:
-// - WiFi credentials and MQTT server settings.
+// - WiFi credentials, MQTT server and Signal K server settings.
 // - Number of zones and sensors, hysteresis values for temperature control.
 // Structures:
-// - Zone: Represents a heating zone with attributes like name, current temperature, target temperature, humidity, etc.
+// - Zone: Cold data of a heating zone: name, servo valve and telemetry such as humidity, pressure and VOC.
+//   The zones themselves are declared in zone_descriptors.h.
+// - ZoneState: Hot control state of all zones as packed arrays: temperatures and targets in centi-degrees
+//   with validity bitmasks (accessors in zones_module.h).
 // External Variables:
 // - zones[]: Array of Zone structures representing different heating zones.
+// - zoneState: Control state of all zones.
 // - mainTemperature: Global variable representing the main temperature used for control logic.
 
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <array>
+#include <stdint.h>
+
 // WiFi credentials
 #define WIFI_SSID "your_wifi_ssid"
 #define WIFI_PASS "your_wifi_password"
@@ -23,32 +30,46 @@
 #define MQTT_PORT 1883
 #define MQTT_BASE_PATH "signalk/your_system_id/vessels/self/heater"
 #define SYSTEM_ID "your_system_id"
+#define SIGNALK_PATH "heater" // Signal K path of the heater below vessels.self
+#define SIGNALK_SOURCE "heatercontroller" // Source label of the deltas sent by the controller
+
+// Signal K server for the WebSocket transport (see transport_module)
+#define SIGNALK_HOST "your_signalk_host"
+#define SIGNALK_PORT 3000
+#define SIGNALK_TOKEN "" // Access token; empty for servers without security
 
 // Debug settings
 #define DEBUG_MODE true  // Set to false to disable debug messages
 
 // Define the number of zones
-#define NUM_ZONES 10 // Adjust to the actual number of zones
+#define NUM_ZONES 10 // Zone slots; sizes the NVS records, the zones are listed in zone_descriptors.h
 #define NUM_SENSORS 20 // Max number of sensors (5 DHT, 10 DS18, 5 BME680)
 
 // Hysteresis values for temperature control
 #define HYSTERESIS_OVER 1.0  // Threshold above the target in degrees Celsius
 #define HYSTERESIS_UNDER 2.0 // Threshold below the target in degrees Celsius
 
-// Structure to represent a heating zone
+// Structure to represent the cold data of a heating zone; read by telemetry, not by the control pass
 struct Zone {
-    char name[20];            // Name of the zone
-    float temperature;        // Current temperature
+    const char* name;         // Name of the zone, "" for an unused slot
     float humidity;           // Current humidity
-    float temperatureTarget;  // Target temperature
     float temperatureValve;   // Temperature at the valve (if applicable)
     int servoValve;           // Servo valve number
     float pressure;           // Atmospheric pressure
     float voc;                // VOC value (air quality)
 };
 
-// Declare the global zones array as external
-extern Zone zones[NUM_ZONES];
+// Structure of the control state of all zones, one array per field; written and read by the control task
+struct ZoneState {
+    int16_t temperature[NUM_ZONES];     // Current temperature (in centi-degrees Celsius)
+    int16_t target[NUM_ZONES];          // Target temperature (in centi-degrees Celsius)
+    uint16_t temperatureValid;          // Bit per zone: the temperature holds a measurement
+    uint16_t targetValid;               // Bit per zone: the target is set
+};
+
+// Declare the global zones array and the control state as external
+extern std::array<Zone, NUM_ZONES> zones;
+extern ZoneState zoneState;
 
 // Declare mainTemperature as external to make it accessible in other files
 extern float mainTemperature;
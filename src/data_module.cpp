@@ -1,33 +1,111 @@
 // Module: data_module.cpp
 // Purpose: Processes incoming MQTT data and updates the zone configurations accordingly.
 // Functions:
-// - processIncomingData(): Parses incoming MQTT messages to update the target temperatures for different zones based on the topic and message received.
+// - processIncomingData(): Updates the target temperature of the zone an incoming message was routed to.
+// - findPayloadNumber(): Extracts a numeric value from a payload like {"value": 21.5} or a plain number.
+// - findPayloadString(): Extracts a string value from a payload like {"url": "http://..."}.
 
 
 #include "data_module.h"
-#include "config.h"
+#include "zones_module.h"
 #include "message_module.h"
 #include "gpio_module.h"
+#include "log_module.h"
 
-// Function to process incoming MQTT data
-void processIncomingData(const String &topic, const String &message) {
-    sendMessage("Processing incoming data", "debug", 6);
-    for (int i = 0; i < 10; i++) {
-        // Construct the expected topic for the target temperature of the zone
-        String expectedTopic = "N/" + String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/target_temperature";
-        if (topic == expectedTopic) {
-            float newTarget = message.toFloat();
-            // Debug: Show the parsed target temperature value
-            sendMessage("Parsed target temperature value: " + String(newTarget), "debug", 6);
-
-            if (!isnan(newTarget)) {
-                // Update the target temperature for the zone
-                zones[i].temperatureTarget = newTarget;
-                // Debug: Confirm the assignment
-                sendMessage("Updated target temperature for zone: " + String(zones[i].name) + " to " + String(zones[i].temperatureTarget), "debug", 6);
-            } else {
-                sendMessage("Received invalid target temperature value (NaN).", "debug", 6);
+// Function to process an incoming target temperature for a zone
+void processIncomingData(int zoneIndex, float value) {
+    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES) {
+        return;
+    }
+
+    if (!isnan(value)) {
+        // Update the target temperature for the zone
+        setZoneTarget(zoneIndex, value);
+        // Debug: Confirm the assignment
+        LOG_DEBUG(LOG_MODULE_HEATER, "Updated target temperature for zone: %s to %.2f", zones[zoneIndex].name, value);
+    } else {
+        LOG_WARN(LOG_MODULE_HEATER, "Received invalid target temperature value (NaN).");
+    }
+}
+
+// Function to find the start of the value of a JSON key; returns nullptr if the key is missing
+static const char* findPayloadKey(const uint8_t* payload, unsigned int length, const char* key) {
+    const char* p = (const char*)payload;
+    const char* end = p + length;
+    size_t keyLength = strlen(key);
+
+    while (p < end) {
+        const char* quote = (const char*)memchr(p, '"', end - p);
+        if (quote == nullptr || quote + keyLength + 2 > end) {
+            return nullptr;
+        }
+        if (memcmp(quote + 1, key, keyLength) == 0 && quote[keyLength + 1] == '"') {
+            // Skip whitespace and the colon after the key
+            const char* v = quote + keyLength + 2;
+            while (v < end && (*v == ' ' || *v == '\t' || *v == ':')) {
+                v++;
             }
+            return v < end ? v : nullptr;
+        }
+        p = quote + 1;
+    }
+    return nullptr;
+}
+
+// Function to extract a number; plain numeric payloads are accepted as well
+bool findPayloadNumber(const uint8_t* payload, unsigned int length, const char* key, float &value) {
+    char number[24];
+    const char* start = findPayloadKey(payload, length, key);
+    const char* end = (const char*)payload + length;
+
+    if (start == nullptr) {
+        // Plain payload such as "21.5"
+        start = (const char*)payload;
+        while (start < end && isspace((unsigned char)*start)) {
+            start++;
+        }
+        if (start == end || *start == '{') {
+            return false;
+        }
+    }
+    if (start < end && *start == '"') {
+        start++; // Quoted number
+    }
+
+    size_t n = 0;
+    while (start + n < end && n < sizeof(number) - 1 && strchr("+-.0123456789eE", start[n]) != nullptr) {
+        number[n] = start[n];
+        n++;
+    }
+    if (n == 0) {
+        return false;
+    }
+    number[n] = '\0';
+
+    char* parsedEnd;
+    value = strtof(number, &parsedEnd);
+    return parsedEnd != number;
+}
+
+// Function to extract a string value; escaped characters are copied without their backslash
+bool findPayloadString(const uint8_t* payload, unsigned int length, const char* key, char* buffer, size_t bufferSize) {
+    const char* start = findPayloadKey(payload, length, key);
+    const char* end = (const char*)payload + length;
+    if (start == nullptr || *start != '"' || bufferSize == 0) {
+        return false;
+    }
+    start++;
+
+    size_t n = 0;
+    while (start < end && *start != '"') {
+        if (*start == '\\' && start + 1 < end) {
+            start++;
+        }
+        if (n >= bufferSize - 1) {
+            return false; // Value does not fit
         }
+        buffer[n++] = *start++;
     }
+    buffer[n] = '\0';
+    return start < end;
 }
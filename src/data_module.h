@@ -1,7 +1,9 @@
 // Module: data_module.h
 // Purpose: Declares functions for processing incoming data, particularly MQTT messages, and updating the system state accordingly.
 // Function Prototypes:
-// - processIncomingData(const String &topic, const String &message): Processes incoming MQTT messages to update zone configurations such as target temperatures.
+// - processIncomingData(int zoneIndex, float value): Updates the target temperature of a zone.
+// - findPayloadNumber(): Extracts a number from a JSON or plain payload without allocating.
+// - findPayloadString(): Extracts a string value from a JSON payload without allocating.
 
 #ifndef DATA_MODULE_H
 #define DATA_MODULE_H
@@ -10,6 +12,10 @@
 #include <Arduino.h>
 
 // Function prototype for processing incoming MQTT data
-void processIncomingData(const String &topic, const String &message);
+void processIncomingData(int zoneIndex, float value);
+
+// Function prototypes for allocation-free payload parsing
+bool findPayloadNumber(const uint8_t* payload, unsigned int length, const char* key, float &value);
+bool findPayloadString(const uint8_t* payload, unsigned int length, const char* key, char* buffer, size_t bufferSize);
 
 #endif // DATA_MODULE_H
@@ -0,0 +1,95 @@
+// Module: dht_capture_module.cpp
+// Purpose: Captures DHT22 pulse trains with the RMT receiver (legacy IDF 4.4 driver), so no code runs
+//          with interrupts disabled while a sensor transmits.
+// Functions:
+// - setupDHTCapture(): Configures the receive channels with 1 µs resolution and installs the driver.
+// - holdDHTStart(): Switches the pin to open-drain output and pulls it low.
+// - startDHTCapture(): Routes the pin to the channel (which makes it an input again, releasing the line)
+//   and starts the receiver.
+// - collectDHTCapture(): Takes a finished frame from the ring buffer, converts the RMT items to pulses
+//   and stops the receiver.
+
+
+#include "dht_capture_module.h"
+#include "log_module.h"
+#include <driver/rmt.h>
+#include <driver/gpio.h>
+#include <freertos/ringbuf.h>
+
+static RingbufHandle_t ringBuffers[DHT_CAPTURE_CHANNELS];
+
+// Function to install the RMT receiver on all DHT channels
+bool setupDHTCapture() {
+    for (int i = 0; i < DHT_CAPTURE_CHANNELS; i++) {
+        rmt_channel_t channel = (rmt_channel_t)(DHT_CAPTURE_FIRST_CHANNEL + i);
+        rmt_config_t config = RMT_DEFAULT_CONFIG_RX(GPIO_NUM_NC, channel);
+        config.clk_div = 80;                              // 80 MHz APB clock: 1 tick = 1 µs
+        config.mem_block_num = 1;                         // 48 items, a frame needs 43
+        config.rx_config.filter_en = true;
+        config.rx_config.filter_ticks_thresh = 100;       // Ignore glitches shorter than 1.25 µs
+        config.rx_config.idle_threshold = DHT_CAPTURE_IDLE;
+
+        if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, DHT_CAPTURE_BUFFER, 0) != ESP_OK ||
+            rmt_get_ringbuf_handle(channel, &ringBuffers[i]) != ESP_OK) {
+            LOG_ERROR(LOG_MODULE_SENSORS, "RMT channel %d for DHT capture not available", (int)channel);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to start the host start signal on a data line
+void holdDHTStart(uint8_t pin) {
+    gpio_set_pull_mode((gpio_num_t)pin, GPIO_PULLUP_ONLY);
+    gpio_set_level((gpio_num_t)pin, 0);
+    gpio_set_direction((gpio_num_t)pin, GPIO_MODE_INPUT_OUTPUT_OD);
+}
+
+// Function to release the data line and start receiving on a channel
+bool startDHTCapture(int channel, uint8_t pin) {
+    if (channel < 0 || channel >= DHT_CAPTURE_CHANNELS) {
+        return false;
+    }
+    rmt_channel_t rmtChannel = (rmt_channel_t)(DHT_CAPTURE_FIRST_CHANNEL + channel);
+
+    // Drop a stale frame left over from an earlier capture
+    size_t size = 0;
+    void* stale = xRingbufferReceive(ringBuffers[channel], &size, 0);
+    if (stale != nullptr) {
+        vRingbufferReturnItem(ringBuffers[channel], stale);
+    }
+
+    // Routing the pin to the receiver configures it as an input, which releases the line
+    rmt_set_gpio(rmtChannel, RMT_MODE_RX, (gpio_num_t)pin, false);
+    return rmt_rx_start(rmtChannel, true) == ESP_OK;
+}
+
+// Function to collect a finished frame; returns the number of pulses or -1 if the frame is not complete yet
+int collectDHTCapture(int channel, DHTPulse* pulses, int maxPulses) {
+    if (channel < 0 || channel >= DHT_CAPTURE_CHANNELS) {
+        return 0;
+    }
+
+    size_t size = 0;
+    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(ringBuffers[channel], &size, 0);
+    if (items == nullptr) {
+        return -1;
+    }
+
+    int count = 0;
+    size_t itemCount = size / sizeof(rmt_item32_t);
+    for (size_t i = 0; i < itemCount && count < maxPulses; i++) {
+        // A zero duration marks the end of the frame
+        if (items[i].duration0 == 0) {
+            break;
+        }
+        pulses[count++] = {(uint8_t)items[i].level0, (uint16_t)items[i].duration0};
+        if (items[i].duration1 == 0 || count >= maxPulses) {
+            break;
+        }
+        pulses[count++] = {(uint8_t)items[i].level1, (uint16_t)items[i].duration1};
+    }
+    vRingbufferReturnItem(ringBuffers[channel], items);
+    rmt_rx_stop((rmt_channel_t)(DHT_CAPTURE_FIRST_CHANNEL + channel));
+    return count;
+}
@@ -0,0 +1,33 @@
+// Module: dht_capture_module.h
+// Purpose: Declares the capture of DHT22 pulse trains with the RMT receiver. The ESP32-S3 has four RMT
+//          receive channels; a channel is routed to a sensor pin for each capture, so more sensors than
+//          channels are read in batches.
+// Definitions:
+// - DHT_CAPTURE_CHANNELS, DHT_CAPTURE_FIRST_CHANNEL: RMT receive channels used for DHT sensors.
+// - DHT_CAPTURE_IDLE: Unchanged line level (in µs) that ends a capture.
+// - DHT_CAPTURE_BUFFER: Receive ring buffer per channel (in bytes).
+// Function Prototypes:
+// - setupDHTCapture(): Installs the RMT receiver on all DHT channels.
+// - holdDHTStart(): Pulls a data line low to start the host start signal.
+// - startDHTCapture(): Releases the line and starts receiving on a channel.
+// - collectDHTCapture(): Returns the captured pulses without waiting.
+
+
+#ifndef DHT_CAPTURE_MODULE_H
+#define DHT_CAPTURE_MODULE_H
+
+#include <Arduino.h>
+#include "dht_decoder.h"
+
+#define DHT_CAPTURE_CHANNELS 4        // RMT channels 4-7 are the receive channels of the ESP32-S3
+#define DHT_CAPTURE_FIRST_CHANNEL 4
+#define DHT_CAPTURE_IDLE 200          // A frame ends after 200 µs without an edge
+#define DHT_CAPTURE_BUFFER 512
+
+// Function prototypes
+bool setupDHTCapture();
+void holdDHTStart(uint8_t pin);
+bool startDHTCapture(int channel, uint8_t pin);
+int collectDHTCapture(int channel, DHTPulse* pulses, int maxPulses); // Pulse count, -1 while still capturing
+
+#endif // DHT_CAPTURE_MODULE_H
@@ -0,0 +1,58 @@
+// Module: dht_decoder.cpp
+// Purpose: Decodes captured DHT22 (AM2302) pulse trains.
+// Functions:
+// - decodeDHT(): Finds the sensor response (80 µs low, 80 µs high) and reads the following 40 bits.
+//   A bit is 1 when its high pulse is longer than the 50 µs low pulse before it, which tolerates
+//   the clock spread between sensors better than a fixed threshold.
+// - convertDHT22(): Converts the data bytes (humidity and sign-magnitude temperature in 0.1 units).
+
+
+#include "dht_decoder.h"
+
+// Function to check whether a pulse has the given level and a duration within the limits
+static inline bool isPulse(const DHTPulse &pulse, uint8_t level, uint16_t minimum, uint16_t maximum) {
+    return pulse.level == level && pulse.duration >= minimum && pulse.duration <= maximum;
+}
+
+// Function to decode a pulse train into five data bytes
+DHTDecodeResult decodeDHT(const DHTPulse* pulses, size_t count, uint8_t data[5]) {
+    // Locate the response; the capture may start with the tail of the host start signal
+    size_t start = 0;
+    while (start + 1 < count && !(isPulse(pulses[start], 0, DHT_RESPONSE_MIN, DHT_RESPONSE_MAX) &&
+                                  isPulse(pulses[start + 1], 1, DHT_RESPONSE_MIN, DHT_RESPONSE_MAX))) {
+        start++;
+    }
+    if (start + 1 >= count) {
+        return DHT_ERROR_NO_RESPONSE;
+    }
+    start += 2;
+    if (count - start < 80) {
+        return DHT_ERROR_TRUNCATED;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        data[i] = 0;
+    }
+    for (int bit = 0; bit < 40; bit++) {
+        const DHTPulse &low = pulses[start + bit * 2];
+        const DHTPulse &high = pulses[start + bit * 2 + 1];
+        if (!isPulse(low, 0, DHT_BIT_LOW_MIN, DHT_BIT_LOW_MAX) || !isPulse(high, 1, DHT_BIT_HIGH_MIN, DHT_BIT_HIGH_MAX)) {
+            return DHT_ERROR_TIMING;
+        }
+        data[bit / 8] = (data[bit / 8] << 1) | (high.duration > low.duration ? 1 : 0);
+    }
+
+    if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+        return DHT_ERROR_CHECKSUM;
+    }
+    return DHT_OK;
+}
+
+// Function to convert DHT22 data bytes to temperature (°C) and relative humidity (%)
+void convertDHT22(const uint8_t data[5], float &temperature, float &humidity) {
+    humidity = ((data[0] << 8) | data[1]) * 0.1f;
+    temperature = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+    if (data[2] & 0x80) {
+        temperature = -temperature;
+    }
+}
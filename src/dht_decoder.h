@@ -0,0 +1,50 @@
+// Module: dht_decoder.h
+// Purpose: Declares the decoder for captured DHT22 (AM2302) pulse trains. Pure code without hardware
+//          access, so it runs unchanged in the native build.
+// Definitions:
+// - DHT_MAX_PULSES: Capacity of a capture buffer.
+// - DHT_RESPONSE_MIN, DHT_RESPONSE_MAX: Accepted length of the 80 µs response pulses.
+// - DHT_BIT_LOW_MIN, DHT_BIT_LOW_MAX, DHT_BIT_HIGH_MIN, DHT_BIT_HIGH_MAX: Accepted lengths of the bit pulses.
+// Enumerations:
+// - DHTDecodeResult: Outcome of decoding a capture.
+// Structures:
+// - DHTPulse: Level and duration of a captured pulse.
+// Function Prototypes:
+// - decodeDHT(): Extracts the five data bytes from a pulse train and checks the checksum.
+// - convertDHT22(): Converts the data bytes to temperature and humidity.
+
+
+#ifndef DHT_DECODER_H
+#define DHT_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DHT_MAX_PULSES 96       // Response (2) + 40 bits (80) + margin
+#define DHT_RESPONSE_MIN 60     // Sensor response low/high (typically 80 µs)
+#define DHT_RESPONSE_MAX 110
+#define DHT_BIT_LOW_MIN 30      // Bit start (typically 50 µs)
+#define DHT_BIT_LOW_MAX 90
+#define DHT_BIT_HIGH_MIN 10     // "0": 26-28 µs, "1": 70 µs
+#define DHT_BIT_HIGH_MAX 100
+
+// Enumeration of decoding outcomes
+enum DHTDecodeResult : uint8_t {
+    DHT_OK,
+    DHT_ERROR_NO_RESPONSE,  // Response pulses not found
+    DHT_ERROR_TRUNCATED,    // Fewer than 40 bits captured
+    DHT_ERROR_TIMING,       // A bit pulse is out of range
+    DHT_ERROR_CHECKSUM      // Checksum mismatch
+};
+
+// Structure of a captured pulse
+struct DHTPulse {
+    uint8_t level;          // Line level during the pulse
+    uint16_t duration;      // Duration in µs
+};
+
+// Function prototypes
+DHTDecodeResult decodeDHT(const DHTPulse* pulses, size_t count, uint8_t data[5]);
+void convertDHT22(const uint8_t data[5], float &temperature, float &humidity);
+
+#endif // DHT_DECODER_H
@@ -1,44 +1,170 @@
 // Module: dht_module.cpp
 // Purpose: Handles initialization and data acquisition from DHT temperature and humidity sensors.
+//          The sensors are read without blocking: the RMT receiver captures the pulse trains and
+//          the decoder turns them into values. The S3 has fewer receive channels than sensors, so a
+//          read round triggers the sensors in batches.
 // Functions:
-// - setupDHT(): Initializes all connected DHT sensors.
-// - readDHT(): Reads temperature and humidity values from each DHT sensor and passes them by reference.
+// - setupDHT(): Initializes the RMT capture and the acquisition state.
+// - updateDHT(): Non-blocking acquisition step; triggers a batch, collects its frames on a later call.
+// - readDHT(): Passes the last temperature and humidity values of each DHT sensor by reference.
 
 
 #include "dht_module.h"
+#include "dht_capture_module.h"
+#include "dht_decoder.h"
+#include "log_module.h"
+#include <esp_timer.h>
 
-// Initialize DHT sensors at the defined pins
-DHT dht1(DHTPIN_1, DHTTYPE);
-DHT dht2(DHTPIN_2, DHTTYPE);
-DHT dht3(DHTPIN_3, DHTTYPE);
-DHT dht4(DHTPIN_4, DHTTYPE);
-DHT dht5(DHTPIN_5, DHTTYPE);
+// Pins of the DHT sensors
+static const uint8_t dhtPins[DHT_SENSOR_COUNT] = {DHTPIN_1, DHTPIN_2, DHTPIN_3, DHTPIN_4, DHTPIN_5};
+
+// Last values of a single DHT sensor
+struct DHTChannel {
+    float temperature;
+    float humidity;
+    unsigned long lastValueTime;
+    bool hasValue;
+    uint32_t errors;                // Failed reads since startup
+    DHTDecodeResult lastError;
+};
+
+static DHTChannel channels[DHT_SENSOR_COUNT];
+
+// Acquisition state of a read round
+static bool captureReady = false;           // RMT receiver installed
+static bool capturing = false;              // A batch was triggered and not collected yet
+static volatile bool released = false;      // The start signal of the batch has ended
+static int batchStart = 0;                  // First sensor of the current batch
+static int batchSize = 0;
+static bool batchCollected[DHT_CAPTURE_CHANNELS];
+static unsigned long batchTime = 0;
+static unsigned long nextRound = 0;
+static esp_timer_handle_t releaseTimer = nullptr;
+
+// Timer callback: end the start signal and start receiving the responses of the batch
+static void releaseBatch(void* arg) {
+    for (int i = 0; i < batchSize; i++) {
+        startDHTCapture(i, dhtPins[batchStart + i]);
+    }
+    released = true;
+}
+
+// Function to start the start signal of the sensors of a batch
+static void triggerBatch(int first, unsigned long now) {
+    batchStart = first;
+    batchSize = min(DHT_SENSOR_COUNT - first, DHT_CAPTURE_CHANNELS);
+    for (int i = 0; i < batchSize; i++) {
+        holdDHTStart(dhtPins[first + i]);
+        batchCollected[i] = false;
+    }
+    released = false;
+    capturing = true;
+    batchTime = now;
+    esp_timer_start_once(releaseTimer, DHT_START_TIME);
+}
+
+// Function to store the outcome of a read
+static void storeReading(int index, const DHTPulse* pulses, int count, unsigned long now) {
+    DHTChannel &channel = channels[index];
+    uint8_t data[5];
+    DHTDecodeResult result = count > 0 ? decodeDHT(pulses, count, data) : DHT_ERROR_NO_RESPONSE;
+
+    if (result == DHT_OK) {
+        convertDHT22(data, channel.temperature, channel.humidity);
+        channel.lastValueTime = now;
+        channel.hasValue = true;
+    } else {
+        channel.errors++;
+        if (result != channel.lastError) {
+            LOG_DEBUG(LOG_MODULE_SENSORS, "DHT sensor %d read failed (%d)", index + 1, (int)result);
+        }
+    }
+    channel.lastError = result;
+}
+
+// Function to collect the frames of the current batch; returns false while frames are outstanding
+static bool collectBatch(unsigned long now) {
+    if (!released) {
+        return false;
+    }
+    bool timedOut = now - batchTime >= DHT_CAPTURE_TIMEOUT;
+    bool complete = true;
+
+    for (int i = 0; i < batchSize; i++) {
+        if (batchCollected[i]) {
+            continue;
+        }
+        DHTPulse pulses[DHT_MAX_PULSES];
+        int count = collectDHTCapture(i, pulses, DHT_MAX_PULSES);
+        if (count < 0 && !timedOut) {
+            complete = false;
+            continue;
+        }
+        storeReading(batchStart + i, pulses, count, now);
+        batchCollected[i] = true;
+    }
+    return complete;
+}
 
 // Function to initialize DHT sensors
 void setupDHT() {
-    dht1.begin();
-    dht2.begin();
-    dht3.begin();
-    dht4.begin();
-    dht5.begin();
+    for (int i = 0; i < DHT_SENSOR_COUNT; i++) {
+        channels[i] = {NAN, NAN, 0, false, 0, DHT_OK};
+        pinMode(dhtPins[i], INPUT_PULLUP);
+    }
+
+    captureReady = setupDHTCapture();
+    if (!captureReady) {
+        LOG_WARN(LOG_MODULE_SENSORS, "DHT capture not available, DHT sensors disabled");
+        return;
+    }
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = releaseBatch;
+    timerArgs.name = "dht_start";
+    esp_timer_create(&timerArgs, &releaseTimer);
+    capturing = false;
+    nextRound = millis();
+}
+
+// Function to run one non-blocking acquisition step
+void updateDHT() {
+    if (!captureReady) {
+        return;
+    }
+    unsigned long now = millis();
+
+    if (capturing) {
+        if (!collectBatch(now)) {
+            return;
+        }
+        capturing = false;
+        // Trigger the next batch right away; the previous sensors are silent again
+        if (batchStart + batchSize < DHT_SENSOR_COUNT) {
+            triggerBatch(batchStart + batchSize, now);
+        }
+        return;
+    }
+
+    if ((long)(now - nextRound) >= 0) {
+        triggerBatch(0, now);
+        nextRound += DHT_READ_INTERVAL;
+        if ((long)(now - nextRound) >= 0) {
+            nextRound = now + DHT_READ_INTERVAL; // Fell behind, do not catch up
+        }
+    }
 }
 
 // Function to read temperature and humidity from DHT sensors
 void readDHT(float &temp1, float &hum1, float &temp2, float &hum2, float &temp3, float &hum3, float &temp4, float &hum4, float &temp5, float &hum5) {
-    temp1 = dht1.readTemperature();
-    hum1 = dht1.readHumidity();
-    temp2 = dht2.readTemperature();
-    hum2 = dht2.readHumidity();
-    temp3 = dht3.readTemperature();
-    hum3 = dht3.readHumidity();
-    temp4 = dht4.readTemperature();
-    hum4 = dht4.readHumidity();
-    temp5 = dht5.readTemperature();
-    hum5 = dht5.readHumidity();
-
-    // Optional: Output sensor values for debugging
-    /*
-    Serial.printf("DHT Sensor Values:\n Temp1: %.2f, Hum1: %.2f\n Temp2: %.2f, Hum2: %.2f\n Temp3: %.2f, Hum3: %.2f\n Temp4: %.2f, Hum4: %.2f\n Temp5: %.2f, Hum5: %.2f\n",
-                  temp1, hum1, temp2, hum2, temp3, hum3, temp4, hum4, temp5, hum5);
-    */
+    float* temps[DHT_SENSOR_COUNT] = {&temp1, &temp2, &temp3, &temp4, &temp5};
+    float* hums[DHT_SENSOR_COUNT] = {&hum1, &hum2, &hum3, &hum4, &hum5};
+    unsigned long now = millis();
+
+    for (int i = 0; i < DHT_SENSOR_COUNT; i++) {
+        const DHTChannel &channel = channels[i];
+        bool valid = channel.hasValue && now - channel.lastValueTime <= DHT_MAX_AGE;
+        *temps[i] = valid ? channel.temperature : NAN;
+        *hums[i] = valid ? channel.humidity : NAN;
+    }
 }
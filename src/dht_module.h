@@ -1,15 +1,15 @@
 // Module: dht_module.h
 // Purpose: Declares functions and constants related to DHT sensors.
 // Definitions:
-// - DHT sensor pins and type definitions.
+// - DHT sensor pins, read interval and timing definitions.
 // Function Prototypes:
 // - setupDHT(): Initializes the DHT sensors.
+// - updateDHT(): Non-blocking acquisition step.
 // - readDHT(): Reads data from the DHT sensors.
 
 #ifndef DHT_MODULE_H
 #define DHT_MODULE_H
 
-#include <DHT.h>
 #include "config.h"
 
 // Define the pins for the DHT sensors
@@ -18,10 +18,16 @@
 #define DHTPIN_3 16
 #define DHTPIN_4 17
 #define DHTPIN_5 18
-#define DHTTYPE DHT22  // Sensor type
+#define DHT_SENSOR_COUNT 5
+
+#define DHT_READ_INTERVAL 2000      // DHT22 sensors need at least 2 s between reads
+#define DHT_START_TIME 1100         // Host start signal (in µs)
+#define DHT_CAPTURE_TIMEOUT 200     // A frame takes about 5 ms; give up after 200 ms
+#define DHT_MAX_AGE 10000           // Values older than this are reported as NAN
 
 // Function prototypes
 void setupDHT();
+void updateDHT();
 void readDHT(float &temp1, float &hum1, float &temp2, float &hum2, float &temp3, float &hum3, float &temp4, float &hum4, float &temp5, float &hum5);
 
 #endif
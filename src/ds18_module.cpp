@@ -1,10 +1,14 @@
 // Module: ds18_module.cpp
 // Purpose: Manages DS18B20 temperature sensors connected via a OneWire bus.
 // Functions:
-// - setupDS18(): Initializes DS18B20 sensors and sets up sensor address assignments.
+// - setupDS18(): Initializes DS18B20 sensors, sets up sensor address assignments and resolutions.
 // - assignDS18Sensors(): Maps predefined sensor IDs to sensor addresses.
 // - detectConnectedSensors(): Scans the OneWire bus to detect connected sensors.
-// - readDS18(): Requests temperature readings from DS18B20 sensors and stores them.
+// - updateDS18(): Non-blocking acquisition step; starts conversions and collects finished ones.
+// - readDS18(): Stores the last good temperature of each sensor; the acquisition is left to updateDS18().
+// - getDS18Age(): Returns the age of the last good value of a sensor.
+// - setDS18Resolution(): Changes the conversion resolution (9-12 bit) of a sensor.
+// - searchDS18(): Runs one step of a bus search for the device inventory.
 // - getDS18SensorInfo(): Retrieves and optionally outputs information about connected DS18B20 sensors.
 
 #include "ds18_module.h"
@@ -19,12 +23,46 @@ DeviceAddress connectedAddresses[10];
 int numAssignedSensors = 0;
 int numConnectedSensors = 0;
 
+// Acquisition state of a single DS18B20 sensor
+enum DS18State {
+    DS18_IDLE,
+    DS18_CONVERTING
+};
+
+struct DS18Channel {
+    uint8_t resolution;             // Configured resolution (9-12 bit)
+    bool resolutionPending;         // Resolution has to be written before the next conversion
+    DS18State state;                // Current acquisition state
+    unsigned long conversionStart;  // Time the last conversion was started
+    float lastValue;                // Last good temperature
+    unsigned long lastValueTime;    // Time the last good temperature was collected
+    bool hasValue;                  // True once a good temperature was collected
+};
+
+static DS18Channel channels[10] = {
+    {SENSOR6_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR7_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR8_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR9_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR10_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR11_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR12_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR13_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR14_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false},
+    {SENSOR15_RESOLUTION, true, DS18_IDLE, 0, NAN, 0, false}
+};
+
+// Parasite-powered sensors need the strong pull-up for the whole conversion,
+// so only one conversion may be in flight on such a bus
+static bool parasitePower = false;
+
 // Function to set up DS18B20 sensors
 void setupDS18() {
     sensors.begin();
     assignDS18Sensors();
     detectConnectedSensors();
-    sensors.setWaitForConversion(true);  // Wait for temperature conversion
+    parasitePower = sensors.isParasitePowerMode();
+    sensors.setWaitForConversion(false);  // Start conversions without waiting for them
 }
 
 // Function to assign sensor IDs to addresses
@@ -57,21 +95,103 @@ void detectConnectedSensors() {
     }
 }
 
-// Function to read temperatures from DS18B20 sensors
+// Function to change the resolution of a sensor; applied before its next conversion
+void setDS18Resolution(int index, uint8_t resolution) {
+    if (index < 0 || index >= 10) {
+        return;
+    }
+    channels[index].resolution = constrain(resolution, 9, 12);
+    channels[index].resolutionPending = true;
+}
+
+// Function to run one non-blocking acquisition step for all assigned sensors
+void updateDS18() {
+    unsigned long now = millis();
+    bool conversionInFlight = false;
+
+    // Collect all conversions whose resolution-dependent conversion time has passed
+    for (int i = 0; i < numAssignedSensors && i < 10; i++) {
+        DS18Channel &channel = channels[i];
+        if (channel.state != DS18_CONVERTING) {
+            continue;
+        }
+        if (now - channel.conversionStart < (unsigned long)sensors.millisToWaitForConversion(channel.resolution)) {
+            conversionInFlight = true;
+            continue;
+        }
+        float value = sensors.getTempC(assignedAddresses[i]);
+        if (value != DEVICE_DISCONNECTED_C) {
+            channel.lastValue = value;
+            channel.lastValueTime = now;
+            channel.hasValue = true;
+        }
+        channel.state = DS18_IDLE;
+    }
+
+    // Start new conversions for sensors whose read interval has elapsed
+    for (int i = 0; i < numAssignedSensors && i < 10; i++) {
+        DS18Channel &channel = channels[i];
+        if (channel.state != DS18_IDLE || !sensors.validAddress(assignedAddresses[i])) {
+            continue;
+        }
+        if (parasitePower && conversionInFlight) {
+            break;
+        }
+        if (channel.conversionStart != 0 && now - channel.conversionStart < DS18_READ_INTERVAL) {
+            continue;
+        }
+        if (channel.resolutionPending) {
+            sensors.setResolution(assignedAddresses[i], channel.resolution);
+            channel.resolutionPending = false;
+        }
+        if (sensors.requestTemperaturesByAddress(assignedAddresses[i])) {
+            channel.state = DS18_CONVERTING;
+            conversionInFlight = true;
+        }
+        channel.conversionStart = now;
+    }
+}
+
+// Function to get the age (in ms) of the last good value of a sensor
+unsigned long getDS18Age(int index) {
+    if (index < 0 || index >= 10 || !channels[index].hasValue) {
+        return DS18_AGE_UNKNOWN;
+    }
+    return millis() - channels[index].lastValueTime;
+}
+
+// Function to read temperatures from DS18B20 sensors; only copies the cached values, never touches the bus
 void readDS18(float temps[15]) {
-    sensors.requestTemperatures();
     for (int i = 0; i < 10; i++) {
-        if (i < numAssignedSensors && sensors.validAddress(assignedAddresses[i])) {
-            temps[i + 5] = sensors.getTempC(assignedAddresses[i]);
-            if (temps[i + 5] == DEVICE_DISCONNECTED_C) {
-                temps[i + 5] = NAN;
-            }
+        if (i < numAssignedSensors && getDS18Age(i) <= DS18_MAX_AGE) {
+            temps[i + 5] = channels[i].lastValue;
         } else {
             temps[i + 5] = NAN;
         }
     }
 }
 
+// Function to run one step of a OneWire bus search; returns 1 if a device was found, 0 at the end of
+// the search and -1 while a parasite-powered conversion needs the bus
+int searchDS18(uint8_t* address, bool restart) {
+    if (parasitePower) {
+        for (int i = 0; i < 10; i++) {
+            if (channels[i].state == DS18_CONVERTING) {
+                return -1;
+            }
+        }
+    }
+    if (restart) {
+        oneWire.reset_search();
+    }
+    while (oneWire.search(address)) {
+        if (OneWire::crc8(address, 7) == address[7]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // Function to output DS18B20 sensor information
 void getDS18SensorInfo() {
     for (int i = 0; i < numConnectedSensors; i++) {
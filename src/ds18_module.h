@@ -3,9 +3,14 @@
 // Definitions:
 // - ONE_WIRE_BUS: Pin where DS18B20 sensors are connected.
 // - SENSOR IDs: Predefined IDs for identifying specific DS18B20 sensors.
+// - SENSOR resolutions: Conversion resolution (9-12 bit) for each DS18B20 sensor.
 // Function Prototypes:
 // - setupDS18()
+// - updateDS18()
 // - readDS18()
+// - getDS18Age()
+// - setDS18Resolution()
+// - searchDS18()
 // - getDS18SensorInfo()
 // - assignDS18Sensors()
 // - detectConnectedSensors()
@@ -35,9 +40,29 @@
 #define SENSOR14_ID ""
 #define SENSOR15_ID ""
 
+// Define the conversion resolution of the DS18B20 sensors (9 bit: 94 ms ... 12 bit: 750 ms)
+#define SENSOR6_RESOLUTION 12
+#define SENSOR7_RESOLUTION 12
+#define SENSOR8_RESOLUTION 12
+#define SENSOR9_RESOLUTION 12
+#define SENSOR10_RESOLUTION 12
+#define SENSOR11_RESOLUTION 12
+#define SENSOR12_RESOLUTION 12
+#define SENSOR13_RESOLUTION 12
+#define SENSOR14_RESOLUTION 12
+#define SENSOR15_RESOLUTION 12
+
+#define DS18_READ_INTERVAL 1000  // Minimum time between two conversions of the same sensor (in ms)
+#define DS18_MAX_AGE 10000       // Values older than this are reported as NAN (in ms)
+#define DS18_AGE_UNKNOWN 0xFFFFFFFFUL // Age reported for sensors that never delivered a value
+
 // Function declarations
 void setupDS18();
+void updateDS18();
 void readDS18(float temps[15]);
+unsigned long getDS18Age(int index);
+void setDS18Resolution(int index, uint8_t resolution);
+int searchDS18(uint8_t* address, bool restart);
 void getDS18SensorInfo();
 void assignDS18Sensors();
 void detectConnectedSensors();
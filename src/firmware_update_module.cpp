@@ -1,72 +1,317 @@
 // Module: firmware_update_module.cpp
-// Purpose: Handles checking for and performing firmware updates from a specified URL.
+// Purpose: Downloads firmware images in the background and installs them once the SHA-256 of the received
+//          bytes matches the digest of the request. A dropped connection resumes at the last written
+//          byte with a Range request; the hash state is kept, so nothing is downloaded twice.
+//          Progress and result are published to firmware_update_status, e.g.
+//          {"state": "downloading", "received": 524288, "total": 1310720, "attempt": 2}.
 // Functions:
-// - checkForFirmwareUpdate(): Checks for firmware updates, handles HTTP redirects, and performs the update if a new firmware is available.
+// - requestFirmwareUpdate(): Validates a request and wakes the updater task; rejects it while an update runs.
+// - startUpdateTask(): Creates the updater task on the network core.
+// - parseSHA256(): Converts a 64-digit hex digest to bytes.
+// - parseContentRange(): Reads "bytes <start>-<end>/<total>".
 
 
 #include "firmware_update_module.h"
-#include "message_module.h" // For sending debug messages
+#include "message_module.h"
+#include "topic_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+#include "settings_module.h"
+#include <mbedtls/sha256.h>
 
-// Function to check and perform firmware updates
-void checkForFirmwareUpdate(const char* updateUrl, int redirectCount) {
-    if (redirectCount > 5) { // Prevent infinite redirect loops
-        sendMessage("Too many redirects. Aborting update.", "debug", 6);
+// Enumeration of the outcomes of one connection
+enum DownloadResult : uint8_t {
+    DOWNLOAD_COMPLETE,
+    DOWNLOAD_RETRY,     // Connection lost or server error; resume later
+    DOWNLOAD_FATAL      // The update cannot succeed
+};
+
+// Structure of the running update
+struct UpdateJob {
+    char url[UPDATE_URL_SIZE];
+    uint8_t expected[32];
+    mbedtls_sha256_context sha;
+    size_t received;                // Bytes written to the OTA partition and hashed
+    size_t total;                   // Image size, 0 until the first response
+    int attempt;
+    const char* error;
+};
+
+static UpdateJob job;
+static uint8_t chunk[UPDATE_CHUNK_SIZE];
+static TaskHandle_t updateTaskHandle = nullptr;
+static volatile bool updateBusy = false;
+static portMUX_TYPE updateMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long lastProgress = 0;
+
+// Names of the states in the status message
+static const char* const updateStateNames[] = {"idle", "downloading", "success", "failed"};
+
+// Function to convert a hex digest to bytes
+bool parseSHA256(const char* hex, uint8_t digest[32]) {
+    if (hex == nullptr || strlen(hex) != 64) {
+        return false;
+    }
+    for (int i = 0; i < 64; i++) {
+        char c = tolower(hex[i]);
+        int nibble = c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1);
+        if (nibble < 0) {
+            return false;
+        }
+        digest[i / 2] = (i % 2 == 0) ? nibble << 4 : digest[i / 2] | nibble;
+    }
+    return true;
+}
+
+// Function to parse a Content-Range header such as "bytes 1000-1999/2000"
+bool parseContentRange(const char* header, size_t &start, size_t &total) {
+    unsigned long first, last, length;
+    if (header == nullptr || sscanf(header, "bytes %lu-%lu/%lu", &first, &last, &length) != 3 ||
+        first > last || last >= length) {
+        return false;
+    }
+    start = first;
+    total = length;
+    return true;
+}
+
+// Function to publish the updater state; progress is rate limited unless forced
+static void reportUpdateStatus(UpdateState state, bool force) {
+    unsigned long now = millis();
+    if (!force && now - lastProgress < UPDATE_PROGRESS_INTERVAL) {
         return;
     }
+    lastProgress = now;
 
-    WiFiClient client;
-    HTTPClient http;
+    char payload[OUTBOX_PAYLOAD_SIZE];
+    if (state == UPDATE_FAILED) {
+        snprintf(payload, sizeof(payload), "{\"state\":\"failed\",\"error\":\"%s\",\"received\":%u}",
+                 job.error, (unsigned)job.received);
+    } else {
+        snprintf(payload, sizeof(payload), "{\"state\":\"%s\",\"received\":%u,\"total\":%u,\"attempt\":%d}",
+                 updateStateNames[state], (unsigned)job.received, (unsigned)job.total, job.attempt);
+    }
+    queueMessage(getOutboundTopic(TOPIC_UPDATE_STATUS), payload, true, OUTBOX_PRIORITY_STATE);
+}
 
-    sendMessage("Checking for firmware update...", "debug", 6);
+// Function to fail the update with a reason
+static DownloadResult failDownload(const char* error) {
+    job.error = error;
+    return DOWNLOAD_FATAL;
+}
 
-    if (http.begin(client, updateUrl)) {
-        http.addHeader("User-Agent", "ESP32-HeaterController/1.0"); // Required for GitHub URLs
-        int httpCode = http.GET();
-        if (httpCode == HTTP_CODE_OK) {
-            int contentLength = http.getSize();
+// Function to accept the first full response and open the OTA partition
+static DownloadResult beginImage(HTTPClient &http) {
+    if (job.received > 0) {
+        // The server ignored the Range header; start over with a fresh partition and hash
+        LOG_WARN(LOG_MODULE_UPDATE, "Server does not support resuming, restarting at 0 of %u bytes", (unsigned)job.total);
+        mbedtls_sha256_starts_ret(&job.sha, 0);
+        job.received = 0;
+    }
+    if (Update.isRunning()) {
+        // An earlier attempt opened the partition, possibly without writing to it; Update.begin() refuses a second start
+        Update.abort();
+    }
 
-            if (contentLength > 0 && Update.begin(contentLength)) {
-                sendMessage("Starting firmware update...", "debug", 6);
+    int size = http.getSize();
+    if (size <= 0) {
+        return failDownload("missing content length");
+    }
+    if (job.total != 0 && (size_t)size != job.total) {
+        return failDownload("image size changed");
+    }
+    if (!Update.begin(size)) {
+        return failDownload("image does not fit the partition");
+    }
+    job.total = size;
+    return DOWNLOAD_COMPLETE;
+}
 
-                WiFiClient* stream = http.getStreamPtr();
-                size_t written = Update.writeStream(*stream);
+// Function to run one connection: request the missing bytes and stream them into the partition
+static DownloadResult downloadImage() {
+    WiFiClient plainClient;
+    WiFiClientSecure secureClient;
+    bool secure = strncmp(job.url, "https://", 8) == 0;
+    if (secure) {
+        // The server is not authenticated; the image is, by the digest of the request
+        secureClient.setInsecure();
+    }
 
-                if (written == contentLength && Update.end()) {
-                    sendMessage("Update successful. Restarting...", "debug", 6);
-                    ESP.restart();
-                } else {
-                    sendMessage("Update failed: " + String(Update.getError()), "debug", 6);
-                }
-            } else {
-                sendMessage("Not enough space for update or invalid content length.", "debug", 6);
-            }
-        } else if (httpCode == HTTP_CODE_FOUND || httpCode == HTTP_CODE_MOVED_PERMANENTLY || httpCode == HTTP_CODE_SEE_OTHER) {
-            // Handle HTTP 302, 301, 303 redirects
-            String newUrl = http.header("Location");
-
-            if (newUrl.length() > 0) {
-                sendMessage("Redirected to: " + newUrl, "debug", 6);
-                http.end(); // Close the current connection
-                checkForFirmwareUpdate(newUrl.c_str(), redirectCount + 1); // Retry with the new URL
-            } else {
-                sendMessage("Redirection failed: Empty Location header. Attempting fallback.", "debug", 6);
-
-                // Attempt a fallback solution for GitHub URLs
-                if (String(updateUrl).startsWith("https://github.com/")) {
-                    String fallbackUrl = String(updateUrl) + "?access=direct";
-                    sendMessage("Fallback to: " + fallbackUrl, "debug", 6);
-                    http.end();
-                    checkForFirmwareUpdate(fallbackUrl.c_str(), redirectCount + 1);
-                } else {
-                    sendMessage("No fallback method available for this URL.", "debug", 6);
-                }
+    HTTPClient http;
+    static const char* collectedHeaders[] = {"Content-Range"};
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    http.setRedirectLimit(UPDATE_MAX_REDIRECTS);
+    http.setTimeout(UPDATE_READ_TIMEOUT);
+    http.setUserAgent("ESP32-HeaterController/1.0"); // Required for GitHub URLs
+    if (!http.begin(secure ? (WiFiClient&)secureClient : plainClient, job.url)) {
+        return failDownload("invalid URL");
+    }
+    http.collectHeaders(collectedHeaders, 1);
+
+    char range[32];
+    if (job.received > 0) {
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)job.received);
+        http.addHeader("Range", range);
+    }
+
+    int httpCode = http.GET();
+    DownloadResult result = DOWNLOAD_COMPLETE;
+    if (httpCode == HTTP_CODE_PARTIAL_CONTENT && job.received > 0) {
+        size_t start, total;
+        if (!parseContentRange(http.header("Content-Range").c_str(), start, total) || start != job.received) {
+            result = failDownload("invalid Content-Range");
+        } else if (total != job.total) {
+            result = failDownload("image size changed");
+        }
+    } else if (httpCode == HTTP_CODE_OK) {
+        result = beginImage(http);
+    } else {
+        LOG_WARN(LOG_MODULE_UPDATE, "Firmware download failed: HTTP code %d", httpCode);
+        // Connection errors (negative codes) and server errors are worth another attempt
+        result = (httpCode < 0 || httpCode >= 500) ? DOWNLOAD_RETRY : failDownload("HTTP error");
+    }
+    if (result != DOWNLOAD_COMPLETE) {
+        http.end();
+        return result;
+    }
+
+    WiFiClient* stream = http.getStreamPtr();
+    unsigned long lastData = millis();
+    while (job.received < job.total) {
+        size_t available = stream->available();
+        if (available == 0) {
+            if (!stream->connected() || millis() - lastData > UPDATE_READ_TIMEOUT) {
+                LOG_WARN(LOG_MODULE_UPDATE, "Firmware download interrupted at %u of %u bytes",
+                         (unsigned)job.received, (unsigned)job.total);
+                http.end();
+                return DOWNLOAD_RETRY;
             }
-        } else {
-            sendMessage("Failed to fetch firmware: HTTP Code " + String(httpCode), "debug", 6);
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
         }
 
-        http.end();
-    } else {
-        sendMessage("Failed to connect to update server.", "debug", 6);
+        size_t wanted = min(min(available, sizeof(chunk)), job.total - job.received);
+        int length = stream->readBytes(chunk, wanted);
+        if (length <= 0) {
+            continue;
+        }
+        mbedtls_sha256_update_ret(&job.sha, chunk, length);
+        if (Update.write(chunk, length) != (size_t)length) {
+            http.end();
+            return failDownload("flash write failed");
+        }
+        job.received += length;
+        job.attempt = 1; // Progress resets the attempt count; slow links may need many connections
+        lastData = millis();
+        reportUpdateStatus(UPDATE_DOWNLOADING, false);
+    }
+
+    http.end();
+    return DOWNLOAD_COMPLETE;
+}
+
+// Function to check the digest and activate the new image
+static bool finishImage() {
+    uint8_t digest[32];
+    mbedtls_sha256_finish_ret(&job.sha, digest);
+    if (memcmp(digest, job.expected, sizeof(digest)) != 0) {
+        job.error = "sha256 mismatch";
+        return false;
     }
+    if (!Update.end()) {
+        job.error = "image rejected";
+        LOG_ERROR(LOG_MODULE_UPDATE, "Update error %d", Update.getError());
+        return false;
+    }
+    return true;
+}
+
+// Function to run a queued update from start to end
+static void performUpdate() {
+    mbedtls_sha256_init(&job.sha);
+    mbedtls_sha256_starts_ret(&job.sha, 0);
+    job.received = 0;
+    job.total = 0;
+    job.error = nullptr;
+
+    LOG_INFO(LOG_MODULE_UPDATE, "Firmware update from %s", job.url);
+    DownloadResult result = DOWNLOAD_RETRY;
+    for (job.attempt = 1; job.attempt <= UPDATE_MAX_ATTEMPTS; job.attempt++) {
+        reportUpdateStatus(UPDATE_DOWNLOADING, true);
+        result = downloadImage();
+        if (result != DOWNLOAD_RETRY) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(UPDATE_RETRY_DELAY));
+    }
+    if (result == DOWNLOAD_RETRY) {
+        job.error = "too many attempts";
+    }
+
+    bool success = result == DOWNLOAD_COMPLETE && finishImage();
+    mbedtls_sha256_free(&job.sha);
+    if (!success) {
+        if (Update.isRunning()) {
+            Update.abort();
+        }
+        LOG_ERROR(LOG_MODULE_UPDATE, "Firmware update failed: %s", job.error);
+        reportUpdateStatus(UPDATE_FAILED, true);
+        return;
+    }
+
+    LOG_INFO(LOG_MODULE_UPDATE, "Firmware update verified (%u bytes), restarting", (unsigned)job.total);
+    reportUpdateStatus(UPDATE_SUCCESS, true);
+    requestSettingsFlush();
+    vTaskDelay(pdMS_TO_TICKS(3000)); // Let the network task send the result and write pending settings
+    ESP.restart();
+}
+
+// Task body: wait for a request, then run it
+static void runUpdateTask(void* parameter) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        performUpdate();
+        updateBusy = false;
+    }
+}
+
+// Function to queue an update; returns false if the request is invalid or an update is running
+bool requestFirmwareUpdate(const char* url, const char* sha256) {
+    uint8_t digest[32];
+    if (strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) {
+        LOG_WARN(LOG_MODULE_UPDATE, "Invalid firmware update URL, expected http:// or https://");
+        return false;
+    }
+    if (strlen(url) >= UPDATE_URL_SIZE) {
+        LOG_WARN(LOG_MODULE_UPDATE, "Firmware update URL longer than %d characters", UPDATE_URL_SIZE - 1);
+        return false;
+    }
+    if (!parseSHA256(sha256, digest)) {
+        LOG_WARN(LOG_MODULE_UPDATE, "Firmware update needs a sha256 of 64 hex digits");
+        return false;
+    }
+    if (updateTaskHandle == nullptr) {
+        LOG_ERROR(LOG_MODULE_UPDATE, "Updater task not running");
+        return false;
+    }
+
+    portENTER_CRITICAL(&updateMux);
+    bool busy = updateBusy;
+    updateBusy = true;
+    portEXIT_CRITICAL(&updateMux);
+    if (busy) {
+        LOG_WARN(LOG_MODULE_UPDATE, "Firmware update already running, request ignored");
+        return false;
+    }
+
+    strcpy(job.url, url);
+    memcpy(job.expected, digest, sizeof(digest));
+    xTaskNotifyGive(updateTaskHandle);
+    return true;
+}
+
+// Function to start the updater task on the network core
+void startUpdateTask() {
+    xTaskCreatePinnedToCore(runUpdateTask, "update", UPDATE_TASK_STACK, nullptr, UPDATE_TASK_PRIORITY,
+                            &updateTaskHandle, NETWORK_TASK_CORE);
 }
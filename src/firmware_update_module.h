@@ -1,7 +1,23 @@
 // Module: firmware_update_module.h
-// Purpose: Declares the function for firmware updates.
+// Purpose: Declares the background firmware updater. Requests only queue the job; a dedicated task on the
+//          network core streams the image into the OTA partition, hashes it on the fly and resumes
+//          interrupted downloads with HTTP Range requests.
+// Definitions:
+// - UPDATE_TASK_STACK, UPDATE_TASK_PRIORITY: Updater task configuration.
+// - UPDATE_CHUNK_SIZE: Bytes read and written per step.
+// - UPDATE_URL_SIZE: Longest accepted URL.
+// - UPDATE_MAX_REDIRECTS: Redirects followed per request.
+// - UPDATE_MAX_ATTEMPTS: Consecutive connections without progress before the update fails.
+// - UPDATE_RETRY_DELAY: Pause before resuming an interrupted download.
+// - UPDATE_READ_TIMEOUT: Time without data after which the connection is dropped and resumed.
+// - UPDATE_PROGRESS_INTERVAL: Minimum time between progress messages.
+// Enumerations:
+// - UpdateState: State reported on the firmware_update_status topic.
 // Function Prototypes:
-// - checkForFirmwareUpdate(): Initiates the firmware update process.
+// - requestFirmwareUpdate(): Queues an update from a URL with the expected SHA-256 (any task).
+// - startUpdateTask(): Creates the updater task.
+// - parseSHA256(): Converts a hex digest to bytes.
+// - parseContentRange(): Reads the start and total length from a Content-Range header.
 
 
 #ifndef FIRMWARE_UPDATE_MODULE_H
@@ -11,7 +27,28 @@
 #include <HTTPClient.h>
 #include <Update.h>
 
-// Function to check for firmware updates
-void checkForFirmwareUpdate(const char* updateUrl, int redirectCount = 0);
+#define UPDATE_TASK_STACK 10240         // The TLS handshake alone needs about 6 KB
+#define UPDATE_TASK_PRIORITY 1          // Same as the network task, so both get time slices
+#define UPDATE_CHUNK_SIZE 4096          // One flash sector
+#define UPDATE_URL_SIZE 256
+#define UPDATE_MAX_REDIRECTS 5
+#define UPDATE_MAX_ATTEMPTS 10
+#define UPDATE_RETRY_DELAY 5000         // (in ms)
+#define UPDATE_READ_TIMEOUT 15000       // (in ms)
+#define UPDATE_PROGRESS_INTERVAL 2000   // (in ms)
+
+// Enumeration of the updater states
+enum UpdateState : uint8_t {
+    UPDATE_IDLE,
+    UPDATE_DOWNLOADING,
+    UPDATE_SUCCESS,     // Image verified and activated, restarting
+    UPDATE_FAILED
+};
+
+// Function prototypes
+bool requestFirmwareUpdate(const char* url, const char* sha256);
+void startUpdateTask();
+bool parseSHA256(const char* hex, uint8_t digest[32]);
+bool parseContentRange(const char* header, size_t &start, size_t &total);
 
 #endif
@@ -1,22 +1,60 @@
 // Module: gpio_module.cpp
 // Purpose: Manages General Purpose Input/Output (GPIO) pins related to the heater's status and control.
 // Functions:
-// - setupGPIO(): Configures GPIO pins for reading heater status and controlling the heater.
-// - readHeaterStatus(): Reads the current status of the heater from a GPIO pin.
-// - toggleHeater(): Toggles the heater on or off based on the specified control mode.
+// - setupGPIO(): Configures GPIO pins for reading heater status and controlling the heater, and creates the pulse timer.
+// - readHeaterStatus(): Reads the current status of the heater from a GPIO pin; a change clears a heater fault.
+// - toggleHeater(): Turns the heater on or off based on the specified control mode; never blocks. No pulses are
+//   sent while a heater fault is set.
+// - clearHeaterFault(): Clears the fault on an explicit command, so the next toggleHeater() pulses again.
+// - processHeaterToggle(): Verifies a finished toggle pulse on the status pin, raises a fault if it does not follow.
 
 
 #include "gpio_module.h"
+#include "log_module.h"
+#include <esp_timer.h>
 
 // Global variables for heater status and control mode
 bool heaterStatus = false;
 HeaterControlMode heaterControlMode = TOGGLE;
+bool heaterFault = false;
+
+// State of the asynchronous toggle pulse
+static volatile HeaterToggleState toggleState = TOGGLE_IDLE;
+static bool requestedState = false;       // Latest requested heater state (commands are coalesced)
+static bool pulseTarget = false;          // Heater state the current pulse should lead to
+static bool commandPending = false;       // A request has not been fulfilled yet
+static unsigned long verifyStart = 0;     // Time the current pulse ended
+static volatile bool pulseEnded = false;  // Set by the pulse timer
+static esp_timer_handle_t pulseTimer = nullptr;
+
+// Timer callback: end the toggle pulse
+static void endTogglePulse(void* arg) {
+    digitalWrite(HEATER_TOGGLE_PIN, LOW);
+    pulseEnded = true;
+}
+
+// Function to start a toggle pulse towards the given heater state
+static void startTogglePulse(bool target) {
+    pulseTarget = target;
+    pulseEnded = false;
+    toggleState = TOGGLE_PULSE;
+    digitalWrite(HEATER_TOGGLE_PIN, HIGH);
+    esp_timer_start_once(pulseTimer, HEATER_TOGGLE_PULSE * 1000ULL);
+}
 
 // Function to set up GPIO pins
 void setupGPIO() {
     pinMode(HEATER_STATUS_PIN, INPUT);    // Set heater status pin as input
     pinMode(HEATER_TOGGLE_PIN, OUTPUT);   // Set heater toggle pin as output
     digitalWrite(HEATER_TOGGLE_PIN, LOW); // Initialize toggle pin to LOW
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &endTogglePulse,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "heater_pulse"
+    };
+    esp_timer_create(&timerArgs, &pulseTimer);
 }
 
 // Function to read the current heater status
@@ -24,6 +62,11 @@ void readHeaterStatus() {
     bool currentStatus = digitalRead(HEATER_STATUS_PIN);
     if (currentStatus != heaterStatus) {
         heaterStatus = currentStatus; // Update global heater status
+        if (heaterFault && toggleState == TOGGLE_IDLE) {
+            // The heater responds again, e.g. switched by hand or late after the last pulse
+            heaterFault = false;
+            LOG_INFO(LOG_MODULE_HEATER, "Heater status changed, fault cleared");
+        }
     }
 }
 
@@ -33,9 +76,67 @@ void toggleHeater(bool state) {
         // Directly set the output state
         digitalWrite(HEATER_TOGGLE_PIN, state ? HIGH : LOW);
     } else if (heaterControlMode == TOGGLE) {
-        // Toggle the heater state
-        digitalWrite(HEATER_TOGGLE_PIN, HIGH);
-        delay(500);  // Hold the toggle for 0.5 seconds
-        digitalWrite(HEATER_TOGGLE_PIN, LOW);
+        if (heaterFault) {
+            return; // A heater that ignored a pulse gets no more until the fault is cleared
+        }
+        // Only the latest request counts; a pulse in flight is never queued behind
+        requestedState = state;
+        commandPending = true;
+        if (toggleState == TOGGLE_IDLE) {
+            readHeaterStatus();
+            if (heaterStatus == state) {
+                commandPending = false; // Already in the requested state
+                return;
+            }
+            startTogglePulse(state);
+        }
+    }
+}
+
+// Function to clear a heater fault; called for explicit toggle commands, not for automation requests
+void clearHeaterFault() {
+    if (heaterFault) {
+        heaterFault = false;
+        LOG_INFO(LOG_MODULE_HEATER, "Heater fault cleared by command");
+    }
+}
+
+// Function to verify toggle pulses; called periodically
+void processHeaterToggle() {
+    if (toggleState == TOGGLE_PULSE) {
+        if (!pulseEnded) {
+            return;
+        }
+        verifyStart = millis();
+        toggleState = TOGGLE_VERIFY;
+    }
+
+    if (toggleState == TOGGLE_VERIFY) {
+        readHeaterStatus();
+        if (heaterStatus == pulseTarget) {
+            // Transition confirmed
+            toggleState = TOGGLE_IDLE;
+            heaterFault = false;
+        } else if (millis() - verifyStart >= HEATER_VERIFY_TIMEOUT) {
+            // No retry pulse: a TOGGLE input flips on every pulse, so a second one would switch a heater that is
+            // only slow back off. The fault holds further pulses until the status pin changes or a command clears it
+            toggleState = TOGGLE_IDLE;
+            commandPending = false;
+            heaterFault = true;
+            LOG_ERROR(LOG_MODULE_HEATER, "Heater did not follow toggle pulse, fault raised");
+            return;
+        } else {
+            return;
+        }
+    }
+
+    // Idle: issue a pulse for a request that arrived while the previous one was in flight
+    if (toggleState == TOGGLE_IDLE && commandPending) {
+        readHeaterStatus();
+        if (heaterStatus != requestedState) {
+            startTogglePulse(requestedState);
+        } else {
+            commandPending = false;
+        }
     }
 }
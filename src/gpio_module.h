@@ -2,15 +2,22 @@
 // Purpose: Declares GPIO-related functions and variables for heater control.
 // Definitions:
 // - HEATER_STATUS_PIN, HEATER_TOGGLE_PIN: GPIO pins for heater status and control.
+// - HEATER_TOGGLE_PULSE, HEATER_VERIFY_TIMEOUT: Timing of the toggle pulse and its verification.
+//   HEATER_VERIFY_TIMEOUT must cover the start-up time of the heater, or a slow start raises a fault.
 // Enumerations:
 // - HeaterControlMode: Defines control modes such as TOGGLE and SWITCH.
+// - HeaterToggleState: States of the asynchronous toggle pulse.
 // External Variables:
 // - heaterStatus: Indicates the current status of the heater.
 // - heaterControlMode: Defines the control mode for the heater.
+// - heaterFault: Set when the heater did not follow a toggle pulse within HEATER_VERIFY_TIMEOUT; published with the telemetry.
+//   It stays set, and no pulses are sent, until an explicit toggle command or a change of the status pin clears it.
 // Function Prototypes:
 // - setupGPIO()
 // - readHeaterStatus()
 // - toggleHeater()
+// - clearHeaterFault()
+// - processHeaterToggle()
 
 
 #ifndef GPIO_MODULE_H
@@ -22,19 +29,33 @@
 #define HEATER_STATUS_PIN 38 // Pin to read heater status
 #define HEATER_TOGGLE_PIN 42 // Pin to control heater toggle
 
+// Toggle pulse timing
+#define HEATER_TOGGLE_PULSE 500      // Length of the toggle pulse (in ms)
+#define HEATER_VERIFY_TIMEOUT 10000  // Time for the status pin to follow a pulse, including heater start-up (in ms)
+
 // Enumeration for heater control modes
 enum HeaterControlMode {
     TOGGLE,
     SWITCH
 };
 
+// Enumeration for the states of the asynchronous toggle pulse
+enum HeaterToggleState {
+    TOGGLE_IDLE,    // No pulse in flight
+    TOGGLE_PULSE,   // Toggle pin is held high
+    TOGGLE_VERIFY   // Waiting for the status pin to confirm the transition
+};
+
 // External variables for heater status and control mode
 extern bool heaterStatus;
 extern HeaterControlMode heaterControlMode;
+extern bool heaterFault;
 
 // Function prototypes
 void setupGPIO();
 void readHeaterStatus();
 void toggleHeater(bool state);
+void clearHeaterFault();
+void processHeaterToggle();
 
 #endif
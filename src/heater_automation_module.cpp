@@ -4,23 +4,27 @@
 // - isAutomationActive(): Returns the status of the automation system.
 // - controlExternalHeater(): Controls the external heater (turns it on or off).
 // - controlHeaterBasedOnZones(): Determines whether to activate or deactivate the heater based on temperature readings and hysteresis thresholds.
-// - controlServoValvesBasedOnZones(): Adjusts servo-controlled valves in each zone based on temperature targets and whether the heater is active.
+// - controlServoValvesBasedOnZones(): Adjusts servo-controlled valves in each zone based on temperature targets and whether the heater is active (on/off mode; the PID task handles proportional mode).
 
 
 #include "heater_automation_module.h"
 #include "gpio_module.h"
 #include "temperature_module.h"
 #include "servo_control_module.h"
+#include "zone_descriptors.h"
 #include <Arduino.h>
 
-// External declarations for heater status and zones
+// External declaration for heater status
 extern bool heaterStatus;
-extern Zone zones[NUM_ZONES];
 
 // Global variables for automation status and valve mode
 bool automationActive = false;          // Indicates if automation is active
 bool valveModeProportional = false;     // Default to proportional mode (true for proportional, false for on/off)
 
+// Hysteresis thresholds in the centi-degrees of the zone control state
+static constexpr int16_t hysteresisOver = toCentiDegrees(HYSTERESIS_OVER);
+static constexpr int16_t hysteresisUnder = toCentiDegrees(HYSTERESIS_UNDER);
+
 // Function to check if automation is active
 bool isAutomationActive() {
     return automationActive;
@@ -42,22 +46,22 @@ void controlHeaterBasedOnZones() {
     bool shouldTurnOnHeater = false;
     bool shouldTurnOffHeater = true;
 
-    for (int i = 0; i < NUM_ZONES; i++) {
-        // Check if the zone is valid and has temperature data
-        if (strlen(zones[i].name) > 0 && !isnan(zones[i].temperature) && !isnan(zones[i].temperatureTarget)) {
-            float lowerThreshold = zones[i].temperatureTarget - HYSTERESIS_UNDER;
-            float upperThreshold = zones[i].temperatureTarget + HYSTERESIS_OVER;
+    // Walk the zones that have both a temperature and a target
+    uint16_t ready = zoneState.temperatureValid & zoneState.targetValid & ACTIVE_ZONE_MASK;
+    for (; ready != 0; ready &= ready - 1) {
+        int i = __builtin_ctz(ready);
+        int temperature = zoneState.temperature[i];
+        int target = zoneState.target[i];
 
-            if (heaterStatus) {
-                // If the heater is on, check if any zone is below the upper threshold
-                if (zones[i].temperature < upperThreshold) {
-                    shouldTurnOffHeater = false;
-                }
-            } else {
-                // If the heater is off, check if any zone is below the lower threshold
-                if (zones[i].temperature < lowerThreshold) {
-                    shouldTurnOnHeater = true;
-                }
+        if (heaterStatus) {
+            // If the heater is on, check if any zone is below the upper threshold
+            if (temperature < target + hysteresisOver) {
+                shouldTurnOffHeater = false;
+            }
+        } else {
+            // If the heater is off, check if any zone is below the lower threshold
+            if (temperature < target - hysteresisUnder) {
+                shouldTurnOnHeater = true;
             }
         }
     }
@@ -74,37 +78,29 @@ void controlHeaterBasedOnZones() {
 void controlServoValvesBasedOnZones() {
     // If the heater is off, open all servos fully
     if (!heaterStatus) {
-        for (int i = 0; i < NUM_ZONES; i++) {
-            if (strlen(zones[i].name) > 0 && zones[i].servoValve > 0) {
-                setServoPosition(i, 100); // Fully open
-            }
+        for (uint8_t i : valveZones) {
+            setServoPosition(i, 100); // Fully open
         }
         return;
     }
-    for (int i = 0; i < NUM_ZONES; i++) {
-        if (strlen(zones[i].name) > 0 && zones[i].servoValve > 0) {
-            if (!isnan(zones[i].temperature) && !isnan(zones[i].temperatureTarget)) {
-                int anglePercentage = 0;
-                float lowerThreshold = zones[i].temperatureTarget - HYSTERESIS_UNDER;
-                float upperThreshold = zones[i].temperatureTarget + HYSTERESIS_OVER;
-
-                if (valveModeProportional) {
-                    // Proportional mode: Open the valve proportionally to the difference between current and target temperature
-                    if (zones[i].temperature < zones[i].temperatureTarget) {
-                        float difference = zones[i].temperatureTarget - zones[i].temperature;
-                        anglePercentage = min(100, (int)(difference * 10)); // Max 100%
-                    }
-                } else {
-                    // On/Off mode: Open or close the valve based on hysteresis thresholds
-                    if (zones[i].temperature < lowerThreshold) {
-                        anglePercentage = 100; // Fully open
-                    } else if (zones[i].temperature > upperThreshold) {
-                        anglePercentage = 0; // Fully closed
-                    }
-                }
+    // Proportional mode: the PID task sets the valves on its own fixed period
+    if (valveModeProportional) {
+        return;
+    }
+    uint16_t ready = zoneState.temperatureValid & zoneState.targetValid & VALVE_ZONE_MASK;
+    for (; ready != 0; ready &= ready - 1) {
+        int i = __builtin_ctz(ready);
+        int temperature = zoneState.temperature[i];
+        int target = zoneState.target[i];
+        int anglePercentage = 0;
 
-                setServoPosition(i, anglePercentage);
-            }
+        // On/Off mode: Open or close the valve based on hysteresis thresholds
+        if (temperature < target - hysteresisUnder) {
+            anglePercentage = 100; // Fully open
+        } else if (temperature > target + hysteresisOver) {
+            anglePercentage = 0; // Fully closed
         }
+
+        setServoPosition(i, anglePercentage);
     }
 }
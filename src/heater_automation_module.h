@@ -2,7 +2,7 @@
 // Purpose: Declares functions and variables for heater automation control.
 // External Variables:
 // - automationActive: Indicates whether automation is active.
-// - valveModeProportional: Determines if valve control is proportional or on/off.
+// - valveModeProportional: Determines if valves are set by the PID task or on/off.
 // Function Prototypes:
 // - isAutomationActive()
 // - controlExternalHeater()
@@ -17,7 +17,7 @@
 
 // External variables indicating automation status and valve mode
 extern bool automationActive;
-extern bool valveModeProportional; // True: proportional control, False: on/off control
+extern bool valveModeProportional; // True: PID control (pid_module), False: on/off control
 
 // Function prototypes
 bool isAutomationActive();
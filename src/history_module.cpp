@@ -0,0 +1,312 @@
+// Module: history_module.cpp
+// Purpose: Records the zone values once per HISTORY_INTERVAL into delta-encoded block rings and answers
+//          history requests with one chunk per block, a few chunks per call, so a backfill of 48 hours
+//          does not flood the broker or stall the network task. Runs entirely on the network task.
+// Functions:
+// - setupHistory(): Allocates the blocks in PSRAM (internal RAM with fewer blocks as a fallback).
+// - updateHistory(): Records a sample of every series when one is due and publishes pending chunks.
+// - requestHistory(): Parses {"id": 7, "zone": "Cabin", "metric": "temperature", "from": 1700000000, "to": 1700086400};
+//   all keys except "from" are optional. Chunks are published to history_response as
+//   {"id": 7, "zone": "Cabin", "metric": "temperature", "start": 1700000000, "interval": 60, "values": [20.1, null, ...]},
+//   followed by {"id": 7, "done": true, "chunks": 12}.
+
+
+#include "history_module.h"
+#include "tasks_module.h"
+#include "message_module.h"
+#include "topic_module.h"
+#include "log_module.h"
+#include "zone_descriptors.h"
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <time.h>
+
+// Names of the metrics in requests and responses
+static const char* const metricNames[HISTORY_METRIC_COUNT] = {
+    "temperature", "humidity", "target_temperature", "valve_position"
+};
+
+// Structure of the request being answered
+struct HistoryQuery {
+    bool active;
+    int32_t id;
+    int zone;               // -1: all zones
+    int metric;             // -1: all metrics
+    uint32_t from;
+    uint32_t to;
+    int series;             // Series being sent
+    uint32_t block;         // Next block of that series
+    uint16_t chunks;        // Chunks sent so far
+};
+
+static HistorySeries series[NUM_ZONES * HISTORY_METRIC_COUNT];
+static int seriesCount = 0;
+static uint32_t blocksPerSeries = 0;
+static uint32_t nextSample = 0;
+static HistoryQuery query;
+static char chunkBuffer[HISTORY_CHUNK_BUFFER];
+
+// Function to allocate the series of all configured zones; runs before the network task starts
+bool setupHistory() {
+    int count = ACTIVE_ZONE_COUNT * HISTORY_METRIC_COUNT;
+
+    blocksPerSeries = HISTORY_BLOCKS;
+    HistoryBlock* blocks = (HistoryBlock*)heap_caps_calloc(count * blocksPerSeries, sizeof(HistoryBlock), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (blocks == nullptr) {
+        blocksPerSeries = HISTORY_FALLBACK_BLOCKS;
+        blocks = (HistoryBlock*)heap_caps_calloc(count * blocksPerSeries, sizeof(HistoryBlock), MALLOC_CAP_8BIT);
+        LOG_WARN(LOG_MODULE_MQTT, "No PSRAM for the history, keeping %d blocks per series", (int)blocksPerSeries);
+    }
+    if (blocks == nullptr) {
+        LOG_ERROR(LOG_MODULE_MQTT, "History not available");
+        return false;
+    }
+
+    for (uint8_t i : activeZones) {
+        for (int m = 0; m < HISTORY_METRIC_COUNT; m++) {
+            series[seriesCount] = {(uint8_t)i, (HistoryMetric)m, 0, blocks};
+            blocks += blocksPerSeries;
+            seriesCount++;
+        }
+    }
+    LOG_INFO(LOG_MODULE_MQTT, "History: %d series, %d bytes", seriesCount, (int)(count * blocksPerSeries * sizeof(HistoryBlock)));
+    return true;
+}
+
+// Function to write a sample code as a varint; returns false if the block is full
+static bool writeCode(HistoryBlock &block, uint32_t code) {
+    uint8_t bytes[3];
+    int length = 0;
+    do {
+        bytes[length++] = (code & 0x7F) | (code > 0x7F ? 0x80 : 0);
+        code >>= 7;
+    } while (code > 0 && length < 3);
+    if (block.used + length > sizeof(block.data)) {
+        return false;
+    }
+    memcpy(block.data + block.used, bytes, length);
+    block.used += length;
+    return true;
+}
+
+// Function to read a sample code; returns the position after it
+static size_t readCode(const HistoryBlock &block, size_t position, uint32_t &code) {
+    code = 0;
+    for (int shift = 0; position < block.used && shift < 21; shift += 7) {
+        uint8_t byte = block.data[position++];
+        code |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return position;
+}
+
+// Function to append a sample to a series
+static void recordSample(HistorySeries &s, uint32_t time, float value) {
+    uint32_t code = 0;
+    int16_t quantized = 0;
+    if (!isnan(value)) {
+        quantized = (int16_t)constrain(lroundf(value * HISTORY_SCALE), -32767L, 32767L);
+    }
+
+    HistoryBlock* block = s.blockCount > 0 ? &s.blocks[(s.blockCount - 1) % blocksPerSeries] : nullptr;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // A block only holds consecutive samples; a gap or a full block starts a new one
+        if (block == nullptr || time != block->start + block->count * HISTORY_INTERVAL) {
+            block = &s.blocks[s.blockCount % blocksPerSeries];
+            s.blockCount++;
+            *block = {time, 0, 0, 0, 0};
+        }
+        if (!isnan(value)) {
+            int32_t delta = quantized - block->last;
+            code = ((uint32_t)(delta << 1) ^ (uint32_t)(delta >> 31)) + 1;
+        }
+        if (writeCode(*block, code)) {
+            block->count++;
+            if (!isnan(value)) {
+                block->last = quantized;
+            }
+            return;
+        }
+        block = nullptr;
+    }
+}
+
+// Function to record a sample of every series from the latest telemetry
+static void recordHistory(uint32_t time) {
+    bool fresh = hasTelemetry() && millis() - receiveTelemetry().timestamp <= HISTORY_MAX_AGE;
+    const Telemetry &telemetry = receiveTelemetry();
+
+    for (int i = 0; i < seriesCount; i++) {
+        float value = NAN;
+        if (fresh) {
+            const ZoneTelemetry &zone = telemetry.zones[series[i].zone];
+            switch (series[i].metric) {
+                case HISTORY_TEMPERATURE: value = zone.temperature; break;
+                case HISTORY_HUMIDITY: value = zone.humidity; break;
+                case HISTORY_TARGET_TEMPERATURE: value = zone.temperatureTarget; break;
+                case HISTORY_VALVE_POSITION: value = zone.valvePosition >= 0 ? zone.valvePosition : NAN; break;
+                default: break;
+            }
+        }
+        recordSample(series[i], time, value);
+    }
+}
+
+// Function to check whether a series is part of the query
+static bool matchesQuery(const HistorySeries &s) {
+    return (query.zone < 0 || s.zone == query.zone) && (query.metric < 0 || s.metric == query.metric);
+}
+
+// Function to serialize the samples of a block within the query range; returns the length or 0 if none
+static size_t buildChunk(const HistorySeries &s, const HistoryBlock &block) {
+    size_t length = 0;
+    size_t position = 0;
+    int32_t value = 0;
+    bool first = true;
+
+    for (uint16_t n = 0; n < block.count; n++) {
+        uint32_t code;
+        position = readCode(block, position, code);
+        bool missing = code == 0;
+        if (!missing) {
+            code--;
+            value += (int32_t)(code >> 1) ^ -(int32_t)(code & 1);
+        }
+
+        uint32_t time = block.start + n * HISTORY_INTERVAL;
+        if (time < query.from || time > query.to) {
+            continue;
+        }
+        if (first) {
+            length = snprintf(chunkBuffer, sizeof(chunkBuffer),
+                              "{\"id\":%ld,\"zone\":\"%s\",\"metric\":\"%s\",\"start\":%lu,\"interval\":%d,\"values\":[",
+                              (long)query.id, zones[s.zone].name, metricNames[s.metric], (unsigned long)time, HISTORY_INTERVAL);
+            first = false;
+        } else {
+            chunkBuffer[length++] = ',';
+        }
+        if (missing) {
+            length += snprintf(chunkBuffer + length, sizeof(chunkBuffer) - length, "null");
+        } else {
+            length += snprintf(chunkBuffer + length, sizeof(chunkBuffer) - length, "%.1f", value / (float)HISTORY_SCALE);
+        }
+        if (length >= sizeof(chunkBuffer) - 16) {
+            break; // Cannot happen with HISTORY_BLOCK_SIZE 128, guards against larger blocks
+        }
+    }
+    if (first) {
+        return 0;
+    }
+    length += snprintf(chunkBuffer + length, sizeof(chunkBuffer) - length, "]}");
+    return length;
+}
+
+// Function to publish the next chunks of the active query
+static void sendHistoryChunks() {
+    const char* topic = getOutboundTopic(TOPIC_HISTORY_RESPONSE);
+    int sent = 0;
+
+    while (query.active && sent < HISTORY_CHUNKS_PER_RUN) {
+        if (query.series >= seriesCount) {
+            snprintf(chunkBuffer, sizeof(chunkBuffer), "{\"id\":%ld,\"done\":true,\"chunks\":%u}", (long)query.id, query.chunks);
+            if (publishMessage(topic, chunkBuffer, false)) {
+                query.active = false;
+            }
+            return;
+        }
+
+        HistorySeries &s = series[query.series];
+        uint32_t oldest = s.blockCount > blocksPerSeries ? s.blockCount - blocksPerSeries : 0;
+        query.block = max(query.block, oldest); // Blocks may have been overwritten since the last call
+        if (!matchesQuery(s) || query.block >= s.blockCount) {
+            query.series++;
+            query.block = 0;
+            continue;
+        }
+
+        const HistoryBlock &block = s.blocks[query.block % blocksPerSeries];
+        bool inRange = block.start <= query.to && block.start + block.count * HISTORY_INTERVAL > query.from;
+        size_t length = inRange ? buildChunk(s, block) : 0;
+        if (length > 0) {
+            if (!publishMessage(topic, chunkBuffer, false)) {
+                return; // Retry the same chunk on the next call
+            }
+            query.chunks++;
+            sent++;
+        }
+        query.block++;
+    }
+}
+
+// Function to record due samples and continue a pending response; runs on the network task
+void updateHistory() {
+    if (seriesCount == 0) {
+        return;
+    }
+
+    time_t now = time(nullptr);
+    if (now > 1600000000) {
+        uint32_t slot = (uint32_t)now - (uint32_t)now % HISTORY_INTERVAL;
+        if (nextSample == 0 || slot >= nextSample) {
+            recordHistory(slot);
+            nextSample = slot + HISTORY_INTERVAL;
+        }
+    }
+
+    if (query.active) {
+        sendHistoryChunks();
+    }
+}
+
+// Function to start answering a history request; a new request replaces one still being answered
+bool requestHistory(const uint8_t* payload, unsigned int length) {
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length)) {
+        LOG_WARN(LOG_MODULE_MQTT, "History request is not valid JSON");
+        return false;
+    }
+
+    HistoryQuery request = {};
+    request.id = doc["id"] | 0;
+    request.from = doc["from"] | 0UL;
+    request.to = doc["to"] | 0xFFFFFFFFUL;
+    request.zone = -1;
+    request.metric = -1;
+
+    JsonVariantConst zone = doc["zone"];
+    if (!zone.isNull()) {
+        for (uint8_t i : activeZones) {
+            if ((zone.is<int>() ? zone.as<int>() == i : strcmp(zones[i].name, zone | "") == 0)) {
+                request.zone = i;
+            }
+        }
+        if (request.zone < 0) {
+            LOG_WARN(LOG_MODULE_MQTT, "History request for unknown zone");
+            return false;
+        }
+    }
+    JsonVariantConst metric = doc["metric"];
+    if (!metric.isNull()) {
+        for (int m = 0; m < HISTORY_METRIC_COUNT; m++) {
+            if (strcmp(metricNames[m], metric | "") == 0) {
+                request.metric = m;
+            }
+        }
+        if (request.metric < 0) {
+            LOG_WARN(LOG_MODULE_MQTT, "History request for unknown metric");
+            return false;
+        }
+    }
+    if (request.from > request.to) {
+        return false;
+    }
+
+    if (query.active) {
+        LOG_INFO(LOG_MODULE_MQTT, "History request %ld replaces request %ld", (long)request.id, (long)query.id);
+    }
+    request.active = true;
+    query = request;
+    return true;
+}
@@ -0,0 +1,69 @@
+// Module: history_module.h
+// Purpose: Declares the on-device history of the zone values. Samples are delta-encoded into rings of
+//          fixed-size blocks in PSRAM, so consumers can backfill gaps after an outage with a
+//          history_request instead of relying on the last retained value.
+// Definitions:
+// - HISTORY_INTERVAL: Time between two samples (aligned to the wall clock).
+// - HISTORY_BLOCK_SIZE, HISTORY_BLOCKS: Size of a block and blocks per series.
+// - HISTORY_SCALE: Quantization of the stored values (0.1 units).
+// - HISTORY_CHUNKS_PER_RUN: Response chunks published per call of updateHistory().
+// - HISTORY_CHUNK_BUFFER: Size of a serialized response chunk.
+// Enumerations:
+// - HistoryMetric: Recorded values of a zone.
+// Structures:
+// - HistoryBlock: Start time, sample count and encoded samples of a block.
+// - HistorySeries: Ring of blocks holding one metric of one zone.
+// Function Prototypes:
+// - setupHistory(): Allocates the series of all configured zones.
+// - updateHistory(): Records due samples and publishes pending response chunks (network task).
+// - requestHistory(): Starts answering a history_request.
+
+
+#ifndef HISTORY_MODULE_H
+#define HISTORY_MODULE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define HISTORY_INTERVAL 60             // Seconds between samples
+#define HISTORY_BLOCK_SIZE 128          // Bytes per block including the header
+#define HISTORY_BLOCKS 64               // Blocks per series: >= 48 h while deltas stay below 819 units
+#define HISTORY_FALLBACK_BLOCKS 8       // Blocks per series in internal RAM when no PSRAM is available
+#define HISTORY_SCALE 10                // Stored resolution 0.1
+#define HISTORY_CHUNKS_PER_RUN 2
+#define HISTORY_CHUNK_BUFFER 1536
+#define HISTORY_MAX_AGE 5000            // Telemetry older than this is recorded as missing (in ms)
+
+// Enumeration of the recorded values of a zone
+enum HistoryMetric : uint8_t {
+    HISTORY_TEMPERATURE,
+    HISTORY_HUMIDITY,
+    HISTORY_TARGET_TEMPERATURE,
+    HISTORY_VALVE_POSITION,
+    HISTORY_METRIC_COUNT
+};
+
+// Structure of a block; samples follow each other at HISTORY_INTERVAL from the start time
+struct HistoryBlock {
+    uint32_t start;         // Epoch time of the first sample
+    uint16_t count;         // Samples in the block
+    uint8_t used;           // Bytes of encoded samples
+    uint8_t reserved;
+    int16_t last;           // Last stored value, base of the next delta
+    uint8_t data[HISTORY_BLOCK_SIZE - 10];  // Samples: varint(zigzag(delta) + 1), 0 for a missing value
+};
+
+// Structure of a series: one metric of one zone
+struct HistorySeries {
+    uint8_t zone;
+    HistoryMetric metric;
+    uint32_t blockCount;    // Blocks created since startup; block n is stored at n % capacity
+    HistoryBlock* blocks;
+};
+
+// Function prototypes
+bool setupHistory();
+void updateHistory();
+bool requestHistory(const uint8_t* payload, unsigned int length);
+
+#endif // HISTORY_MODULE_H
@@ -0,0 +1,282 @@
+// Module: http_module.cpp
+// Purpose: Serves the HTTP API and the event stream. The network task serializes every new telemetry snapshot once:
+//          {"id": 42, "uptime": 3600, "main_temperature": 18.00, "heater": true, "fault": false, "automation": true,
+//           "valve_mode": "proportional", "zones": [{"index": 0, "name": "Cabin", "temperature": 19.52,
+//           "target": 20.00, "humidity": 45.10, "pressure": null, "voc": null, "valve": 40}, ...]}
+//          into a free buffer of the pool and publishes it. GET requests send the published buffer in place and hold
+//          a reference to it until the connection closes. The buffer is never copied or reallocated. POST requests
+//          queue commands for the control task; an accepted command answers 202.
+// Functions:
+// - setupHTTP(): Registers the routes and the event source and starts the server.
+// - httpTask(): Publishes a new snapshot and sends "zone" and "heater" events for the values that changed.
+// - acquireSnapshot(), releaseSnapshot(): Reference the published snapshot from the server task.
+// - writeSnapshot(): Serializes a snapshot into a free buffer and publishes it.
+// - handleState(), handleTarget(), handleSwitch(): Request handlers (AsyncTCP task).
+
+
+#include "http_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+#include "zone_descriptors.h"
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <stdarg.h>
+
+// Structure of a snapshot buffer; users counts the responses and event clients still reading it
+struct SnapshotBuffer {
+    std::atomic<uint8_t> users;
+    uint32_t id;
+    size_t length;
+    char data[HTTP_SNAPSHOT_SIZE];
+};
+
+static AsyncWebServer server(HTTP_PORT);
+static AsyncEventSource events("/api/events");
+
+static SnapshotBuffer snapshots[HTTP_SNAPSHOT_BUFFERS];
+static std::atomic<int> publishedSnapshot(-1);  // Index of the buffer served to new requests, -1 before the first
+
+// State of the event stream, owned by the network task
+static Telemetry lastEvent;
+static unsigned long lastTimestamp = 0;
+static uint32_t snapshotId = 0;
+static char eventBuffer[HTTP_EVENT_SIZE];
+
+// Function to reference the published snapshot; returns nullptr before the first snapshot
+static SnapshotBuffer* acquireSnapshot() {
+    for (;;) {
+        int index = publishedSnapshot.load();
+        if (index < 0) {
+            return nullptr;
+        }
+        snapshots[index].users++;
+        if (publishedSnapshot.load() == index) {
+            return &snapshots[index];
+        }
+        snapshots[index].users--; // Replaced in between; the writer may already reuse it
+    }
+}
+
+// Function to drop a reference taken by acquireSnapshot()
+static void releaseSnapshot(SnapshotBuffer* snapshot) {
+    snapshot->users--;
+}
+
+// Function to append formatted text; once the buffer is full the length only grows, so the caller sees the overflow
+static size_t appendText(char* buffer, size_t size, size_t length, const char* format, ...) {
+    if (length >= size) {
+        return length;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    return length + max(written, 0);
+}
+
+// Function to append ,"key":value with two decimals, or null without a value
+static size_t appendNumber(char* buffer, size_t size, size_t length, const char* key, float value) {
+    return isnan(value) ? appendText(buffer, size, length, ",\"%s\":null", key)
+                        : appendText(buffer, size, length, ",\"%s\":%.2f", key, value);
+}
+
+// Function to append the object of a zone; zone names come from the descriptors and need no escaping
+static size_t appendZone(char* buffer, size_t size, size_t length, int index, const ZoneTelemetry &zone) {
+    length = appendText(buffer, size, length, "{\"index\":%d,\"name\":\"%s\"", index, zones[index].name);
+    length = appendNumber(buffer, size, length, "temperature", zone.temperature);
+    length = appendNumber(buffer, size, length, "target", zone.temperatureTarget);
+    length = appendNumber(buffer, size, length, "humidity", zone.humidity);
+    length = appendNumber(buffer, size, length, "pressure", zone.pressure);
+    length = appendNumber(buffer, size, length, "voc", zone.voc);
+    return zone.valvePosition >= 0 ? appendText(buffer, size, length, ",\"valve\":%d}", zone.valvePosition)
+                                   : appendText(buffer, size, length, ",\"valve\":null}");
+}
+
+// Function to append the heater status and modes as the opening of an object
+static size_t appendGlobals(char* buffer, size_t size, size_t length, const Telemetry &telemetry) {
+    length = appendText(buffer, size, length, "{\"id\":%lu,\"uptime\":%lu", (unsigned long)snapshotId,
+                        telemetry.timestamp / 1000);
+    length = appendNumber(buffer, size, length, "main_temperature", telemetry.mainTemperature);
+    return appendText(buffer, size, length, ",\"heater\":%s,\"fault\":%s,\"automation\":%s,\"valve_mode\":\"%s\"",
+                      telemetry.heaterStatus ? "true" : "false", telemetry.heaterFault ? "true" : "false",
+                      telemetry.automationActive ? "true" : "false",
+                      telemetry.valveModeProportional ? "proportional" : "on_off");
+}
+
+// Function to serialize a snapshot into a buffer no request is reading, then publish it
+static void writeSnapshot(const Telemetry &telemetry) {
+    int published = publishedSnapshot.load();
+    int index = -1;
+    for (int i = 0; i < HTTP_SNAPSHOT_BUFFERS && index < 0; i++) {
+        if (i != published && snapshots[i].users.load() == 0) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        LOG_DEBUG(LOG_MODULE_MAIN, "All HTTP snapshot buffers in use, snapshot %lu skipped", (unsigned long)snapshotId);
+        return;
+    }
+
+    SnapshotBuffer &snapshot = snapshots[index];
+    size_t length = appendGlobals(snapshot.data, HTTP_SNAPSHOT_SIZE, 0, telemetry);
+    length = appendText(snapshot.data, HTTP_SNAPSHOT_SIZE, length, ",\"zones\":[");
+    bool first = true;
+    for (uint8_t i : activeZones) {
+        length = appendText(snapshot.data, HTTP_SNAPSHOT_SIZE, length, first ? "" : ",");
+        length = appendZone(snapshot.data, HTTP_SNAPSHOT_SIZE, length, i, telemetry.zones[i]);
+        first = false;
+    }
+    length = appendText(snapshot.data, HTTP_SNAPSHOT_SIZE, length, "]}");
+    if (length >= HTTP_SNAPSHOT_SIZE) {
+        LOG_ERROR(LOG_MODULE_MAIN, "HTTP snapshot does not fit the buffer");
+        return;
+    }
+    snapshot.id = snapshotId;
+    snapshot.length = length;
+    publishedSnapshot.store(index);
+}
+
+// Function to send the values that changed since the last snapshot to the event streams
+static void sendChanges(const Telemetry &telemetry) {
+    for (uint8_t i : activeZones) {
+        if (memcmp(&telemetry.zones[i], &lastEvent.zones[i], sizeof(ZoneTelemetry)) != 0 &&
+            appendZone(eventBuffer, sizeof(eventBuffer), 0, i, telemetry.zones[i]) < sizeof(eventBuffer)) {
+            events.send(eventBuffer, "zone", snapshotId);
+        }
+    }
+
+    bool globalsChanged = memcmp(&telemetry.mainTemperature, &lastEvent.mainTemperature, sizeof(float)) != 0 ||
+                          telemetry.heaterStatus != lastEvent.heaterStatus ||
+                          telemetry.heaterFault != lastEvent.heaterFault ||
+                          telemetry.automationActive != lastEvent.automationActive ||
+                          telemetry.valveModeProportional != lastEvent.valveModeProportional;
+    if (globalsChanged && appendText(eventBuffer, sizeof(eventBuffer),
+                                     appendGlobals(eventBuffer, sizeof(eventBuffer), 0, telemetry), "}") < sizeof(eventBuffer)) {
+        events.send(eventBuffer, "heater", snapshotId);
+    }
+}
+
+// Task: publish each new telemetry snapshot and stream its changes; runs on the network task
+void httpTask() {
+    if (!hasTelemetry()) {
+        return;
+    }
+    const Telemetry &telemetry = receiveTelemetry();
+    if (snapshotId > 0 && telemetry.timestamp == lastTimestamp) {
+        return;
+    }
+    lastTimestamp = telemetry.timestamp;
+    snapshotId++;
+
+    writeSnapshot(telemetry);
+    if (events.count() > 0) {
+        sendChanges(telemetry);
+    }
+    lastEvent = telemetry;
+}
+
+// Function to send a constant JSON body in place
+static void sendConstant(AsyncWebServerRequest* request, int code, const char* json) {
+    request->send(request->beginResponse(code, "application/json", (const uint8_t*)json, strlen(json)));
+}
+
+// Function to read a number from the form body or, failing that, the query string
+static bool getNumber(AsyncWebServerRequest* request, const char* name, float &value) {
+    const AsyncWebParameter* parameter = request->hasParam(name, true) ? request->getParam(name, true) : request->getParam(name);
+    if (parameter == nullptr) {
+        return false;
+    }
+    const char* text = parameter->value().c_str();
+    char* end;
+    value = strtof(text, &end);
+    return end != text && *end == '\0' && isfinite(value);
+}
+
+// Function to resolve the zone parameter, given by index or name; returns -1 if not found
+static int getZone(AsyncWebServerRequest* request) {
+    const AsyncWebParameter* parameter = request->hasParam("zone", true) ? request->getParam("zone", true) : request->getParam("zone");
+    if (parameter == nullptr) {
+        return -1;
+    }
+    const char* zone = parameter->value().c_str();
+    char* end;
+    long index = strtol(zone, &end, 10);
+    if (end != zone && *end == '\0') {
+        return (index >= 0 && index < NUM_ZONES && zoneTopicSlot.slot[index] >= 0) ? index : -1;
+    }
+    for (uint8_t i : activeZones) {
+        if (strcmp(zones[i].name, zone) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to queue a command for the control task and answer the request
+static void queueCommand(AsyncWebServerRequest* request, CommandType type, int zone, float value) {
+    if (sendCommand(type, zone, value, COMMAND_SOURCE_HTTP)) {
+        sendConstant(request, 202, "{\"queued\":true}");
+    } else {
+        sendConstant(request, 503, "{\"error\":\"command queue full\"}");
+    }
+}
+
+// GET /api/state: the published snapshot, referenced until the connection closes
+static void handleState(AsyncWebServerRequest* request) {
+    SnapshotBuffer* snapshot = acquireSnapshot();
+    if (snapshot == nullptr) {
+        sendConstant(request, 503, "{\"error\":\"no telemetry yet\"}");
+        return;
+    }
+    request->onDisconnect([snapshot]() { releaseSnapshot(snapshot); });
+    request->send(request->beginResponse(200, "application/json", (const uint8_t*)snapshot->data, snapshot->length));
+}
+
+// POST /api/target: zone=Cabin&value=21.5
+static void handleTarget(AsyncWebServerRequest* request) {
+    int zone = getZone(request);
+    float value;
+    if (zone < 0) {
+        sendConstant(request, 400, "{\"error\":\"unknown zone\"}");
+    } else if (!getNumber(request, "value", value)) {
+        sendConstant(request, 400, "{\"error\":\"value must be a number\"}");
+    } else {
+        queueCommand(request, CMD_SET_TARGET, zone, value);
+    }
+}
+
+// POST /api/automation, /api/valve_mode, /api/toggle: value=0 or value=1
+static void handleSwitch(AsyncWebServerRequest* request, CommandType type) {
+    float value;
+    if (!getNumber(request, "value", value) || (value != 0 && value != 1)) {
+        sendConstant(request, 400, "{\"error\":\"value must be 0 or 1\"}");
+        return;
+    }
+    queueCommand(request, type, -1, value);
+}
+
+// Function to register the routes and start the server; the AsyncTCP task accepts connections from then on
+void setupHTTP() {
+    server.on("/api/state", HTTP_GET, handleState);
+    server.on("/api/target", HTTP_POST, handleTarget);
+    server.on("/api/automation", HTTP_POST, [](AsyncWebServerRequest* request) { handleSwitch(request, CMD_SET_AUTOMATION); });
+    server.on("/api/valve_mode", HTTP_POST, [](AsyncWebServerRequest* request) { handleSwitch(request, CMD_SET_VALVE_MODE); });
+    server.on("/api/toggle", HTTP_POST, [](AsyncWebServerRequest* request) { handleSwitch(request, CMD_TOGGLE_HEATER); });
+    server.onNotFound([](AsyncWebServerRequest* request) { sendConstant(request, 404, "{\"error\":\"not found\"}"); });
+
+    // New event clients start from the full snapshot; the changes follow from httpTask()
+    events.onConnect([](AsyncEventSourceClient* client) {
+        if (events.count() > HTTP_MAX_EVENT_CLIENTS) {
+            client->close();
+            return;
+        }
+        SnapshotBuffer* snapshot = acquireSnapshot();
+        if (snapshot != nullptr) {
+            client->send(snapshot->data, "state", snapshot->id);
+            releaseSnapshot(snapshot);
+        }
+    });
+    server.addHandler(&events);
+    server.begin();
+    LOG_INFO(LOG_MODULE_MAIN, "HTTP API on port %d", HTTP_PORT);
+}
@@ -0,0 +1,37 @@
+// Module: http_module.h
+// Purpose: Declares the embedded HTTP API, which keeps the controller observable and controllable when the MQTT
+//          broker or the Signal K server is down:
+//          - GET  /api/state: JSON snapshot of all zones, the heater status and the modes;
+//          - POST /api/target (zone, value), /api/automation, /api/valve_mode, /api/toggle (value 0 or 1);
+//          - GET  /api/events: Server-Sent Events; "state" with the snapshot on connect, then "zone" and "heater"
+//            events with the values that changed.
+//          The server runs in the AsyncTCP task on the network core. Commands reach the control task through their
+//          own queue, and responses are served from a pool of preallocated snapshot buffers.
+// Definitions:
+// - HTTP_PORT: Listening port.
+// - HTTP_SNAPSHOT_SIZE: Size of a serialized snapshot.
+// - HTTP_SNAPSHOT_BUFFERS: Snapshot buffers; one is being written while the others are being sent.
+// - HTTP_EVENT_SIZE: Size of a serialized change event.
+// - HTTP_MAX_EVENT_CLIENTS: Concurrent event streams; further clients are closed.
+// Function Prototypes:
+// - setupHTTP(): Registers the routes and starts the server.
+// - httpTask(): Serializes new telemetry and pushes the changes to the event streams (network task).
+
+
+#ifndef HTTP_MODULE_H
+#define HTTP_MODULE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define HTTP_PORT 80
+#define HTTP_SNAPSHOT_SIZE 2048
+#define HTTP_SNAPSHOT_BUFFERS 4
+#define HTTP_EVENT_SIZE 256
+#define HTTP_MAX_EVENT_CLIENTS 4
+
+// Function prototypes
+void setupHTTP();
+void httpTask();
+
+#endif // HTTP_MODULE_H
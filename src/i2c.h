@@ -2,13 +2,17 @@
 // Purpose: Declares functions and variables for I2C communication with BME680 sensors.
 // Definitions:
 // - BME680_SENSOR_COUNT: Number of BME680 sensors.
+// - BME680_READ_INTERVAL, BME680_GAS_INTERVAL: Cadence of temperature/humidity/pressure and of gas measurements.
+// - BME680_GAS_HEATER_TEMP, BME680_GAS_HEATER_TIME: Gas heater profile.
+// - BME680_MAX_AGE, BME680_GAS_MAX_AGE: Values older than this are reported as NAN.
 // Structures:
 // - BME680Data: Stores sensor readings.
 // External Variables:
 // - sensors[], hums[], pressures[], vocs[]: Arrays to store sensor data.
 // - bme680Sensors[], bme680Addresses[]: Arrays of sensor objects and their I2C addresses.
 // Function Prototypes:
-// - setupBME680()
+// - setupBME680(), initBME680()
+// - updateBME680()
 // - readBME680()
 
 
@@ -22,6 +26,14 @@
 // Define the number of BME680 sensors
 #define BME680_SENSOR_COUNT 5
 
+// Measurement cadence; start times are staggered evenly across the sensors
+#define BME680_READ_INTERVAL 2000     // Temperature, humidity and pressure (in ms)
+#define BME680_GAS_INTERVAL 60000     // Gas resistance, needs the heater plate (in ms)
+#define BME680_GAS_HEATER_TEMP 320    // Gas heater temperature (in °C)
+#define BME680_GAS_HEATER_TIME 150    // Gas heater duration (in ms)
+#define BME680_MAX_AGE 10000          // Maximum age of temperature, humidity and pressure (in ms)
+#define BME680_GAS_MAX_AGE 180000     // Maximum age of the gas resistance (in ms)
+
 // Structure to store values from a BME680 sensor
 struct BME680Data {
     float temperature;
@@ -39,9 +51,12 @@ extern float vocs[20];
 // External declarations of BME680 sensors and their I2C addresses
 extern Adafruit_BME680 bme680Sensors[BME680_SENSOR_COUNT];
 extern uint8_t bme680Addresses[BME680_SENSOR_COUNT];
+extern bool bme680Present[BME680_SENSOR_COUNT];
 
 // Function prototypes for initializing and reading BME680 sensors
 void setupBME680();
+bool initBME680(int index);
+void updateBME680();
 void readBME680(float sensors[], float hums[], float pressures[], float vocs[]);
 
 #endif
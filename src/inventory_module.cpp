@@ -0,0 +1,233 @@
+// Module: inventory_module.cpp
+// Purpose: Keeps an inventory of the devices on the I2C and OneWire buses. The buses belong to the control
+//          task, so the scan runs there in small steps at low priority; the network task answers requests
+//          from a JSON document that is only rendered again after a scan changed the inventory.
+// Functions:
+// - setupInventory(): Runs a complete scan at startup.
+// - scanInventory(): Runs one scan step: a few I2C address probes or one OneWire search step.
+// - getInventoryJson(): Returns the cached inventory document, rendered again if a newer scan is available.
+
+
+#include "inventory_module.h"
+#include "i2c.h"
+#include "ds18_module.h"
+#include "log_module.h"
+#include <Wire.h>
+#include <ArduinoJson.h>
+
+// Phases of a bus scan
+enum ScanPhase {
+    SCAN_IDLE,
+    SCAN_I2C,
+    SCAN_ONEWIRE
+};
+
+static Inventory inventory;                 // Owned by the control task
+static bool seen[MAX_DEVICES];              // Devices detected by the running scan
+static ScanPhase scanPhase = SCAN_IDLE;
+static unsigned long scanStart = 0;
+static uint8_t nextI2CAddress = INVENTORY_I2C_FIRST;
+static bool oneWireRestart = true;
+
+// Snapshot handed to the network task after every complete scan
+static portMUX_TYPE inventoryMux = portMUX_INITIALIZER_UNLOCKED;
+static Inventory sharedInventory;
+static uint32_t sharedVersion = 0;
+
+static const char* const deviceTypeNames[] = {"I2C", "BME680", "OneWire", "DS18B20"};
+
+// Function to find the index of a configured BME680 address; returns -1 if not configured
+static int getBME680Index(uint8_t address) {
+    for (int i = 0; i < BME680_SENSOR_COUNT; i++) {
+        if (bme680Addresses[i] == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to find the sensor slot of an assigned DS18B20; returns -1 if not assigned
+static int getDS18Slot(const uint8_t* address) {
+    for (int i = 0; i < numAssignedSensors && i < 10; i++) {
+        if (memcmp(assignedAddresses[i], address, sizeof(DeviceAddress)) == 0) {
+            return 5 + i;
+        }
+    }
+    return -1;
+}
+
+// Function to record a detected device
+static void markSeen(DeviceType type, const uint8_t* address, size_t length, int slot, unsigned long now) {
+    int index = -1;
+    for (int i = 0; i < inventory.count; i++) {
+        const Device &device = inventory.devices[i];
+        if ((device.type == DEVICE_DS18B20 || device.type == DEVICE_ONEWIRE_UNKNOWN) == (length == 8) &&
+            memcmp(device.address, address, length) == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        if (inventory.count >= MAX_DEVICES) {
+            LOG_WARN(LOG_MODULE_SENSORS, "Device inventory full");
+            return;
+        }
+        index = inventory.count++;
+        Device &device = inventory.devices[index];
+        memset(&device, 0, sizeof(device));
+        memcpy(device.address, address, length);
+        device.firstSeen = now;
+    }
+
+    Device &device = inventory.devices[index];
+    if (!device.present) {
+        LOG_INFO(LOG_MODULE_SENSORS, "%s found (slot %d)", deviceTypeNames[type], slot);
+    }
+    device.type = type;
+    device.slot = slot;
+    device.present = true;
+    device.lastSeen = now;
+    seen[index] = true;
+}
+
+// Function to probe an I2C address
+static bool probeI2C(uint8_t address) {
+    Wire.beginTransmission(address);
+    return Wire.endTransmission() == 0;
+}
+
+// Function to start a new scan
+static void startScan(unsigned long now) {
+    scanStart = now;
+    memset(seen, 0, sizeof(seen));
+    nextI2CAddress = INVENTORY_I2C_FIRST;
+    oneWireRestart = true;
+    scanPhase = SCAN_I2C;
+}
+
+// Function to finish a scan: mark missing devices and hand the result to the network task
+static void finishScan(unsigned long now) {
+    for (int i = 0; i < inventory.count; i++) {
+        Device &device = inventory.devices[i];
+        if (device.present && !seen[i]) {
+            device.present = false;
+            LOG_WARN(LOG_MODULE_SENSORS, "%s lost (slot %d)", deviceTypeNames[device.type], device.slot);
+            if (device.type == DEVICE_BME680) {
+                int index = getBME680Index(device.address[0]);
+                if (index >= 0) {
+                    bme680Present[index] = false; // Re-initialized when it comes back
+                }
+            }
+        }
+    }
+    inventory.scanTime = now;
+    scanPhase = SCAN_IDLE;
+
+    portENTER_CRITICAL(&inventoryMux);
+    sharedInventory = inventory;
+    sharedVersion++;
+    portEXIT_CRITICAL(&inventoryMux);
+}
+
+// Function to run one scan step; called periodically by the control task
+void scanInventory() {
+    unsigned long now = millis();
+
+    switch (scanPhase) {
+        case SCAN_IDLE:
+            if (now - scanStart >= INVENTORY_SCAN_INTERVAL) {
+                startScan(now);
+            }
+            break;
+
+        case SCAN_I2C:
+            for (int n = 0; n < INVENTORY_I2C_STEP && nextI2CAddress <= INVENTORY_I2C_LAST; n++, nextI2CAddress++) {
+                if (!probeI2C(nextI2CAddress)) {
+                    continue;
+                }
+                int index = getBME680Index(nextI2CAddress);
+                if (index >= 0 && !bme680Present[index]) {
+                    // Hot-plugged sensor: configure it before the acquisition picks it up
+                    initBME680(index);
+                }
+                markSeen(index >= 0 ? DEVICE_BME680 : DEVICE_I2C_UNKNOWN, &nextI2CAddress, 1, index >= 0 ? 15 + index : -1, now);
+            }
+            if (nextI2CAddress > INVENTORY_I2C_LAST) {
+                scanPhase = SCAN_ONEWIRE;
+            }
+            break;
+
+        case SCAN_ONEWIRE: {
+            DeviceAddress address;
+            int result = searchDS18(address, oneWireRestart);
+            if (result < 0) {
+                break; // Bus busy, try again on the next step
+            }
+            oneWireRestart = false;
+            if (result > 0) {
+                markSeen(address[0] == 0x28 ? DEVICE_DS18B20 : DEVICE_ONEWIRE_UNKNOWN, address, 8, getDS18Slot(address), now);
+            } else {
+                finishScan(now);
+            }
+            break;
+        }
+    }
+}
+
+// Function to build the inventory with a complete scan; runs before the control task starts
+void setupInventory() {
+    startScan(millis());
+    while (scanPhase != SCAN_IDLE) {
+        scanInventory();
+    }
+    LOG_INFO(LOG_MODULE_SENSORS, "Device inventory: %d devices", inventory.count);
+}
+
+// Function to get the inventory as JSON; runs on the network task
+const char* getInventoryJson() {
+    static char json[INVENTORY_JSON_SIZE] = "{}";
+    static Inventory snapshot;
+    static uint32_t renderedVersion = 0;
+
+    portENTER_CRITICAL(&inventoryMux);
+    bool changed = sharedVersion != renderedVersion;
+    if (changed) {
+        snapshot = sharedInventory;
+        renderedVersion = sharedVersion;
+    }
+    portEXIT_CRITICAL(&inventoryMux);
+
+    if (!changed) {
+        return json;
+    }
+
+    JsonDocument doc;
+    doc["scanTime"] = snapshot.scanTime / 1000;
+    JsonArray devices = doc["devices"].to<JsonArray>();
+    for (int i = 0; i < snapshot.count; i++) {
+        const Device &device = snapshot.devices[i];
+        bool oneWire = device.type == DEVICE_DS18B20 || device.type == DEVICE_ONEWIRE_UNKNOWN;
+        char address[17];
+        if (oneWire) {
+            for (int j = 0; j < 8; j++) {
+                snprintf(address + j * 2, 3, "%02X", device.address[j]);
+            }
+        } else {
+            snprintf(address, sizeof(address), "0x%02X", device.address[0]);
+        }
+
+        JsonObject entry = devices.add<JsonObject>();
+        entry["type"] = deviceTypeNames[device.type];
+        entry["bus"] = oneWire ? "onewire" : "i2c";
+        entry["address"] = address;
+        entry["slot"] = device.slot;
+        entry["present"] = device.present;
+        entry["firstSeen"] = device.firstSeen / 1000;
+        entry["lastSeen"] = device.lastSeen / 1000;
+    }
+
+    if (serializeJson(doc, json, sizeof(json)) >= sizeof(json) - 1) {
+        LOG_WARN(LOG_MODULE_SENSORS, "Inventory document truncated");
+    }
+    return json;
+}
@@ -0,0 +1,62 @@
+// Module: inventory_module.h
+// Purpose: Declares the device inventory of the I2C and OneWire buses, kept up to date by a background scan.
+// Definitions:
+// - MAX_DEVICES: Maximum number of devices in the inventory.
+// - INVENTORY_SCAN_INTERVAL: Time between the starts of two bus scans.
+// - INVENTORY_I2C_FIRST, INVENTORY_I2C_LAST, INVENTORY_I2C_STEP: Probed I2C address range and probes per step.
+// - INVENTORY_JSON_SIZE: Size of the cached JSON document.
+// Enumerations:
+// - DeviceType: Kind of a device.
+// Structures:
+// - Device: Presence, address, type and first/last-seen times of a device.
+// - Inventory: All known devices.
+// Function Prototypes:
+// - setupInventory(): Runs a complete scan at startup.
+// - scanInventory(): One step of the background scan (control task).
+// - getInventoryJson(): Returns the inventory as a JSON document (network task).
+
+
+#ifndef INVENTORY_MODULE_H
+#define INVENTORY_MODULE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define MAX_DEVICES 24
+#define INVENTORY_SCAN_INTERVAL 30000   // Start of one scan to the start of the next (in ms)
+#define INVENTORY_I2C_FIRST 0x08
+#define INVENTORY_I2C_LAST 0x7F
+#define INVENTORY_I2C_STEP 8            // I2C addresses probed per scan step
+#define INVENTORY_JSON_SIZE 3072
+
+// Enumeration of device types
+enum DeviceType : uint8_t {
+    DEVICE_I2C_UNKNOWN,
+    DEVICE_BME680,
+    DEVICE_ONEWIRE_UNKNOWN,
+    DEVICE_DS18B20
+};
+
+// Structure of an inventory entry
+struct Device {
+    DeviceType type;
+    uint8_t address[8];         // I2C address in address[0], OneWire ROM code otherwise
+    int8_t slot;                // Sensor slot (see routing_module.h), -1 if not assigned
+    bool present;               // Seen in the last complete scan
+    unsigned long firstSeen;    // millis() of the first detection
+    unsigned long lastSeen;     // millis() of the last detection
+};
+
+// Structure of the complete inventory
+struct Inventory {
+    uint8_t count;
+    Device devices[MAX_DEVICES];
+    unsigned long scanTime;     // millis() at the end of the last complete scan
+};
+
+// Function prototypes
+void setupInventory();
+void scanInventory();
+const char* getInventoryJson();
+
+#endif // INVENTORY_MODULE_H
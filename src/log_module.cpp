@@ -0,0 +1,255 @@
+// Module: log_module.cpp
+// Purpose: Implements the asynchronous logging subsystem; producers never block or allocate.
+// Functions:
+// - setupLogging(): Starts the background drain task.
+// - setLogLevel(), getLogLevel(): Change and query the runtime level of a module.
+// - findLogModule(): Maps a module name to its LogModule value.
+// - logEnqueue(): Stores a format string and its arguments in the lock-free ring buffer.
+// - logText(): Stores pre-rendered text (used by sendMessage()).
+// - logPrintf(): Renders text at once and stores it like logText().
+// - getLogDropped(): Returns the number of entries dropped because the buffer was full.
+// - flushLog(): Formats queued entries and writes them to Serial and Telnet.
+// - drainLog(): Background task that calls flushLog().
+
+
+#include "log_module.h"
+#include <TelnetStream.h>
+#include <atomic>
+#include <stdarg.h>
+
+// Structure of a ring buffer entry
+struct LogEntry {
+    std::atomic<uint32_t> sequence;  // Slot sequence number (bounded MPMC queue protocol)
+    uint32_t timestamp;              // millis() at enqueue time
+    LogLevel level;
+    LogModule module;
+    uint8_t argCount;
+    const char* format;              // nullptr: entry carries pre-rendered text
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_SIZE];
+};
+
+static LogEntry logBuffer[LOG_BUFFER_SIZE];
+static std::atomic<uint32_t> enqueuePosition(0);
+static uint32_t dequeuePosition = 0;     // Only used by the drain task
+static std::atomic<uint32_t> droppedEntries(0);
+
+volatile uint8_t logLevels[LOG_MODULE_COUNT] = {
+    LEVEL_DEBUG, LEVEL_DEBUG, LEVEL_DEBUG, LEVEL_DEBUG, LEVEL_DEBUG, LEVEL_DEBUG
+};
+
+static const char* const moduleNames[LOG_MODULE_COUNT] = {
+    "main", "mqtt", "sensors", "heater", "servo", "update"
+};
+static const char* const levelNames[] = {"-", "E", "W", "I", "D"};
+
+// Slot sequence numbers start at their index; done during static initialization so
+// messages logged before setupLogging() are kept until the drain task starts
+static bool initLogBuffer() {
+    for (uint32_t i = 0; i < LOG_BUFFER_SIZE; i++) {
+        logBuffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    return true;
+}
+static const bool logBufferInitialized = initLogBuffer();
+
+// Function to reserve a slot; returns nullptr when the buffer is full
+static LogEntry* reserveEntry() {
+    uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        LogEntry &entry = logBuffer[position & (LOG_BUFFER_SIZE - 1)];
+        uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return &entry;
+            }
+        } else if (difference < 0) {
+            droppedEntries.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Function to publish a filled slot to the drain task
+static void commitEntry(LogEntry* entry) {
+    uint32_t position = entry->sequence.load(std::memory_order_relaxed);
+    entry->sequence.store(position + 1, std::memory_order_release);
+}
+
+void logEnqueue(LogLevel level, LogModule module, const char* format, const LogArg* args, uint8_t argCount) {
+    LogEntry* entry = reserveEntry();
+    if (entry == nullptr) {
+        return;
+    }
+    entry->timestamp = millis();
+    entry->level = level;
+    entry->module = module;
+    entry->format = format;
+    entry->argCount = argCount;
+    for (uint8_t i = 0; i < argCount; i++) {
+        entry->args[i] = args[i];
+    }
+    commitEntry(entry);
+}
+
+void logText(LogLevel level, LogModule module, const char* text) {
+    if (level > logLevels[module]) {
+        return;
+    }
+    LogEntry* entry = reserveEntry();
+    if (entry == nullptr) {
+        return;
+    }
+    entry->timestamp = millis();
+    entry->level = level;
+    entry->module = module;
+    entry->format = nullptr;
+    entry->argCount = 0;
+    strncpy(entry->text, text, LOG_TEXT_SIZE - 1);
+    entry->text[LOG_TEXT_SIZE - 1] = '\0';
+    commitEntry(entry);
+}
+
+// Function to render text at once, for arguments that do not outlive the call; the text is cut at LOG_TEXT_SIZE
+void logPrintf(LogLevel level, LogModule module, const char* format, ...) {
+    if (level > LOG_COMPILE_LEVEL || level > logLevels[module]) {
+        return;
+    }
+    char text[LOG_TEXT_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    logText(level, module, text);
+}
+
+// Function to render a deferred entry; conversions follow the format, values follow the stored type
+static void formatEntry(const LogEntry &entry, char* out, size_t size) {
+    size_t used = 0;
+    uint8_t argIndex = 0;
+    const char* p = entry.format;
+
+    while (*p && used < size - 1) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop length modifiers
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.*", *p) && n < sizeof(spec) - 4) {
+            spec[n++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char conversion = *p ? *p++ : 's';
+
+        int written = 0;
+        if (argIndex >= entry.argCount) {
+            written = snprintf(out + used, size - used, "?");
+        } else {
+            const LogArg &arg = entry.args[argIndex++];
+            long long integer = arg.type == LogArg::DOUBLE ? (long long)arg.d : (arg.type == LogArg::UINT ? (long long)arg.u : arg.i);
+            if (strchr("diouxX", conversion)) {
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = snprintf(out + used, size - used, spec, integer);
+            } else if (strchr("fFeEgGaA", conversion)) {
+                double real = arg.type == LogArg::DOUBLE ? arg.d : (double)integer;
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = snprintf(out + used, size - used, spec, real);
+            } else if (conversion == 'c') {
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                written = snprintf(out + used, size - used, spec, (int)integer);
+            } else {
+                spec[n++] = 's';
+                spec[n] = '\0';
+                written = snprintf(out + used, size - used, spec, arg.type == LogArg::STRING && arg.s ? arg.s : "?");
+            }
+        }
+        if (written > 0) {
+            used += min((size_t)written, size - 1 - used);
+        }
+    }
+    out[used] = '\0';
+}
+
+// Function to format all queued entries and write them to Serial and Telnet; only one consumer may call it
+void flushLog() {
+    char message[160];
+    char line[192];
+
+    for (;;) {
+        LogEntry &entry = logBuffer[dequeuePosition & (LOG_BUFFER_SIZE - 1)];
+        if (entry.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            break; // Nothing (more) to drain
+        }
+        if (entry.format != nullptr) {
+            formatEntry(entry, message, sizeof(message));
+        } else {
+            strncpy(message, entry.text, sizeof(message));
+            message[sizeof(message) - 1] = '\0';
+        }
+        snprintf(line, sizeof(line), "[%lu] %s %s: %s", (unsigned long)entry.timestamp,
+                 levelNames[entry.level], moduleNames[entry.module], message);
+
+        // Release the slot before the (slow) output
+        entry.sequence.store(dequeuePosition + LOG_BUFFER_SIZE, std::memory_order_release);
+        dequeuePosition++;
+
+        Serial.println(line);
+        TelnetStream.println(line);
+    }
+}
+
+// Background task: drain the ring buffer
+static void drainLog(void* parameter) {
+    for (;;) {
+        flushLog();
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+// Function to start the drain task
+void setupLogging() {
+    xTaskCreate(drainLog, "log_drain", 4096, nullptr, 1, nullptr);
+}
+
+void setLogLevel(LogModule module, LogLevel level) {
+    if (module < LOG_MODULE_COUNT && level <= LEVEL_DEBUG) {
+        logLevels[module] = level;
+    }
+}
+
+LogLevel getLogLevel(LogModule module) {
+    return module < LOG_MODULE_COUNT ? (LogLevel)logLevels[module] : LEVEL_NONE;
+}
+
+// Function to find a module by name; returns -1 if unknown
+int findLogModule(const char* name) {
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcmp(moduleNames[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+unsigned long getLogDropped() {
+    return droppedEntries.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,109 @@
+// Module: log_module.h
+// Purpose: Declares the asynchronous logging subsystem with deferred formatting and per-module levels.
+// Definitions:
+// - LOG_COMPILE_LEVEL: Highest level compiled into the firmware; lower-priority calls cost nothing.
+// - LOG_BUFFER_SIZE: Number of entries in the ring buffer (power of two).
+// - LOG_MAX_ARGS, LOG_TEXT_SIZE: Limits of a single entry.
+// - LOG_ERROR(), LOG_WARN(), LOG_INFO(), LOG_DEBUG(): Logging macros.
+// Enumerations:
+// - LogLevel: Severity levels.
+// - LogModule: Modules with their own runtime level.
+// Structures:
+// - LogArg: A deferred format argument.
+// Function Prototypes:
+// - setupLogging()
+// - setLogLevel(), getLogLevel(), findLogModule()
+// - logEnqueue(), logText(), logPrintf()
+// - getLogDropped()
+// - flushLog()
+
+
+#ifndef LOG_MODULE_H
+#define LOG_MODULE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define LOG_BUFFER_SIZE 64      // Ring buffer entries (power of two)
+#define LOG_MAX_ARGS 4          // Maximum number of format arguments per entry
+#define LOG_TEXT_SIZE 80        // Characters of pre-rendered text kept per entry
+
+// Enumeration of log levels
+enum LogLevel : uint8_t {
+    LEVEL_NONE,
+    LEVEL_ERROR,
+    LEVEL_WARN,
+    LEVEL_INFO,
+    LEVEL_DEBUG
+};
+
+// Highest level compiled into the firmware
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL (DEBUG_MODE ? LEVEL_DEBUG : LEVEL_INFO)
+#endif
+
+// Enumeration of modules with separate runtime levels
+enum LogModule : uint8_t {
+    LOG_MODULE_MAIN,
+    LOG_MODULE_MQTT,
+    LOG_MODULE_SENSORS,
+    LOG_MODULE_HEATER,
+    LOG_MODULE_SERVO,
+    LOG_MODULE_UPDATE,
+    LOG_MODULE_COUNT
+};
+
+// Structure of a deferred format argument
+struct LogArg {
+    enum Type : uint8_t { INT, UINT, DOUBLE, STRING } type;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const char* s; // Must point to storage that outlives the entry (literals, zone names); else use logPrintf()
+    };
+};
+
+// Conversion of supported argument types
+inline LogArg toLogArg(int value) { LogArg a; a.type = LogArg::INT; a.i = value; return a; }
+inline LogArg toLogArg(long value) { LogArg a; a.type = LogArg::INT; a.i = value; return a; }
+inline LogArg toLogArg(long long value) { LogArg a; a.type = LogArg::INT; a.i = value; return a; }
+inline LogArg toLogArg(unsigned int value) { LogArg a; a.type = LogArg::UINT; a.u = value; return a; }
+inline LogArg toLogArg(unsigned long value) { LogArg a; a.type = LogArg::UINT; a.u = value; return a; }
+inline LogArg toLogArg(unsigned long long value) { LogArg a; a.type = LogArg::UINT; a.u = value; return a; }
+inline LogArg toLogArg(bool value) { LogArg a; a.type = LogArg::INT; a.i = value ? 1 : 0; return a; }
+inline LogArg toLogArg(double value) { LogArg a; a.type = LogArg::DOUBLE; a.d = value; return a; }
+inline LogArg toLogArg(const char* value) { LogArg a; a.type = LogArg::STRING; a.s = value; return a; }
+
+// Runtime levels per module
+extern volatile uint8_t logLevels[LOG_MODULE_COUNT];
+
+// Function prototypes
+void setupLogging();
+void setLogLevel(LogModule module, LogLevel level);
+LogLevel getLogLevel(LogModule module);
+int findLogModule(const char* name);
+void logEnqueue(LogLevel level, LogModule module, const char* format, const LogArg* args, uint8_t argCount);
+void logText(LogLevel level, LogModule module, const char* text);
+void logPrintf(LogLevel level, LogModule module, const char* format, ...) __attribute__((format(printf, 3, 4)));
+unsigned long getLogDropped();
+void flushLog();
+
+// Function to log with deferred formatting; levels above LOG_COMPILE_LEVEL are removed at compile time
+template <LogLevel level, typename... Args>
+inline void logMessage(LogModule module, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    if constexpr (level <= LOG_COMPILE_LEVEL) {
+        if (level <= logLevels[module]) {
+            const LogArg packed[sizeof...(Args) + 1] = {toLogArg(args)...};
+            logEnqueue(level, module, format, packed, sizeof...(Args));
+        }
+    }
+}
+
+#define LOG_ERROR(module, ...) logMessage<LEVEL_ERROR>(module, __VA_ARGS__)
+#define LOG_WARN(module, ...) logMessage<LEVEL_WARN>(module, __VA_ARGS__)
+#define LOG_INFO(module, ...) logMessage<LEVEL_INFO>(module, __VA_ARGS__)
+#define LOG_DEBUG(module, ...) logMessage<LEVEL_DEBUG>(module, __VA_ARGS__)
+
+#endif // LOG_MODULE_H
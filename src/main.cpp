@@ -1,13 +1,25 @@
 // Module: main.cpp
 // Purpose: Main entry point for the program; coordinates initialization and the main control loop.
 // Functions:
-// - setup(): Initializes WiFi, OTA updates, sensors, MQTT, servos, and other modules.
-// - loop(): Contains the main control logic, including reading sensor data, updating MQTT messages, handling automation, and checking for updates.
+// - setup(): Initializes sensors, servos, control and MQTT, then starts the tasks. Nothing in setup() waits for
+//   the network: WiFi, NTP, OTA and the broker come up in the background, and each boot phase is timed.
+// - loop(): Unused; the work runs in the network and control tasks started by setup().
+// Control tasks (core 1):
+// - commands (every pass), DS18, BME680 and DHT acquisition (50 ms), sensors (2 s), heater and servo control (5 s),
+//   heater toggle verification (50 ms), telemetry (1 s), serial input (100 ms), device inventory scan (100 ms steps).
+// PID task (core 1, above the control task):
+// - zone valve controllers in proportional valve mode (1 s, fixed rate).
+// Updater task (core 0, on request):
+// - firmware download, SHA-256 verification and installation, see firmware_update_module.
+// Network tasks (core 0):
+// - WiFi/OTA and MQTT or Signal K (every pass), publish (10 s), keepalive (30 s), history recording and backfill (200 ms),
+//   memory telemetry and alerts (5 s), boot timing report (1 s until sent), stage latency metrics (5 min),
+//   HTTP snapshot and event stream (1 s), write-behind of targets and modes to NVS (1 s); HTTP requests themselves
+//   are served by the AsyncTCP task on core 0.
 
 
 #include <Arduino.h>
 #include "ota_module.h"
-#include <ESPmDNS.h>
 #include "message_module.h"
 #include "dht_module.h"
 #include "ds18_module.h"
@@ -20,212 +32,137 @@
 #include "temperature_module.h"
 #include "heater_automation_module.h"
 #include "servo_control_module.h"
+#include "scheduler_module.h"
+#include "zones_module.h"
+#include "log_module.h"
+#include "publish_module.h"
+#include "tasks_module.h"
+#include "routing_module.h"
+#include "inventory_module.h"
+#include "pid_module.h"
+#include "history_module.h"
+#include "boot_module.h"
+#include "metrics_module.h"
+#include "memory_module.h"
+#include "transport_module.h"
+#include "http_module.h"
+#include "settings_module.h"
 #include <esp_system.h> // For ESP32-specific functions
 
 // Instantiate MCP41HV51 digital potentiometer on Chip Select pin 14
 MCP41HV51 mcp41hv51(14);
 
-// Variables for memory check intervals
-unsigned long previousMemoryCheck = 0;
-const long memoryCheckInterval = 5000; // Check every 5 seconds
+// Latest raw sensor values, indexed by sensor slot (0-4 DHT, 5-14 DS18, 15-19 BME680)
+float sensorTemps[NUM_SENSORS];
+float sensorHums[NUM_SENSORS];
+float sensorPressures[NUM_SENSORS];
+float sensorVocs[NUM_SENSORS];
 
-// Variables for heater check intervals
-unsigned long previousHeaterCheck = 0;
-const long heaterCheckInterval = 5000; // Check every 5 seconds
+// Task: bring up the network, serve OTA updates and the selected transport on every pass
+void mqttTask() {
+    serviceNetwork();
+    ArduinoOTA.handle();
+    serviceTransport();
+}
 
-// Function to monitor and print free memory
-void printFreeMemory() {
-    size_t free_heap = esp_get_free_heap_size();
-    size_t min_free_heap = esp_get_minimum_free_heap_size();
+// Task: advance the non-blocking DS18B20 acquisition
+void ds18Task() {
+    uint32_t probe = beginProbe();
+    updateDS18();
+    endProbe(METRIC_DS18_STEP, probe);
+}
 
-    Serial.printf("Free Heap: %d bytes\n", free_heap);
-    Serial.printf("Minimum Free Heap since start: %d bytes\n", min_free_heap);
+// Task: advance the non-blocking BME680 acquisition
+void bme680Task() {
+    uint32_t probe = beginProbe();
+    updateBME680();
+    endProbe(METRIC_BME680_STEP, probe);
 }
 
-void setup() {
-    Serial.begin(115200);
-    while (!Serial) {
-        ; // Wait for the serial port to connect
-    }
+// Task: advance the non-blocking DHT acquisition
+void dhtTask() {
+    uint32_t probe = beginProbe();
+    updateDHT();
+    endProbe(METRIC_DHT_STEP, probe);
+}
 
-    // Initialize mDNS responder
-    if (!MDNS.begin("esp32")) {
-        sendMessage("Error starting MDNS responder!", "debug", 6);
-    } else {
-        sendMessage("MDNS responder started", "debug", 6);
-    }
+// Task: read sensor data and assign it to the zones
+void sensorTask() {
+    uint32_t probe = beginProbe();
+    readDHT(sensorTemps[0], sensorHums[0], sensorTemps[1], sensorHums[1], sensorTemps[2], sensorHums[2], sensorTemps[3], sensorHums[3], sensorTemps[4], sensorHums[4]);
+    endProbe(METRIC_READ_DHT, probe);
+    probe = beginProbe();
+    readDS18(sensorTemps);
+    endProbe(METRIC_READ_DS18, probe);
+    probe = beginProbe();
+    readBME680(sensorTemps, sensorHums, sensorPressures, sensorVocs);
+    endProbe(METRIC_READ_BME680, probe);
+    readHeaterStatus();
 
-    // Set up WiFi, OTA updates, and sensors
-    setupWiFi();
-    setupOTA();
-    setupDHT();
-    setupDS18();
-    setupGPIO();
-    setupBME680();
-    TelnetStream.begin();
+    // Assign sensor values to zones based on configuration
+    assignSensorValues(sensorTemps, sensorHums, sensorPressures, sensorVocs);
+}
 
-    // Synchronize time using NTP
-    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
-    while (time(nullptr) < 8 * 3600 * 2) {
-        delay(500);
+// Task: send changed values of the latest telemetry snapshot
+void publishTask() {
+    if (hasTelemetry()) {
+        uint32_t probe = beginProbe();
+        publishData(receiveTelemetry());
+        endProbe(METRIC_PUBLISH, probe);
     }
-
-    // Initialize MCP41HV51
-    mcp41hv51.begin();
-
-    // Read initial sensor values and assign them to zones
-    float sensors[NUM_SENSORS] = {0};
-    float hums[NUM_SENSORS] = {0};
-    float pressures[NUM_SENSORS] = {0};
-    float vocs[NUM_SENSORS] = {0};
-    readDHT(sensors[0], hums[0], sensors[1], hums[1], sensors[2], hums[2], sensors[3], hums[3], sensors[4], hums[4]);
-    readDS18(sensors);
-    readBME680(sensors, hums, pressures, vocs);
-    assignSensorValues(sensors, hums, pressures, vocs);
-
-    // Set up MQTT communication
-    setupMQTT();
-    setupMQTTSubscription();
-
-    // Send the current modes of heater automation and valve mode
-    String heaterAutomationPath = String(MQTT_BASE_PATH) + "/heater_automation_mode";
-    sendMessage(automationActive ? "1" : "0", heaterAutomationPath, 1);
-    String valveModePath = String(MQTT_BASE_PATH) + "/valve_mode";
-    sendMessage(valveModeProportional ? "1" : "0", valveModePath, 1);
-
-    // Send sensor information once after initialization
-    getDS18SensorInfo();
-
-    // Determine the main temperature after initialization
-    determineMainTemperature();
-
-    // Set up servo motors
-    setupServos();
 }
 
-void loop() {
-    static unsigned long lastPingTime = 0;
-    static unsigned long lastUpdateTime = 0;
-    static float lastMainTemperature = NAN; // To track the last sent value
-    unsigned long currentMillis = millis();
-
-    // Send a ping message every 30 seconds
-    if (currentMillis - lastPingTime >= 30000) {
-        lastPingTime = currentMillis;
-        sendKeepalive(); // Keepalive message to maintain subscriptions
-        sendMessage("Ping", "ping/path", 6);
+// Task: heater automation based on zone temperatures
+void heaterTask() {
+    uint32_t probe = beginProbe();
+    determineMainTemperature();
+    controlHeaterBasedOnZones();
+    endProbe(METRIC_HEATER, probe);
+    if (!isnan(mainTemperature)) {
+        endBootPhase(BOOT_PHASE_FIRST_CONTROL); // Only the first valid decision is recorded
     }
+}
 
-    ArduinoOTA.handle();
-    mqttClient.loop();
-
-    // Read sensor data
-    float sensors[NUM_SENSORS];
-    float hums[NUM_SENSORS];
-    float pressures[NUM_SENSORS];
-    float vocs[NUM_SENSORS];
-    readDHT(sensors[0], hums[0], sensors[1], hums[1], sensors[2], hums[2], sensors[3], hums[3], sensors[4], hums[4]);
-    readDS18(sensors);
-    readBME680(sensors, hums, pressures, vocs);
-    readHeaterStatus();
+// Task: verify heater toggle pulses
+void heaterToggleTask() {
+    processHeaterToggle();
+}
 
-    // Assign sensor values to zones based on configuration
-    assignSensorValues(sensors, hums, pressures, vocs);
-
-    // Update data every 10 seconds
-    if (currentMillis - lastUpdateTime >= 10000) {
-        lastUpdateTime = currentMillis;
-
-        // Send temperature and other data for each zone
-        for (int i = 0; i < NUM_ZONES; i++) {
-            if (strlen(zones[i].name) > 0) {
-                // Send temperature
-                if (!isnan(zones[i].temperature)) {
-                    static float lastTemperature[NUM_ZONES] = {NAN};
-                    if (zones[i].temperature != lastTemperature[i]) {
-                        lastTemperature[i] = zones[i].temperature;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/temperature";
-                        sendMessage(String(zones[i].temperature), path, 1);
-                    }
-                }
-                // Send humidity
-                if (!isnan(zones[i].humidity)) {
-                    static float lastHumidity[NUM_ZONES] = {NAN};
-                    if (zones[i].humidity != lastHumidity[i]) {
-                        lastHumidity[i] = zones[i].humidity;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/humidity";
-                        sendMessage(String(zones[i].humidity), path, 1);
-                    }
-                }
-                // Send target temperature
-                if (!isnan(zones[i].temperatureTarget)) {
-                    static float lastTemperatureTarget[NUM_ZONES] = {NAN};
-                    if (zones[i].temperatureTarget != lastTemperatureTarget[i]) {
-                        lastTemperatureTarget[i] = zones[i].temperatureTarget;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/target_temperature";
-                        sendMessage(String(zones[i].temperatureTarget), path, 1);
-                    }
-                }
-                // Send pressure
-                if (!isnan(zones[i].pressure)) {
-                    static float lastPressure[NUM_ZONES] = {NAN};
-                    if (zones[i].pressure != lastPressure[i]) {
-                        lastPressure[i] = zones[i].pressure;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/pressure";
-                        sendMessage(String(zones[i].pressure), path, 1);
-                    }
-                }
-                // Send VOC value
-                if (!isnan(zones[i].voc)) {
-                    static float lastVOC[NUM_ZONES] = {NAN};
-                    if (zones[i].voc != lastVOC[i]) {
-                        lastVOC[i] = zones[i].voc;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/voc";
-                        sendMessage(String(zones[i].voc), path, 1);
-                    }
-                }
-                // Send valve position
-                if (zones[i].servoValve > 0) {
-                    static int lastValvePosition[NUM_ZONES] = {-1};
-                    int valvePosition = getServoPosition(i);
-                    if (valvePosition != lastValvePosition[i]) {
-                        lastValvePosition[i] = valvePosition;
-                        String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/valve_position";
-                        sendMessage(String(valvePosition), path, 1);
-                    }
-                }
-            }
-        }
+// Task: control servo valves based on zones
+void servoTask() {
+    uint32_t probe = beginProbe();
+    controlServoValvesBasedOnZones();
+    endProbe(METRIC_SERVOS, probe);
+}
 
-        // Determine the main temperature
-        determineMainTemperature();
+// Task: record history and serve backfill requests
+void historyTask() {
+    uint32_t probe = beginProbe();
+    updateHistory();
+    endProbe(METRIC_HISTORY, probe);
+}
 
-        // Send the main temperature only if it has changed
-        if (!isnan(mainTemperature)) {
-            if (isnan(lastMainTemperature) || fabs(mainTemperature - lastMainTemperature) > 0.01) {
-                lastMainTemperature = mainTemperature;
-                String path = String(MQTT_BASE_PATH) + "/main_temperature";
-                sendMessage(String(mainTemperature), path, 1);
-            }
-        }
+// Task: keepalive message to maintain subscriptions
+void keepaliveTask() {
+    sendKeepalive();
+    sendMessage("Ping", "ping/path", 6);
+}
 
-        // Send heater status if it has changed
-        static bool lastHeaterStatus = false;
-        if (heaterStatus != lastHeaterStatus) {
-            lastHeaterStatus = heaterStatus;
-            String path = String(MQTT_BASE_PATH) + "/status";
-            sendMessage(String(heaterStatus ? 1 : 0), path, 1);
-        }
+// Task: publish the boot phase timings once MQTT is up
+void bootReportTask() {
+    static bool reported = false;
+    if (!reported) {
+        reported = publishBootReport();
     }
+}
 
-    // Heater automation based on zone temperatures, checked every 5 seconds
-    if (currentMillis - previousHeaterCheck >= heaterCheckInterval) {
-        previousHeaterCheck = currentMillis;
-        controlHeaterBasedOnZones();
-        controlServoValvesBasedOnZones(); // Control servo valves based on zones
-    }
+// Task: memory telemetry; the scheduler statistics are part of the metrics document
+void memoryTask() {
+    updateMemory();
+}
 
-    // Check for Serial input to set resistance (for testing purposes)
+// Task: check for Serial input to set resistance (for testing purposes)
+void serialInputTask() {
     if (Serial.available() > 0) {
         String input = Serial.readStringUntil('\n');
         input.trim(); // Remove whitespace and newlines
@@ -237,10 +174,86 @@ void loop() {
             Serial.println("Invalid value. Please enter a number between 0 and 255.");
         }
     }
+}
 
-    // Memory monitoring
-    if (currentMillis - previousMemoryCheck >= memoryCheckInterval) {
-        previousMemoryCheck = currentMillis;
-        printFreeMemory();
-    }
+void setup() {
+    beginBootPhase(BOOT_PHASE_LOGGING);
+    Serial.begin(115200);
+    setupLogging();
+    endBootPhase(BOOT_PHASE_LOGGING);
+
+    // Start connecting right away; the network task finishes WiFi, NTP, OTA and mDNS in the background
+    setupWiFi();
+
+    // Outputs first, so the heater and valves are in a defined state before anything else
+    beginBootPhase(BOOT_PHASE_SENSORS);
+    setupGPIO();
+    setupDHT();
+    setupDS18();
+    setupBME680();
+    mcp41hv51.begin();
+    endBootPhase(BOOT_PHASE_SENSORS);
+
+    beginBootPhase(BOOT_PHASE_INVENTORY);
+    setupInventory();
+    endBootPhase(BOOT_PHASE_INVENTORY);
+
+    beginBootPhase(BOOT_PHASE_CONTROL);
+
+    // Restore the stored targets and modes and load the sensor routing, then read initial sensor values and assign
+    // them to zones
+    setupSettings();
+    setupRouting();
+    sensorTask();
+
+    // Set up MQTT communication, the selected transport and the HTTP API
+    setupPublishing();
+    setupHistory();
+    setupMQTT();
+    setupTransport();
+    setupHTTP();
+
+    // Send sensor information once after initialization
+    getDS18SensorInfo();
+
+    // Determine the main temperature after initialization
+    determineMainTemperature();
+
+    // Set up servo motors and the PID valve controllers
+    setupServos();
+    setupPID();
+
+    // Register periodic tasks: name, callback, period, phase, deadline, priority (all times in ms)
+    controlScheduler.addTask("commands", processCommands, 0, 0, 0, 0);
+    controlScheduler.addTask("ds18", ds18Task, 50, 0, 20, 1);
+    controlScheduler.addTask("bme680", bme680Task, 50, 25, 20, 1);
+    controlScheduler.addTask("dht", dhtTask, 50, 10, 20, 1);
+    controlScheduler.addTask("heater", heaterTask, 5000, 1000, 100, 2);
+    controlScheduler.addTask("toggle", heaterToggleTask, 50, 0, 20, 2);
+    controlScheduler.addTask("servos", servoTask, 5000, 1050, 100, 3);
+    controlScheduler.addTask("sensors", sensorTask, 2000, 0, 1500, 4);
+    controlScheduler.addTask("telemetry", sendTelemetry, TELEMETRY_INTERVAL, 200, 50, 5);
+    controlScheduler.addTask("serial", serialInputTask, 100, 0, 50, 7);
+    controlScheduler.addTask("inventory", scanInventory, 100, 75, 50, 9);
+
+    networkScheduler.addTask("mqtt", mqttTask, 0, 0, 0, 0);
+    networkScheduler.addTask("publish", publishTask, 10000, 500, 1000, 5);
+    networkScheduler.addTask("keepalive", keepaliveTask, 30000, 0, 1000, 6);
+    networkScheduler.addTask("history", historyTask, 200, 100, 50, 7);
+    networkScheduler.addTask("memory", memoryTask, 5000, 2500, 100, 8);
+    networkScheduler.addTask("boot", bootReportTask, 1000, 0, 50, 9);
+    networkScheduler.addTask("metrics", metricsTask, 1000, 750, 50, 9);
+    networkScheduler.addTask("http", httpTask, TELEMETRY_INTERVAL, 300, 50, 6);
+    networkScheduler.addTask("settings", settingsTask, TELEMETRY_INTERVAL, 400, 100, 8);
+
+    // Run control on core 1 and networking on core 0; the PID task preempts the control task on core 1
+    startTasks();
+    startPIDTask();
+    startUpdateTask();
+    endBootPhase(BOOT_PHASE_CONTROL);
+}
+
+void loop() {
+    // All work runs in the tasks started by setup()
+    vTaskDelete(nullptr);
 }
@@ -0,0 +1,225 @@
+// Module: memory_module.cpp
+// Purpose: Samples the heap and the task stacks every few seconds and adds them to the metrics document as
+//          "memory": {"free": 151000, "min_free": 120000, "largest_block": 110592, "fragmentation": 0.27,
+//          "psram_total": 2097152, "psram_free": 1900000, "stacks": {"control": 3100, ...},
+//          "allocations": {"mqtt": [1523, 48211], ...}, "alerts": ["largest_block"]}.
+//          Allocations are [calls, bytes] since boot; the scheduler tags them with the running task.
+// Functions:
+// - updateMemory(): Samples internal RAM, PSRAM and stacks, raises and clears alerts with hysteresis.
+// - getMemoryStats(): Returns the latest sample.
+// - appendMemoryMetrics(): Serializes the sample, the stacks and the allocation counters.
+// - setAllocationTag(): Sets the tag of the calling task (MEMORY_TRACK_ALLOCATIONS only).
+// - __wrap_malloc(), __wrap_calloc(), __wrap_realloc(): Count the call, then allocate (MEMORY_TRACK_ALLOCATIONS only).
+
+
+#include "memory_module.h"
+#include "metrics_module.h"
+#include "log_module.h"
+#include <esp_heap_caps.h>
+
+// Tasks whose stacks are watched
+static const char* const stackTaskNames[] = {"control", "network", "pid", "update", "log_drain", "async_tcp"};
+static const int stackTaskCount = sizeof(stackTaskNames) / sizeof(stackTaskNames[0]);
+
+// Names of the alerts in the document, in flag order
+static const char* const alertNames[] = {"free", "largest_block", "fragmentation", "stack"};
+
+static TaskHandle_t stackTasks[stackTaskCount];
+static uint32_t stackFree[stackTaskCount];
+static MemoryStats memoryStats = {};
+
+#ifdef MEMORY_TRACK_ALLOCATIONS
+// Structure of the allocation counter of a tag; the tag is copied, as task names die with their task
+struct AllocationCounter {
+    char tag[configMAX_TASK_NAME_LEN];
+    uint32_t count;
+    uint32_t bytes;
+};
+
+// Structure of the tag set by a task
+struct TaskTag {
+    TaskHandle_t task;
+    const char* tag;
+};
+
+static const char otherTag[] = "other";
+static AllocationCounter allocationCounters[MEMORY_TAG_SLOTS];
+static TaskTag taskTags[MEMORY_TAGGED_TASKS];
+static portMUX_TYPE allocationMux = portMUX_INITIALIZER_UNLOCKED;
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* pointer, size_t size);
+
+// Function to set the tag of the calling task; nullptr returns to the task name
+void setAllocationTag(const char* tag) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&allocationMux);
+    for (int i = 0; i < MEMORY_TAGGED_TASKS; i++) {
+        if (taskTags[i].task == task || taskTags[i].task == nullptr) {
+            taskTags[i].task = task;
+            taskTags[i].tag = tag;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&allocationMux);
+}
+
+// Function to count an allocation under the tag of the calling task; the last slot collects the overflow
+static void countAllocation(size_t size) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL_SAFE(&allocationMux);
+    const char* tag = nullptr;
+    for (int i = 0; i < MEMORY_TAGGED_TASKS && taskTags[i].task != nullptr; i++) {
+        if (taskTags[i].task == task) {
+            tag = taskTags[i].tag;
+            break;
+        }
+    }
+    if (tag == nullptr) {
+        tag = task != nullptr ? pcTaskGetName(task) : otherTag;
+    }
+
+    AllocationCounter* counter = &allocationCounters[MEMORY_TAG_SLOTS - 1];
+    for (int i = 0; i < MEMORY_TAG_SLOTS - 1; i++) {
+        if (allocationCounters[i].tag[0] == '\0' || strncmp(allocationCounters[i].tag, tag, configMAX_TASK_NAME_LEN - 1) == 0) {
+            counter = &allocationCounters[i];
+            break;
+        }
+    }
+    if (counter->tag[0] == '\0') {
+        strncpy(counter->tag, counter == &allocationCounters[MEMORY_TAG_SLOTS - 1] ? otherTag : tag, configMAX_TASK_NAME_LEN - 1);
+    }
+    counter->count++;
+    counter->bytes += size;
+    portEXIT_CRITICAL_SAFE(&allocationMux);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    countAllocation(size);
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+    countAllocation(size);
+    return __real_realloc(pointer, size);
+}
+#endif
+
+// Function to raise or clear an alert flag; between the two limits the flag keeps its state
+static uint8_t updateAlert(uint8_t alerts, MemoryAlert flag, bool raise, bool clear) {
+    if (raise) {
+        return alerts | flag;
+    }
+    return clear ? alerts & ~flag : alerts;
+}
+
+// Function to sample the heap and stacks; runs on the network task
+void updateMemory() {
+    MemoryStats stats;
+    stats.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    stats.internalMinimumFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    stats.internalLargestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    stats.fragmentation = stats.internalFree > 0 ? 1.0f - (float)stats.internalLargestBlock / stats.internalFree : 1.0f;
+    stats.psramTotal = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+    stats.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    // Tasks are looked up by name until they exist; the high-water mark is in bytes on the ESP32
+    stats.lowestStackTask = nullptr;
+    stats.lowestStack = UINT32_MAX;
+    for (int i = 0; i < stackTaskCount; i++) {
+        if (stackTasks[i] == nullptr) {
+            stackTasks[i] = xTaskGetHandle(stackTaskNames[i]);
+        }
+        if (stackTasks[i] != nullptr) {
+            stackFree[i] = uxTaskGetStackHighWaterMark(stackTasks[i]);
+            if (stackFree[i] < stats.lowestStack) {
+                stats.lowestStack = stackFree[i];
+                stats.lowestStackTask = stackTaskNames[i];
+            }
+        }
+    }
+
+    uint8_t previous = memoryStats.alerts;
+    uint8_t alerts = previous;
+    alerts = updateAlert(alerts, MEMORY_ALERT_LOW_FREE, stats.internalFree < MEMORY_ALERT_FREE,
+                         stats.internalFree >= MEMORY_ALERT_FREE * MEMORY_ALERT_HYSTERESIS);
+    alerts = updateAlert(alerts, MEMORY_ALERT_LOW_BLOCK, stats.internalLargestBlock < MEMORY_ALERT_LARGEST_BLOCK,
+                         stats.internalLargestBlock >= MEMORY_ALERT_LARGEST_BLOCK * MEMORY_ALERT_HYSTERESIS);
+    alerts = updateAlert(alerts, MEMORY_ALERT_FRAGMENTED, stats.fragmentation > MEMORY_ALERT_FRAGMENTATION,
+                         stats.fragmentation <= MEMORY_ALERT_FRAGMENTATION / MEMORY_ALERT_HYSTERESIS);
+    alerts = updateAlert(alerts, MEMORY_ALERT_LOW_STACK, stats.lowestStack < MEMORY_ALERT_STACK,
+                         stats.lowestStack >= MEMORY_ALERT_STACK * MEMORY_ALERT_HYSTERESIS);
+    uint8_t raised = alerts & ~previous;
+    stats.alerts = alerts;
+    memoryStats = stats;
+
+    if (raised != 0) {
+        LOG_WARN(LOG_MODULE_MAIN, "Memory alert: free %lu, largest block %lu, lowest stack %lu (%s)",
+                 (unsigned long)stats.internalFree, (unsigned long)stats.internalLargestBlock,
+                 (unsigned long)stats.lowestStack, stats.lowestStackTask ? stats.lowestStackTask : "-");
+        publishMetrics(); // Do not wait for the next period; the next allocation failure may reboot
+    } else if (alerts == 0 && previous != 0) {
+        LOG_INFO(LOG_MODULE_MAIN, "Memory alerts cleared");
+    }
+    LOG_DEBUG(LOG_MODULE_MAIN, "Free heap %lu, largest block %lu, minimum %lu", (unsigned long)stats.internalFree,
+              (unsigned long)stats.internalLargestBlock, (unsigned long)stats.internalMinimumFree);
+}
+
+// Function to return the latest sample
+MemoryStats getMemoryStats() {
+    return memoryStats;
+}
+
+// Function to serialize the latest sample as "memory": {...}; returns the length snprintf would write
+size_t appendMemoryMetrics(char* buffer, size_t size) {
+    const MemoryStats &stats = memoryStats;
+    size_t length = snprintf(buffer, size,
+                             "\"memory\":{\"free\":%lu,\"min_free\":%lu,\"largest_block\":%lu,\"fragmentation\":%.2f,"
+                             "\"psram_total\":%lu,\"psram_free\":%lu,\"stacks\":{",
+                             (unsigned long)stats.internalFree, (unsigned long)stats.internalMinimumFree,
+                             (unsigned long)stats.internalLargestBlock, stats.fragmentation,
+                             (unsigned long)stats.psramTotal, (unsigned long)stats.psramFree);
+
+    bool first = true;
+    for (int i = 0; i < stackTaskCount && length < size; i++) {
+        if (stackTasks[i] != nullptr) {
+            length += snprintf(buffer + length, size - length, "%s\"%s\":%lu", first ? "" : ",",
+                               stackTaskNames[i], (unsigned long)stackFree[i]);
+            first = false;
+        }
+    }
+
+#ifdef MEMORY_TRACK_ALLOCATIONS
+    AllocationCounter counters[MEMORY_TAG_SLOTS];
+    portENTER_CRITICAL(&allocationMux);
+    memcpy(counters, allocationCounters, sizeof(counters));
+    portEXIT_CRITICAL(&allocationMux);
+
+    first = true;
+    length += length < size ? snprintf(buffer + length, size - length, "},\"allocations\":{") : 0;
+    for (int i = 0; i < MEMORY_TAG_SLOTS && length < size; i++) {
+        if (counters[i].count > 0) {
+            length += snprintf(buffer + length, size - length, "%s\"%s\":[%lu,%lu]", first ? "" : ",",
+                               counters[i].tag, (unsigned long)counters[i].count, (unsigned long)counters[i].bytes);
+            first = false;
+        }
+    }
+#endif
+
+    first = true;
+    length += length < size ? snprintf(buffer + length, size - length, "},\"alerts\":[") : 0;
+    for (int i = 0; i < 4 && length < size; i++) {
+        if (stats.alerts & (1 << i)) {
+            length += snprintf(buffer + length, size - length, "%s\"%s\"", first ? "" : ",", alertNames[i]);
+            first = false;
+        }
+    }
+    length += length < size ? snprintf(buffer + length, size - length, "]}") : 0;
+    return length;
+}
@@ -0,0 +1,73 @@
+// Module: memory_module.h
+// Purpose: Declares the memory telemetry: free and largest free block of internal RAM, fragmentation,
+//          PSRAM usage, stack high-water marks of the firmware tasks and, in builds with
+//          MEMORY_TRACK_ALLOCATIONS, allocation counts per task and scheduler task. The values are part of the
+//          metrics document; crossing a threshold raises an alert and publishes the document at once.
+// Definitions:
+// - MEMORY_TRACK_ALLOCATIONS: Build flag; counts malloc/calloc/realloc calls, needs
+//   -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc.
+// - MEMORY_TAG_SLOTS: Distinct allocation tags counted; further tags count as "other".
+// - MEMORY_TAGGED_TASKS: Tasks that can set their own tag; other tasks count under their task name.
+// - MEMORY_ALERT_FREE, MEMORY_ALERT_LARGEST_BLOCK, MEMORY_ALERT_FRAGMENTATION, MEMORY_ALERT_STACK:
+//   Alert thresholds.
+// - MEMORY_ALERT_HYSTERESIS: Factor by which a value must recover before its alert clears.
+// - SET_ALLOCATION_TAG(): Attributes the following allocations of the calling task to a tag
+//   (nullptr: the task name); compiles to nothing without MEMORY_TRACK_ALLOCATIONS.
+// Enumerations:
+// - MemoryAlert: Alert flags.
+// Structures:
+// - MemoryStats: Latest sample.
+// Function Prototypes:
+// - updateMemory(): Samples the heap and stacks and evaluates the alerts (network task).
+// - getMemoryStats(): Returns the latest sample.
+// - appendMemoryMetrics(): Serializes the sample into the metrics document.
+
+
+#ifndef MEMORY_MODULE_H
+#define MEMORY_MODULE_H
+
+#include <Arduino.h>
+
+#define MEMORY_TAG_SLOTS 24
+#define MEMORY_TAGGED_TASKS 4
+#define MEMORY_ALERT_FREE 32768             // Free internal RAM below (in bytes)
+#define MEMORY_ALERT_LARGEST_BLOCK 16384    // Largest free internal block below (in bytes)
+#define MEMORY_ALERT_FRAGMENTATION 0.6f     // 1 - largest block / free above
+#define MEMORY_ALERT_STACK 512              // Unused stack of any task below (in bytes)
+#define MEMORY_ALERT_HYSTERESIS 1.25f
+
+#ifdef MEMORY_TRACK_ALLOCATIONS
+void setAllocationTag(const char* tag);
+#define SET_ALLOCATION_TAG(tag) setAllocationTag(tag)
+#else
+#define SET_ALLOCATION_TAG(tag) ((void)0)
+#endif
+
+// Enumeration of the alert flags
+enum MemoryAlert : uint8_t {
+    MEMORY_ALERT_NONE = 0,
+    MEMORY_ALERT_LOW_FREE = 1,
+    MEMORY_ALERT_LOW_BLOCK = 2,
+    MEMORY_ALERT_FRAGMENTED = 4,
+    MEMORY_ALERT_LOW_STACK = 8
+};
+
+// Structure of a memory sample
+struct MemoryStats {
+    uint32_t internalFree;
+    uint32_t internalMinimumFree;   // Lowest free internal RAM since boot
+    uint32_t internalLargestBlock;
+    float fragmentation;            // 1 - largest block / free, 0 for an unfragmented heap
+    uint32_t psramTotal;            // 0 without PSRAM
+    uint32_t psramFree;
+    const char* lowestStackTask;    // Task with the least unused stack
+    uint32_t lowestStack;           // (in bytes)
+    uint8_t alerts;                 // MemoryAlert flags
+};
+
+// Function prototypes
+void updateMemory();
+MemoryStats getMemoryStats();
+size_t appendMemoryMetrics(char* buffer, size_t size);
+
+#endif // MEMORY_MODULE_H
@@ -1,12 +1,19 @@
 // Module: message_module.cpp
 // Purpose: Handles MQTT communication, including connecting to the broker, subscribing to topics, publishing messages, and processing incoming messages.
 // Functions:
-// - setupMQTT(): Initializes the MQTT client and connects to the broker.
-// - reconnectMQTT(): Reconnects to the MQTT broker if the connection is lost.
-// - setupMQTTSubscription(): Subscribes to necessary MQTT topics for control and updates.
+// - setupMQTT(): Initializes the MQTT client; the first connection attempt is made by serviceMQTT().
+// - serviceMQTT(): Connection state machine; reconnects with exponential backoff and jitter, runs the
+//   client and flushes the outbound queue while connected. Never blocks longer than the connect timeouts.
+//   Once the queue has drained after it dropped messages, every value is sent again.
+// - isMQTTConnected(): Returns whether the broker connection is up.
+// - disconnectMQTT(): Closes the broker connection when another transport is selected.
+// - setupMQTTSubscription(): Subscribes to the wildcard topic covering all control and update topics.
 // - sendKeepalive(): Sends a keepalive message to maintain subscriptions.
-// - handleMQTTMessage(): Processes incoming MQTT messages and updates system state accordingly.
-// - sendMessage(): Sends messages via MQTT, Telnet, or ESP logging based on priority and debug settings.
+// - handleMQTTMessage(): Routes incoming MQTT messages through the topic registry.
+// - handleInboundMessage(): Processes a message routed by the registry (MQTT topic or Signal K path) and updates
+//   system state accordingly.
+// - publishMessage(): Publishes a message right away if connected; for senders that keep their own retry state.
+// - sendMessage(): Queues messages for MQTT, or logs them to Telnet and Serial, based on priority and debug settings.
 
 
 #include "message_module.h"
@@ -14,246 +21,298 @@
 #include <ESPmDNS.h>
 #include "data_module.h"
 #include "gpio_module.h"
-#include "i2c.h"
-#include "ds18_module.h"
+#include "inventory_module.h"
+#include "boot_module.h"
+#include "metrics_module.h"
 #include "firmware_update_module.h"
-#include "esp_log.h" // Include ESP32 logging
-
-static const char* TAG = "message_module"; // Define logging tag
+#include "topic_module.h"
+#include "publish_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+#include "routing_module.h"
+#include "pid_module.h"
+#include "history_module.h"
+#include "transport_module.h"
+#include "zone_descriptors.h"
 
 WiFiClient wifiClient;
 PubSubClient mqttClient(wifiClient);
 String clientId = "heatercontroller";
 
+// Connection state, owned by the network task
+static bool mqttConnected = false;
+static unsigned long nextConnectAttempt = 0;
+static unsigned long connectBackoff = MQTT_BACKOFF_MIN;
+static uint32_t droppedSeen = 0;    // Outbox drops already answered with resendAllData()
+
 // Function to set up MQTT communication
 void setupMQTT() {
+    setupTopics();
     mqttClient.setServer(MQTT_HOST, MQTT_PORT);
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+    mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
     mqttClient.setCallback(handleMQTTMessage);
-    reconnectMQTT();
-    setupMQTTSubscription();
-    sendKeepalive();
-
-    // Send the target temperatures after startup
-    for (int i = 0; i < 10; i++) {
-        if (strlen(zones[i].name) > 0 && !isnan(zones[i].temperatureTarget)) {
-            String path = String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/target_temperature";
-            sendMessage(String(zones[i].temperatureTarget), path, 1);
+    nextConnectAttempt = millis();
+
+    // Queue the target temperatures; they are sent once the broker is reachable
+    char value[16];
+    for (uint8_t i : activeZones) {
+        if (zoneState.targetValid & ZONE_BIT(i)) {
+            snprintf(value, sizeof(value), "%.2f", getZoneTarget(i));
+            queueMessage(getZoneTopic(i, ZONE_TOPIC_TARGET_TEMPERATURE), value, true, OUTBOX_PRIORITY_VALUE);
         }
     }
 }
 
-// Function to reconnect to the MQTT broker
-void reconnectMQTT() {
-    if (!mqttClient.connected()) {
-        sendMessage("Connecting to MQTT...", "debug", 6);
-        if (mqttClient.connect(clientId.c_str(), MQTT_USER, MQTT_PASS)) {
-            sendMessage("MQTT connected", "debug", 6);
-            setupMQTTSubscription();
-            sendKeepalive();
-        } else {
-            sendMessage("MQTT connection failed with state " + String(mqttClient.state()), "debug", 6);
-        }
+// Function to make one connection attempt; the TCP connect and the CONNACK wait are bounded
+static bool connectMQTT() {
+    if (!wifiClient.connected() && !wifiClient.connect(MQTT_HOST, MQTT_PORT, MQTT_CONNECT_TIMEOUT)) {
+        return false;
+    }
+    // PubSubClient reuses the open socket and only sends CONNECT
+    if (!mqttClient.connect(clientId.c_str(), MQTT_USER, MQTT_PASS)) {
+        wifiClient.stop();
+        return false;
     }
+    return true;
 }
 
-// Function to set up MQTT subscriptions
-void setupMQTTSubscription() {
-    // Subscribe to heater automation mode topic
-    String heaterAutomationModeTopic = "N/" + String(MQTT_BASE_PATH) + "/heater_automation_mode";
-    mqttClient.subscribe(heaterAutomationModeTopic.c_str(), 1); // Set QoS to 1
-    sendMessage("Subscribed to topic: " + heaterAutomationModeTopic, "debug", 6);
-
-    // Subscribe to valve mode topic
-    String valveModeTopic = "N/" + String(MQTT_BASE_PATH) + "/valve_mode";
-    mqttClient.subscribe(valveModeTopic.c_str(), 1); // Set QoS to 1
-    sendMessage("Subscribed to topic: " + valveModeTopic, "debug", 6);
-
-    // Subscribe to target temperature topics for each zone
-    for (int i = 0; i < 10; i++) {
-        if (strlen(zones[i].name) > 0) {
-            String topic = "N/" + String(MQTT_BASE_PATH) + "/" + String(zones[i].name) + "/target_temperature";
-            mqttClient.subscribe(topic.c_str(), 1); // Set QoS to 1
-            sendMessage("Subscribed to topic: " + topic, "debug", 6);
+// Function to keep the broker connection and the outbound queue moving; runs on every network task pass
+void serviceMQTT() {
+    if (mqttClient.connected()) {
+        uint32_t probe = beginProbe();
+        mqttClient.loop();
+        endProbe(METRIC_MQTT_LOOP, probe);
+        flushOutbox(publishMessage);
+        // A dropped value counts as sent in the change tracking and would not be sent again until it changes
+        OutboxStats stats = getOutboxStats();
+        if (stats.dropped != droppedSeen && stats.queued == 0) {
+            droppedSeen = stats.dropped;
+            resendAllData();
+            LOG_INFO(LOG_MODULE_MQTT, "Outbox dropped messages, sending all values again");
         }
+        return;
+    }
+
+    if (mqttConnected) {
+        mqttConnected = false;
+        connectBackoff = MQTT_BACKOFF_MIN;
+        nextConnectAttempt = millis() + random(connectBackoff);
+        LOG_WARN(LOG_MODULE_MQTT, "MQTT connection lost (state %d)", mqttClient.state());
+    }
+    if (WiFi.status() != WL_CONNECTED || (long)(millis() - nextConnectAttempt) < 0) {
+        return;
     }
 
-    // Subscribe to heater toggle topic
-    String heaterToggleTopic = "N/" + String(MQTT_BASE_PATH) + "/toggle";
-    mqttClient.subscribe(heaterToggleTopic.c_str(), 1); // Set QoS to 1
-    sendMessage("Subscribed to topic: " + heaterToggleTopic, "debug", 6);
+    if (connectMQTT()) {
+        mqttConnected = true;
+        connectBackoff = MQTT_BACKOFF_MIN;
+        endBootPhase(BOOT_PHASE_MQTT);
+        OutboxStats stats = getOutboxStats();
+        LOG_INFO(LOG_MODULE_MQTT, "MQTT connected, %d queued, %lu dropped", stats.queued, (unsigned long)stats.dropped);
+        setupMQTTSubscription();
+        sendKeepalive();
+        flushOutbox(publishMessage);
+    } else {
+        // Exponential backoff with jitter, so several devices do not retry in lockstep after a broker restart
+        nextConnectAttempt = millis() + connectBackoff / 2 + random(connectBackoff / 2 + 1);
+        LOG_DEBUG(LOG_MODULE_MQTT, "MQTT connection failed (state %d), retry in %lu ms",
+                  mqttClient.state(), nextConnectAttempt - millis());
+        connectBackoff = min(connectBackoff * 2, (unsigned long)MQTT_BACKOFF_MAX);
+    }
+}
 
-    // Subscribe to sensor ID request topic
-    String sensorIDsRequestTopic = "N/" + String(MQTT_BASE_PATH) + "/sensor_ids_request";
-    mqttClient.subscribe(sensorIDsRequestTopic.c_str(), 1); // Set QoS to 1
-    sendMessage("Subscribed to topic: " + sensorIDsRequestTopic, "debug", 6);
+// Function to check whether the broker connection is up
+bool isMQTTConnected() {
+    return mqttConnected && mqttClient.connected();
+}
+
+// Function to close the broker connection; serviceMQTT() connects again when it is called
+void disconnectMQTT() {
+    if (mqttClient.connected()) {
+        mqttClient.disconnect();
+    }
+    wifiClient.stop();
+    mqttConnected = false;
+    connectBackoff = MQTT_BACKOFF_MIN;
+    nextConnectAttempt = millis();
+}
 
-    // Subscribe to firmware update topic
-    String firmwareUpdateTopic = "N/" + String(MQTT_BASE_PATH) + "/firmware_update";
-    mqttClient.subscribe(firmwareUpdateTopic.c_str(), 1); // Set QoS to 1
-    sendMessage("Subscribed to topic: " + firmwareUpdateTopic, "debug", 6);
+// Function to set up MQTT subscriptions
+void setupMQTTSubscription() {
+    // One wildcard subscription; messages are routed locally through the topic registry
+    mqttClient.subscribe(getSubscriptionTopic(), 1); // Set QoS to 1
+    LOG_DEBUG(LOG_MODULE_MQTT, "Subscribed to topic: %s", getSubscriptionTopic());
 }
 
 // Function to send a keepalive message
 void sendKeepalive() {
-    String topic = "R/signalk/" + String(SYSTEM_ID) + "/keepalive";
-    String payload = "[\"vessels/self/heater/+/target_temperature\", \"vessels/self/heater/toggle\", \"vessels/self/heater/heater_automation_mode\", \"vessels/self/heater/valve_mode\"]";
-    mqttClient.publish(topic.c_str(), payload.c_str(), true);
-    sendMessage("Sent keepalive to topic: " + topic, "debug", 6);
+    static const char* payload = "[\"vessels/self/heater/+/target_temperature\", \"vessels/self/heater/toggle\", \"vessels/self/heater/heater_automation_mode\", \"vessels/self/heater/valve_mode\"]";
+    if (mqttClient.connected()) {
+        mqttClient.publish(getOutboundTopic(TOPIC_KEEPALIVE), payload, true);
+    }
 }
 
 // Callback function to handle incoming MQTT messages
 void handleMQTTMessage(char* topic, byte* payload, unsigned int length) {
-    // Convert payload to String
-    String message = "";
-    for (unsigned int i = 0; i < length; i++) {
-        message += (char)payload[i];
+    // Route the topic through the registry; topics without a handler are ignored
+    const InboundTopic* route = findInboundTopic(topic);
+    if (route != nullptr) {
+        handleInboundMessage(route, payload, length);
     }
-    message.trim();
-
-    // Output received message
-    sendMessage("Received MQTT message on topic: " + String(topic), "debug", 6);
-    sendMessage("Received payload: " + message, "debug", 6);
-
-    // Parse JSON payload
-    DynamicJsonDocument doc(256);
-
-    // Handle firmware update request
-    String firmwareUpdateTopic = "N/" + String(MQTT_BASE_PATH) + "/firmware_update";
-    if (String(topic) == firmwareUpdateTopic) {
-        DeserializationError error = deserializeJson(doc, message);
-        if (error) {
-            sendMessage("Failed to parse JSON payload", "debug", 6);
-            return;
-        }
+}
 
-        const char* updateUrl = doc["url"];
-        if (updateUrl != nullptr && String(updateUrl).startsWith("http")) {
-            sendMessage("Firmware update URL received: " + String(updateUrl), "debug", 6);
-            checkForFirmwareUpdate(String(updateUrl).c_str(), 0);
+// Function to process a routed message; the payload is JSON like {"value": 21.5} or a plain value
+void handleInboundMessage(const InboundTopic* route, const uint8_t* payload, unsigned int length) {
+    // Queue a firmware update for the updater task, e.g. {"url": "https://...", "sha256": "9f86d0..."}
+    if (route->handler == HANDLER_FIRMWARE_UPDATE) {
+        static char updateUrl[UPDATE_URL_SIZE];
+        static char updateHash[72];
+        if (findPayloadString(payload, length, "url", updateUrl, sizeof(updateUrl)) &&
+            findPayloadString(payload, length, "sha256", updateHash, sizeof(updateHash))) {
+            requestFirmwareUpdate(updateUrl, updateHash);
         } else {
-            sendMessage("Invalid firmware update URL in payload. Ensure it starts with 'http'.", "debug", 6);
+            LOG_WARN(LOG_MODULE_UPDATE, "Firmware update payload needs \"url\" and \"sha256\"");
         }
+        return;
+    }
 
+    // Answer sensor ID requests from the cached device inventory
+    if (route->handler == HANDLER_SENSOR_IDS_REQUEST) {
+        publishMessage(getOutboundTopic(TOPIC_SENSOR_IDS_RESPONSE), getInventoryJson(), false);
         return;
     }
 
-    DeserializationError error = deserializeJson(doc, message);
-    if (error) {
-        sendMessage("Failed to parse JSON payload", "debug", 6);
+    // Start a backfill of recorded values, see requestHistory() for the format
+    if (route->handler == HANDLER_HISTORY_REQUEST) {
+        requestHistory(payload, length);
         return;
     }
 
-    // Extract value from JSON
-    float value = doc["value"].as<float>();
-
-    // Handle heater toggle message
-    String heaterToggleTopic = "N/" + String(MQTT_BASE_PATH) + "/toggle";
-    if (String(topic) == heaterToggleTopic) {
-        if (value == 1) {
-            toggleHeater(true);
-            sendMessage("Heater toggled ON", "debug", 6);
-        } else if (value == 0) {
-            toggleHeater(false);
-            sendMessage("Heater toggled OFF", "debug", 6);
-        }
+    // Publish the stage latency metrics right away
+    if (route->handler == HANDLER_METRICS_REQUEST) {
+        publishMetrics();
         return;
     }
 
-    // Handle heater automation mode message
-    String heaterAutomationModeTopic = "N/" + String(MQTT_BASE_PATH) + "/heater_automation_mode";
-    if (String(topic) == heaterAutomationModeTopic) {
-        if (value == 1) {
-            automationActive = true;
-            sendMessage("Heater automation mode set to ON", "debug", 6);
-        } else if ((value == 0)) {
-            automationActive = false;
-            sendMessage("Heater automation mode set to OFF", "debug", 6);
+    // Change the PID gains of a zone, e.g. {"kp": 30, "ki": 0.02, "kd": 0, "slew": 5}
+    if (route->handler == HANDLER_PID_GAINS) {
+        PIDGains gains = getPIDGains(route->zone);
+        if (parsePIDGains(payload, length, gains)) {
+            setPIDGains(route->zone, gains);
         } else {
-            sendMessage("Invalid heater automation mode command: " + message, "debug", 6);
+            LOG_WARN(LOG_MODULE_SERVO, "Invalid PID gains payload on topic: %s", route->topic);
         }
         return;
     }
 
-    // Handle valve mode message
-    String valveModeTopic = "N/" + String(MQTT_BASE_PATH) + "/valve_mode";
-    if (String(topic) == valveModeTopic) {
-        if (value == 1) {
-            valveModeProportional = true;
-            sendMessage("Valve mode set to PROPORTIONAL", "debug", 6);
-        } else if (value == 0) {
-            valveModeProportional = false;
-            sendMessage("Valve mode set to ON/OFF", "debug", 6);
-        } else {
-            sendMessage("Invalid valve mode command: " + message, "debug", 6);
-        }
+    // Extract value from the payload
+    float value;
+    if (!findPayloadNumber(payload, length, "value", value)) {
+        LOG_WARN(LOG_MODULE_MQTT, "Failed to parse payload on topic: %s", route->topic);
         return;
     }
 
-    // Handle sensor ID request
-    String sensorIDsRequestTopic = "N/" + String(MQTT_BASE_PATH) + "/sensor_ids_request";
-    if (String(topic) == sensorIDsRequestTopic) {
-        String sensorIDs = "";
-        for (int i = 0; i < BME680_SENSOR_COUNT; i++) {
-            if (bme680Sensors[i].begin(bme680Addresses[i])) {
-                sensorIDs += "BME680 Sensor " + String(i) + ": " + String(bme680Addresses[i], HEX) + "; ";
+    switch (route->handler) {
+        // Handle heater toggle message
+        case HANDLER_TOGGLE:
+            if (value == 1 || value == 0) {
+                sendCommand(CMD_TOGGLE_HEATER, -1, value);
+                LOG_DEBUG(LOG_MODULE_HEATER, "Heater toggle %s requested", value == 1 ? "ON" : "OFF");
+            }
+            break;
+
+        // Handle heater automation mode message
+        case HANDLER_AUTOMATION_MODE:
+            if (value == 1 || value == 0) {
+                sendCommand(CMD_SET_AUTOMATION, -1, value);
+                LOG_DEBUG(LOG_MODULE_HEATER, "Heater automation mode set to %s", value == 1 ? "ON" : "OFF");
+            } else {
+                LOG_WARN(LOG_MODULE_HEATER, "Invalid heater automation mode command: %.2f", value);
             }
+            break;
+
+        // Handle valve mode message
+        case HANDLER_VALVE_MODE:
+            if (value == 1 || value == 0) {
+                sendCommand(CMD_SET_VALVE_MODE, -1, value);
+                LOG_DEBUG(LOG_MODULE_SERVO, "Valve mode set to %s", value == 1 ? "PROPORTIONAL" : "ON/OFF");
+            } else {
+                LOG_WARN(LOG_MODULE_SERVO, "Invalid valve mode command: %.2f", value);
+            }
+            break;
+
+        // Process target temperature messages
+        case HANDLER_TARGET_TEMPERATURE:
+            sendCommand(CMD_SET_TARGET, route->zone, value);
+            break;
+
+        // Switch between per-topic publishing (0) and batched Signal K deltas (1)
+        case HANDLER_PUBLISH_MODE:
+            publishMode = value == 1 ? PUBLISH_DELTA : PUBLISH_TOPICS;
+            resendAllData();
+            LOG_INFO(LOG_MODULE_MQTT, "Publish mode set to %s", publishMode == PUBLISH_DELTA ? "DELTA" : "TOPICS");
+            break;
+
+        // Switch between the MQTT (0) and Signal K WebSocket (1) transports
+        case HANDLER_TRANSPORT:
+            if (value == 1 || value == 0) {
+                requestTransport(value == 1 ? TRANSPORT_SIGNALK : TRANSPORT_MQTT);
+            }
+            break;
+
+        // Change the log level of a module, e.g. {"module": "servo", "value": 4}
+        case HANDLER_LOG_LEVEL: {
+            char moduleName[16];
+            int module = findPayloadString(payload, length, "module", moduleName, sizeof(moduleName)) ? findLogModule(moduleName) : -1;
+            if (module >= 0) {
+                setLogLevel((LogModule)module, (LogLevel)(int)value);
+            } else {
+                for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+                    setLogLevel((LogModule)i, (LogLevel)(int)value);
+                }
+            }
+            break;
         }
-        for (int i = 0; i < numConnectedSensors; i++) {
-            sensorIDs += "DS18 Sensor " + String(i) + ": ";
-            for (uint8_t j = 0; j < 8; j++) {
-                sensorIDs += String(connectedAddresses[i][j], HEX);
+
+        // Replace the sensor routing table, see parseRoutingTable() for the format
+        case HANDLER_SENSOR_ROUTING: {
+            static RoutingTable table;
+            if (parseRoutingTable(payload, length, table)) {
+                requestRoutingUpdate(table);
             }
-            sensorIDs += "; ";
+            break;
         }
-        sendMessage(sensorIDs, "W/" + String(MQTT_BASE_PATH) + "/sensor_ids_response", 1);
-        return;
-    }
 
-    // Process target temperature messages
-    if (String(topic).endsWith("/target_temperature")) {
-        sendMessage("Processing target temperature payload: " + String(value), "debug", 6);
-        processIncomingData(String(topic), String(value));
+        default:
+            break;
     }
 }
 
-// Function to send messages via MQTT, Telnet, or ESP logging based on priority
-void sendMessage(const String &message, const String &path, int priority) {
-
-    if (DEBUG_MODE) {
-        esp_log_level_set(TAG, ESP_LOG_DEBUG);
-    } else {
-        esp_log_level_set(TAG, ESP_LOG_WARN);
+// Function to publish a message right away; returns false if it was not handed to the client
+bool publishMessage(const char* topic, const char* payload, bool retained) {
+    if (topic == nullptr || !mqttClient.connected()) {
+        return false;
     }
+    return mqttClient.publish(topic, payload, retained);
+}
 
+// Function to send messages via MQTT, Telnet, or Serial logging based on priority
+void sendMessage(const String &message, const String &path, int priority) {
     if (priority >= 6 && !DEBUG_MODE) {
         return;  // Skip debug messages if DEBUG_MODE is off
     }
 
-    // MQTT output
+    // MQTT output through the outbound queue, so callers on any task never wait for the broker
     if (priority == 1 || priority == 2) {
-        if (!mqttClient.connected()) {
-            reconnectMQTT();
-            sendMessage("MQTT not connected. Debug message sent.", "debug", 6);
-        }
-        if (mqttClient.connected()) {
-            String modifiedPath = "W/" + path;
-            mqttClient.publish(modifiedPath.c_str(), message.c_str(), true);  // Set retain flag and QoS to 1
-        }
+        String modifiedPath = "W/" + path;
+        queueMessage(modifiedPath.c_str(), message.c_str(), true, OUTBOX_PRIORITY_INFO);  // Retained
     }
 
     if (priority == 1) {
         return;
     }
 
-    // Telnet output
-    if (priority == 2 || priority == 6) {
-        if (TelnetStream.available()) {
-            TelnetStream.println(message);
-        }
-    }
-
-    // Use ESP32 logging
-    if (priority == 6) {
-        ESP_LOGI(TAG, "%s", message.c_str());  // Info-level log
-    }
+    // Telnet and Serial output through the asynchronous log
+    logText(priority >= 6 ? LEVEL_DEBUG : LEVEL_INFO, LOG_MODULE_MAIN, message.c_str());
 }
@@ -6,10 +6,14 @@
 // Function Prototypes:
 // - sendMessage()
 // - setupMQTT()
-// - reconnectMQTT()
+// - serviceMQTT()
+// - isMQTTConnected()
+// - disconnectMQTT()
 // - setupMQTTSubscription()
 // - handleMQTTMessage()
+// - handleInboundMessage()
 // - sendKeepalive()
+// - publishMessage()
 
 
 #ifndef MESSAGE_MODULE_H
@@ -21,6 +25,14 @@
 #include <PubSubClient.h>
 #include <TelnetStream.h>
 #include <ArduinoJson.h>
+#include "outbox_module.h"
+#include "topic_module.h"
+
+#define MQTT_BUFFER_SIZE 4096 // MQTT packet buffer, large enough for a Signal K delta
+#define MQTT_BACKOFF_MIN 1000       // First reconnect delay (in ms), doubled after every failure
+#define MQTT_BACKOFF_MAX 60000      // Longest reconnect delay (in ms)
+#define MQTT_CONNECT_TIMEOUT 1000   // Bound of the TCP connect (in ms)
+#define MQTT_SOCKET_TIMEOUT 2       // Bound of the wait for CONNACK (in s)
 
 // External declarations for WiFi and MQTT clients
 extern WiFiClient wifiClient;
@@ -29,9 +41,13 @@ extern PubSubClient mqttClient;
 // Function prototypes
 void sendMessage(const String &message, const String &path, int priority);
 void setupMQTT();
-void reconnectMQTT();
+void serviceMQTT();
+bool isMQTTConnected();
+void disconnectMQTT();
 void setupMQTTSubscription();
 void handleMQTTMessage(char* topic, byte* payload, unsigned int length);
+void handleInboundMessage(const InboundTopic* route, const uint8_t* payload, unsigned int length);
 void sendKeepalive();
+bool publishMessage(const char* topic, const char* payload, bool retained = true);
 
 #endif
@@ -0,0 +1,151 @@
+// Module: metrics_module.cpp
+// Purpose: Keeps a cycle-count histogram per stage since boot and publishes them as
+//          {"mhz": 240, "stages": {"read_dht": {"n": 1200, "min": 1.21, "p50": 2.06, "p99": 4.38, "max": 7.93}, ...}}
+//          with all times in microseconds. Stages that never ran are left out. The memory telemetry of
+//          memory_module, the NVS write statistics of settings_module and the statistics of both schedulers
+//          ("schedulers": {"control": {"heater": [runs, overruns, skipped, average us, max us], ...},
+//          "network": {...}}) follow the stages.
+// Functions:
+// - endProbe(): Adds the elapsed cycles to the histogram of a stage.
+// - getStageSummary(): Walks the histogram; percentiles are bucket midpoints clamped to min and max.
+// - publishMetrics(): Serializes the summaries and publishes them to the metrics topic.
+// - metricsTask(): Publishes the document every METRICS_INTERVAL.
+
+
+#include "metrics_module.h"
+#include "message_module.h"
+#include "topic_module.h"
+#include "memory_module.h"
+#include "settings_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+
+// Structure of the histogram of a stage; written only by the task running the stage
+struct StageHistogram {
+    uint32_t count;
+    uint32_t min;           // (in cycles)
+    uint32_t max;
+    uint32_t buckets[METRICS_BUCKETS];
+};
+
+// Names of the stages in the document
+static const char* const stageNames[METRIC_STAGE_COUNT] = {
+    "dht_step", "ds18_step", "bme680_step", "read_dht", "read_ds18", "read_bme680",
+    "heater", "servos", "pid", "mqtt_loop", "signalk_loop", "publish", "history"
+};
+
+static StageHistogram histograms[METRIC_STAGE_COUNT];
+static unsigned long lastMetrics = 0;
+
+// Function to map a cycle count to its bucket: values below 4 map to themselves, larger values to
+// 4 * (octave - 1) + the two bits after the leading one
+static inline int bucketIndex(uint32_t cycles) {
+    if (cycles < 4) {
+        return cycles;
+    }
+    int msb = 31 - __builtin_clz(cycles);
+    return (msb - 1) * 4 + ((cycles >> (msb - 2)) & 3);
+}
+
+// Function to return the midpoint of a bucket in cycles
+static float bucketMidpoint(int index) {
+    if (index < 4) {
+        return index;
+    }
+    int msb = index / 4 + 1;
+    uint32_t lower = (uint32_t)(4 + index % 4) << (msb - 2);
+    return lower + ((1UL << (msb - 2)) - 1) / 2.0f;
+}
+
+// Function to record the duration of a stage
+void endProbe(MetricStage stage, uint32_t start) {
+    uint32_t cycles = ESP.getCycleCount() - start;
+    StageHistogram &histogram = histograms[stage];
+    if (histogram.count == 0 || cycles < histogram.min) {
+        histogram.min = cycles;
+    }
+    if (cycles > histogram.max) {
+        histogram.max = cycles;
+    }
+    histogram.buckets[bucketIndex(cycles)]++;
+    histogram.count++;
+}
+
+// Function to summarize a stage; reads the histogram without a lock, so a summary taken while the
+// stage runs may be off by one sample
+StageSummary getStageSummary(MetricStage stage) {
+    const StageHistogram &histogram = histograms[stage];
+    StageSummary summary = {histogram.count, 0, 0, 0, 0};
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    float cyclesPerMicrosecond = ESP.getCpuFreqMHz();
+    float minimum = histogram.min;
+    float maximum = histogram.max;
+    uint32_t p50Rank = (summary.count + 1) / 2;
+    uint32_t p99Rank = summary.count - summary.count / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS && seen < p99Rank; i++) {
+        uint32_t previous = seen;
+        seen += histogram.buckets[i];
+        if (previous < p50Rank && seen >= p50Rank) {
+            summary.p50 = constrain(bucketMidpoint(i), minimum, maximum) / cyclesPerMicrosecond;
+        }
+        if (seen >= p99Rank) {
+            summary.p99 = constrain(bucketMidpoint(i), minimum, maximum) / cyclesPerMicrosecond;
+        }
+    }
+    summary.min = minimum / cyclesPerMicrosecond;
+    summary.max = maximum / cyclesPerMicrosecond;
+    return summary;
+}
+
+// Function to publish the summaries of all stages; returns false if the message was not sent
+bool publishMetrics() {
+    static char document[METRICS_DOCUMENT_SIZE];
+    size_t length = snprintf(document, sizeof(document), "{\"mhz\":%lu,\"stages\":{", (unsigned long)ESP.getCpuFreqMHz());
+    bool first = true;
+    for (int i = 0; i < METRIC_STAGE_COUNT && length < sizeof(document); i++) {
+        StageSummary summary = getStageSummary((MetricStage)i);
+        if (summary.count == 0) {
+            continue;
+        }
+        length += snprintf(document + length, sizeof(document) - length,
+                           "%s\"%s\":{\"n\":%lu,\"min\":%.2f,\"p50\":%.2f,\"p99\":%.2f,\"max\":%.2f}",
+                           first ? "" : ",", stageNames[i], (unsigned long)summary.count,
+                           summary.min, summary.p50, summary.p99, summary.max);
+        first = false;
+    }
+    if (length + 2 < sizeof(document)) {
+        length += snprintf(document + length, sizeof(document) - length, "},");
+        length += appendMemoryMetrics(document + length, sizeof(document) - length);
+    }
+    if (length + 2 < sizeof(document)) {
+        length += snprintf(document + length, sizeof(document) - length, ",");
+        length += appendSettingsMetrics(document + length, sizeof(document) - length);
+    }
+    if (length + 2 < sizeof(document)) {
+        length += snprintf(document + length, sizeof(document) - length, ",\"schedulers\":{\"control\":");
+        length += length < sizeof(document) ? controlScheduler.appendStats(document + length, sizeof(document) - length) : 0;
+    }
+    if (length + 2 < sizeof(document)) {
+        length += snprintf(document + length, sizeof(document) - length, ",\"network\":");
+        length += length < sizeof(document) ? networkScheduler.appendStats(document + length, sizeof(document) - length) : 0;
+        length += length < sizeof(document) ? snprintf(document + length, sizeof(document) - length, "}") : 0;
+    }
+    if (length + 2 > sizeof(document)) {
+        LOG_ERROR(LOG_MODULE_MAIN, "Metrics document does not fit the buffer");
+        return false;
+    }
+    strcat(document, "}");
+    return publishMessage(getOutboundTopic(TOPIC_METRICS), document, false);
+}
+
+// Task: publish the metrics document periodically
+void metricsTask() {
+    unsigned long now = millis();
+    if (now - lastMetrics >= METRICS_INTERVAL && publishMetrics()) {
+        lastMetrics = now;
+    }
+}
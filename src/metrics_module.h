@@ -0,0 +1,68 @@
+// Module: metrics_module.h
+// Purpose: Declares the stage latency instrumentation. A probe reads the CPU cycle counter before and
+//          after a stage and counts the duration in a fixed log-linear histogram (4 buckets per power of
+//          two, at most 19 % wide), so a probe costs a few dozen cycles and stays enabled in production.
+// Definitions:
+// - METRICS_BUCKETS: Histogram buckets per stage, covering the full 32-bit cycle range.
+// - METRICS_INTERVAL: Period of the metrics document.
+// - METRICS_DOCUMENT_SIZE: Size of the serialized document.
+// Enumerations:
+// - MetricStage: Instrumented stages.
+// Structures:
+// - StageSummary: Count, min, p50, p99 and max of a stage in microseconds.
+// Function Prototypes:
+// - beginProbe(): Returns the cycle counter at the start of a stage.
+// - endProbe(): Records the duration of a stage; each stage is recorded by a single task.
+// - getStageSummary(): Computes the summary of a stage from its histogram.
+// - publishMetrics(): Publishes the summaries of all stages (network task).
+// - metricsTask(): Publishes the document every METRICS_INTERVAL (network task).
+
+
+#ifndef METRICS_MODULE_H
+#define METRICS_MODULE_H
+
+#include <Arduino.h>
+
+#define METRICS_BUCKETS 124
+#define METRICS_INTERVAL 300000         // Publish every 5 minutes (in ms)
+#define METRICS_DOCUMENT_SIZE 4096
+
+// Enumeration of the instrumented stages
+enum MetricStage : uint8_t {
+    METRIC_DHT_STEP,        // updateDHT() acquisition step
+    METRIC_DS18_STEP,       // updateDS18() acquisition step
+    METRIC_BME680_STEP,     // updateBME680() acquisition step
+    METRIC_READ_DHT,        // readDHT()
+    METRIC_READ_DS18,       // readDS18()
+    METRIC_READ_BME680,     // readBME680()
+    METRIC_HEATER,          // Main temperature and heater automation
+    METRIC_SERVOS,          // Servo valve control
+    METRIC_PID,             // PID controller tick
+    METRIC_MQTT_LOOP,       // mqttClient.loop(), including the message handlers
+    METRIC_SIGNALK_LOOP,    // Signal K WebSocket loop, including the message handlers
+    METRIC_PUBLISH,         // Telemetry publishing
+    METRIC_HISTORY,         // History recording and backfill
+    METRIC_STAGE_COUNT
+};
+
+// Structure of the summary of a stage
+struct StageSummary {
+    uint32_t count;
+    float min;              // (in us)
+    float p50;
+    float p99;
+    float max;
+};
+
+// Function to read the cycle counter at the start of a stage
+inline uint32_t beginProbe() {
+    return ESP.getCycleCount();
+}
+
+// Function prototypes
+void endProbe(MetricStage stage, uint32_t start);
+StageSummary getStageSummary(MetricStage stage);
+bool publishMetrics();
+void metricsTask();
+
+#endif // METRICS_MODULE_H
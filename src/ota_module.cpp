@@ -1,29 +1,61 @@
 // Module: ota_module.cpp
-// Purpose: Manages Over-The-Air (OTA) updates and WiFi connection setup.
+// Purpose: Manages Over-The-Air (OTA) updates and WiFi connection setup. The connection comes up in the
+//          background, so heating works without WiFi in range.
 // Functions:
-// - setupWiFi(): Connects to the specified WiFi network.
+// - setupWiFi(): Starts connecting to the specified WiFi network and the NTP client; returns immediately.
+// - serviceNetwork(): Starts mDNS, OTA and Telnet once connected, records the WiFi and NTP boot phases and
+//   restarts the association after a long outage. Runs on every network task pass.
 // - setupOTA(): Initializes OTA update functionality, allowing firmware updates over the network.
 
 
 #include "ota_module.h"
+#include "boot_module.h"
+#include "log_module.h"
+#include "settings_module.h"
+#include <ESPmDNS.h>
+#include <TelnetStream.h>
+#include <time.h>
 
-// Function to set up WiFi connection
+static bool networkServicesStarted = false;
+static unsigned long lastWiFiConnected = 0;
+
+// Function to start the WiFi connection and the NTP client
 void setupWiFi() {
+    beginBootPhase(BOOT_PHASE_WIFI);
+    beginBootPhase(BOOT_PHASE_NTP);
+    WiFi.setAutoReconnect(true);
     WiFi.begin(WIFI_SSID, WIFI_PASS);
-    unsigned long startAttemptTime = millis();
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov"); // SNTP syncs in the background once connected
+}
 
-    // Try to connect to WiFi within a timeout period
-    while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 150000) { // Increased timeout to 150 seconds
-        delay(500);
-    }
+// Function to bring up the network services; runs on the network task
+void serviceNetwork() {
+    unsigned long now = millis();
 
-    if (WiFi.status() != WL_CONNECTED) {
-        // If connection fails, restart the ESP
-        ESP.restart();
+    if (WiFi.status() == WL_CONNECTED) {
+        lastWiFiConnected = now;
+        if (!networkServicesStarted) {
+            endBootPhase(BOOT_PHASE_WIFI);
+            if (!MDNS.begin("esp32")) {
+                LOG_WARN(LOG_MODULE_MAIN, "Error starting MDNS responder!");
+            }
+            setupOTA();
+            TelnetStream.begin();
+            networkServicesStarted = true;
+            IPAddress address = WiFi.localIP();
+            LOG_INFO(LOG_MODULE_MAIN, "WiFi connected: %u.%u.%u.%u", (unsigned)address[0], (unsigned)address[1],
+                     (unsigned)address[2], (unsigned)address[3]);
+        }
+    } else if (now - lastWiFiConnected >= WIFI_RETRY_INTERVAL) {
+        lastWiFiConnected = now;
+        WiFi.disconnect();
+        WiFi.begin(WIFI_SSID, WIFI_PASS);
+        LOG_DEBUG(LOG_MODULE_MAIN, "WiFi association restarted");
     }
 
-    Serial.print("IP address: ");
-    // Serial.println(WiFi.localIP());
+    if (!isBootPhaseDone(BOOT_PHASE_NTP) && time(nullptr) > 1600000000) {
+        endBootPhase(BOOT_PHASE_NTP);
+    }
 }
 
 // Function to set up OTA updates
@@ -33,6 +65,7 @@ void setupOTA() {
     ArduinoOTA.setPassword("1234");
 
     ArduinoOTA.onStart([]() {
+        flushSettings(); // The upload blocks the network task until the restart
         String type;
         if (ArduinoOTA.getCommand() == U_FLASH) {
             type = "sketch";
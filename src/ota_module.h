@@ -1,7 +1,10 @@
 // Module: ota_module.h
 // Purpose: Declares functions for OTA updates and WiFi setup.
+// Definitions:
+// - WIFI_RETRY_INTERVAL: Time without a connection after which the association is restarted.
 // Function Prototypes:
 // - setupWiFi()
+// - serviceNetwork()
 // - setupOTA()
 
 
@@ -12,8 +15,11 @@
 #include <WiFi.h>
 #include "config.h"
 
+#define WIFI_RETRY_INTERVAL 30000   // Restart the association after 30 s without a connection (in ms)
+
 // Function prototypes
 void setupWiFi();
+void serviceNetwork();
 void setupOTA();
 
 #endif
@@ -0,0 +1,117 @@
+// Module: outbox_module.cpp
+// Purpose: Bounded outbound queue that coalesces by topic. Producers on any task only copy the message
+//          under a short lock; the network task sends when the broker is reachable.
+// Functions:
+// - queueMessage(): Replaces the entry of the topic or takes a free slot. When the queue is full, the
+//   oldest entry of the lowest priority gives way, unless it ranks above the new message.
+// - flushOutbox(): Sends up to OUTBOX_FLUSH_PER_RUN messages, highest priority and oldest first. An entry
+//   is only removed if it was not replaced while it was being sent.
+// - getOutboxStats(): Returns the number of waiting entries and the counters.
+
+
+#include "outbox_module.h"
+#include "topic_module.h"
+#include "log_module.h"
+
+static OutboxEntry entries[OUTBOX_SIZE];
+static OutboxStats stats;
+static uint32_t nextSequence = 0;
+static portMUX_TYPE outboxMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Function to queue a message; returns false if it was dropped
+bool queueMessage(const char* topic, const char* payload, bool retained, OutboxPriority priority) {
+    if (topic == nullptr || payload == nullptr || strlen(topic) >= OUTBOX_TOPIC_SIZE) {
+        return false;
+    }
+    uint32_t hash = hashTopic(topic);
+    bool accepted = true;
+
+    portENTER_CRITICAL(&outboxMux);
+    OutboxEntry* slot = nullptr;        // Entry of the same topic
+    OutboxEntry* freeSlot = nullptr;
+    OutboxEntry* victim = nullptr;      // Oldest entry of the lowest priority
+    for (OutboxEntry &entry : entries) {
+        if (!entry.used) {
+            freeSlot = freeSlot != nullptr ? freeSlot : &entry;
+            continue;
+        }
+        if (entry.hash == hash && strcmp(entry.topic, topic) == 0) {
+            slot = &entry;
+            break;
+        }
+        if (victim == nullptr || entry.priority > victim->priority ||
+            (entry.priority == victim->priority && (int32_t)(entry.sequence - victim->sequence) < 0)) {
+            victim = &entry;
+        }
+    }
+
+    if (slot != nullptr) {
+        stats.coalesced++;
+    } else if (freeSlot != nullptr) {
+        slot = freeSlot;
+        stats.queued++;
+    } else if (victim->priority >= priority) {
+        slot = victim;
+        stats.dropped++;
+    } else {
+        stats.dropped++; // Everything queued ranks above this message
+        accepted = false;
+    }
+
+    if (slot != nullptr) {
+        strcpy(slot->topic, topic);
+        slot->hash = hash;
+        slot->used = true;
+        slot->retained = retained;
+        slot->priority = priority;
+        slot->sequence = nextSequence++;
+        strncpy(slot->payload, payload, OUTBOX_PAYLOAD_SIZE - 1);
+        slot->payload[OUTBOX_PAYLOAD_SIZE - 1] = '\0';
+    }
+    portEXIT_CRITICAL(&outboxMux);
+
+    return accepted;
+}
+
+// Function to send queued messages in priority order; returns the number sent
+int flushOutbox(bool (*send)(const char* topic, const char* payload, bool retained)) {
+    static OutboxEntry message; // Copy sent outside the lock; only used by the network task
+    int sent = 0;
+
+    while (sent < OUTBOX_FLUSH_PER_RUN) {
+        portENTER_CRITICAL(&outboxMux);
+        OutboxEntry* next = nullptr;
+        for (OutboxEntry &entry : entries) {
+            if (entry.used && (next == nullptr || entry.priority < next->priority ||
+                (entry.priority == next->priority && (int32_t)(entry.sequence - next->sequence) < 0))) {
+                next = &entry;
+            }
+        }
+        if (next != nullptr) {
+            message = *next;
+        }
+        portEXIT_CRITICAL(&outboxMux);
+
+        if (next == nullptr || !send(message.topic, message.payload, message.retained)) {
+            break;
+        }
+        sent++;
+
+        portENTER_CRITICAL(&outboxMux);
+        if (next->used && next->sequence == message.sequence) {
+            next->used = false;
+            stats.queued--;
+        }
+        stats.sent++;
+        portEXIT_CRITICAL(&outboxMux);
+    }
+    return sent;
+}
+
+// Function to get the queue counters
+OutboxStats getOutboxStats() {
+    portENTER_CRITICAL(&outboxMux);
+    OutboxStats copy = stats;
+    portEXIT_CRITICAL(&outboxMux);
+    return copy;
+}
@@ -0,0 +1,61 @@
+// Module: outbox_module.h
+// Purpose: Declares the outbound store-and-forward queue. Messages are queued without touching the
+//          network; a message replaces a queued one on the same topic, so an outage costs one slot per
+//          topic and only the latest value of each path is sent after reconnecting.
+// Definitions:
+// - OUTBOX_SIZE: Number of queued topics.
+// - OUTBOX_TOPIC_SIZE, OUTBOX_PAYLOAD_SIZE: Storage per entry.
+// - OUTBOX_FLUSH_PER_RUN: Messages sent per call of flushOutbox().
+// Enumerations:
+// - OutboxPriority: Send order after a reconnect.
+// Structures:
+// - OutboxEntry: A queued message.
+// - OutboxStats: Queue counters.
+// Function Prototypes:
+// - queueMessage(): Queues or replaces the message of a topic (any task).
+// - flushOutbox(): Sends queued messages in priority order (network task).
+// - getOutboxStats(): Returns the counters.
+
+
+#ifndef OUTBOX_MODULE_H
+#define OUTBOX_MODULE_H
+
+#include <Arduino.h>
+
+#define OUTBOX_SIZE 48
+#define OUTBOX_TOPIC_SIZE 112
+#define OUTBOX_PAYLOAD_SIZE 128         // Longer payloads are truncated; documents use publishMessage()
+#define OUTBOX_FLUSH_PER_RUN 8
+
+// Enumeration of send priorities, lowest value first
+enum OutboxPriority : uint8_t {
+    OUTBOX_PRIORITY_STATE,  // Heater status, fault and modes
+    OUTBOX_PRIORITY_VALUE,  // Zone values
+    OUTBOX_PRIORITY_INFO    // Informational messages
+};
+
+// Structure of a queued message
+struct OutboxEntry {
+    bool used;
+    bool retained;
+    OutboxPriority priority;
+    uint32_t sequence;      // Order of the last update; entries of equal priority are sent oldest first
+    uint32_t hash;          // FNV-1a hash of the topic
+    char topic[OUTBOX_TOPIC_SIZE];
+    char payload[OUTBOX_PAYLOAD_SIZE];
+};
+
+// Structure of the queue counters
+struct OutboxStats {
+    int queued;             // Entries waiting
+    uint32_t coalesced;     // Messages that replaced a queued message of the same topic
+    uint32_t dropped;       // Messages lost because the queue was full
+    uint32_t sent;
+};
+
+// Function prototypes
+bool queueMessage(const char* topic, const char* payload, bool retained, OutboxPriority priority);
+int flushOutbox(bool (*send)(const char* topic, const char* payload, bool retained));
+OutboxStats getOutboxStats();
+
+#endif // OUTBOX_MODULE_H
@@ -0,0 +1,200 @@
+// Module: pid_module.cpp
+// Purpose: Per-zone PID valve control on a fixed period. The controllers run in their own task with
+//          vTaskDelayUntil(), so the period does not drift with the duration of sensor reads and
+//          MQTT traffic in the other tasks.
+// Functions:
+// - computePID(): Proportional term on the error, derivative on the filtered measurement (no kick on
+//   target changes), integral with conditional anti-windup and an output slew limit.
+// - setupPID(): Loads the gains from NVS, falling back to the defaults.
+// - updateZonePID(): Runs the controllers of all zones with a valve while the heater is on in
+//   proportional valve mode; otherwise tracks the valve position for a bumpless start.
+// - setPIDGains(), getPIDGains(): Exchange gains with the network task under a lock; setPIDGains() persists them.
+// - parsePIDGains(): Reads {"kp": 30, "ki": 0.02, "kd": 0, "slew": 5}; missing keys keep their values.
+// - startPIDTask(): Creates the PID task on the control core.
+
+
+#include "pid_module.h"
+#include "tasks_module.h"
+#include "heater_automation_module.h"
+#include "gpio_module.h"
+#include "servo_control_module.h"
+#include "data_module.h"
+#include "log_module.h"
+#include "metrics_module.h"
+#include "zone_descriptors.h"
+#include "settings_module.h"
+#include <Preferences.h>
+
+#define PID_DEFAULT_GAINS {PID_DEFAULT_KP, PID_DEFAULT_KI, PID_DEFAULT_KD, PID_DEFAULT_SLEW, PID_OUTPUT_MIN, PID_OUTPUT_MAX}
+
+// Structure of the gains stored in NVS
+struct StoredPIDGains {
+    uint8_t version;
+    PIDGains gains[NUM_ZONES];
+};
+
+static PIDGains zoneGains[NUM_ZONES];       // Written by the network task, read by the PID task
+static PIDState zoneStates[NUM_ZONES];      // Owned by the PID task
+static portMUX_TYPE pidMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Function to run one controller step; returns the new output
+float computePID(const PIDGains &gains, PIDState &state, float setpoint, float measurement, float dt) {
+    float error = setpoint - measurement;
+    float proportional = gains.kp * error;
+
+    if (!state.initialized) {
+        // Start from the current output instead of jumping
+        state.integral = constrain(state.output - proportional, gains.outputMin, gains.outputMax);
+        state.derivative = 0;
+        state.lastMeasurement = measurement;
+        state.initialized = true;
+    }
+
+    // Derivative on measurement with a low-pass filter against sensor quantization
+    float rate = (measurement - state.lastMeasurement) / dt;
+    state.derivative += PID_DERIVATIVE_FILTER * (rate - state.derivative);
+    state.lastMeasurement = measurement;
+    float derivative = -gains.kd * state.derivative;
+
+    float integral = state.integral + gains.ki * error * dt;
+    float unlimited = proportional + integral + derivative;
+    float output = constrain(unlimited, gains.outputMin, gains.outputMax);
+    if (gains.slewRate > 0) {
+        float step = gains.slewRate * dt;
+        output = constrain(output, state.output - step, state.output + step);
+    }
+
+    // Anti-windup: do not integrate further while the output is limited in the direction of the error
+    if (output != unlimited && (unlimited - output) * error > 0) {
+        integral = state.integral;
+    }
+    state.integral = constrain(integral, gains.outputMin, gains.outputMax);
+    state.output = output;
+    return output;
+}
+
+// Function to load the gains of all zones
+void setupPID() {
+    StoredPIDGains stored;
+    Preferences preferences;
+    bool loaded = false;
+
+    if (preferences.begin(PID_NVS_NAMESPACE, true)) {
+        loaded = preferences.getBytesLength("gains") == sizeof(stored) &&
+                 preferences.getBytes("gains", &stored, sizeof(stored)) == sizeof(stored) &&
+                 stored.version == PID_VERSION;
+        preferences.end();
+    }
+    for (int i = 0; i < NUM_ZONES; i++) {
+        zoneGains[i] = loaded ? stored.gains[i] : (PIDGains)PID_DEFAULT_GAINS;
+        zoneStates[i] = {};
+    }
+    LOG_INFO(LOG_MODULE_SERVO, "PID gains loaded (%s)", loaded ? "NVS" : "default");
+}
+
+// Function to run one control period for all zones
+void updateZonePID() {
+    const float dt = PID_PERIOD / 1000.0f;
+    // With the heater off the servo task opens all valves; in on/off mode it owns them
+    bool active = valveModeProportional && heaterStatus;
+
+    for (uint8_t i : valveZones) {
+        PIDState &state = zoneStates[i];
+        float temperature = getZoneTemperature(i);
+        float target = getZoneTarget(i);
+
+        if (!active || isnan(temperature) || isnan(target)) {
+            // Track the valve so the controller starts from its position
+            state.initialized = false;
+            state.output = max(0, getServoPosition(i));
+            continue;
+        }
+
+        portENTER_CRITICAL(&pidMux);
+        PIDGains gains = zoneGains[i];
+        portEXIT_CRITICAL(&pidMux);
+
+        float output = computePID(gains, state, target, temperature, dt);
+        setServoPosition(i, (int)lroundf(output));
+    }
+}
+
+// Function to change the gains of a zone; runs on the network task
+bool setPIDGains(int zoneIndex, const PIDGains &gains) {
+    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES || gains.outputMin >= gains.outputMax) {
+        return false;
+    }
+
+    StoredPIDGains stored;
+    stored.version = PID_VERSION;
+    portENTER_CRITICAL(&pidMux);
+    zoneGains[zoneIndex] = gains;
+    memcpy(stored.gains, zoneGains, sizeof(stored.gains));
+    portEXIT_CRITICAL(&pidMux);
+
+    Preferences preferences;
+    if (preferences.begin(PID_NVS_NAMESPACE, false)) {
+        preferences.putBytes("gains", &stored, sizeof(stored));
+        countNVSWrite();
+        preferences.end();
+    }
+    LOG_INFO(LOG_MODULE_SERVO, "PID gains of zone %d: kp %.3f, ki %.4f, kd %.3f", zoneIndex, gains.kp, gains.ki, gains.kd);
+    return true;
+}
+
+// Function to get the gains of a zone
+PIDGains getPIDGains(int zoneIndex) {
+    PIDGains gains = PID_DEFAULT_GAINS;
+    if (zoneIndex >= 0 && zoneIndex < NUM_ZONES) {
+        portENTER_CRITICAL(&pidMux);
+        gains = zoneGains[zoneIndex];
+        portEXIT_CRITICAL(&pidMux);
+    }
+    return gains;
+}
+
+// Function to read gains from a payload into gains; returns false if no valid gain was found
+bool parsePIDGains(const uint8_t* payload, unsigned int length, PIDGains &gains) {
+    const char* keys[] = {"kp", "ki", "kd", "slew"};
+    float* fields[] = {&gains.kp, &gains.ki, &gains.kd, &gains.slewRate};
+    bool found = false;
+
+    // Only JSON objects; a plain number would match every key
+    unsigned int start = 0;
+    while (start < length && isspace(payload[start])) {
+        start++;
+    }
+    if (start == length || payload[start] != '{') {
+        return false;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        float value;
+        if (!findPayloadNumber(payload, length, keys[i], value)) {
+            continue;
+        }
+        if (isnan(value) || value < 0) {
+            LOG_WARN(LOG_MODULE_SERVO, "Invalid PID gain %s: %.3f", keys[i], value);
+            return false;
+        }
+        *fields[i] = value;
+        found = true;
+    }
+    return found;
+}
+
+// Task body: run the controllers on a fixed period
+static void runPIDTask(void* parameter) {
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(PID_PERIOD));
+        uint32_t probe = beginProbe();
+        updateZonePID();
+        endProbe(METRIC_PID, probe);
+    }
+}
+
+// Function to start the PID task on the control core
+void startPIDTask() {
+    xTaskCreatePinnedToCore(runPIDTask, "pid", PID_TASK_STACK, nullptr, PID_TASK_PRIORITY, nullptr, CONTROL_TASK_CORE);
+}
@@ -0,0 +1,67 @@
+// Module: pid_module.h
+// Purpose: Declares the per-zone PID valve control. In proportional valve mode a dedicated task runs
+//          the controllers on a fixed period and sets the valve openings.
+// Definitions:
+// - PID_PERIOD: Control period of the PID task.
+// - PID_TASK_STACK, PID_TASK_PRIORITY: PID task parameters (on the control core, above the control task).
+// - PID_DEFAULT_*: Default gains and limits.
+// Structures:
+// - PIDGains: Gains and output limits of a controller.
+// - PIDState: Integrator, derivative and output state of a controller.
+// Function Prototypes:
+// - computePID(): One controller step; pure, so it can be benchmarked on the host.
+// - setupPID(): Loads the gains of all zones from NVS.
+// - updateZonePID(): One control period for all zones.
+// - setPIDGains(), getPIDGains(): Change or read the gains of a zone.
+// - parsePIDGains(): Reads gains from an MQTT payload.
+// - startPIDTask(): Starts the fixed-rate PID task.
+
+
+#ifndef PID_MODULE_H
+#define PID_MODULE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define PID_PERIOD 1000                 // Control period (in ms)
+#define PID_TASK_STACK 4096
+#define PID_TASK_PRIORITY 3             // Above CONTROL_TASK_PRIORITY, so sensor reads do not delay it
+#define PID_DEFAULT_KP 30.0f            // % valve opening per K
+#define PID_DEFAULT_KI 0.02f            // % per K and second (integral time 1500 s)
+#define PID_DEFAULT_KD 0.0f             // % per K/s
+#define PID_DEFAULT_SLEW 5.0f           // Maximum change of the valve opening (% per second)
+#define PID_DERIVATIVE_FILTER 0.2f      // Weight of a new derivative sample (first-order low-pass)
+#define PID_OUTPUT_MIN 0.0f
+#define PID_OUTPUT_MAX 100.0f
+#define PID_NVS_NAMESPACE "pid"
+#define PID_VERSION 1                   // Increment when PIDGains changes
+
+// Structure of the gains and limits of a controller
+struct PIDGains {
+    float kp;
+    float ki;
+    float kd;
+    float slewRate;         // Maximum output change per second, 0: unlimited
+    float outputMin;
+    float outputMax;
+};
+
+// Structure of the state of a controller
+struct PIDState {
+    float integral;         // Integral term (in output units)
+    float derivative;       // Filtered rate of change of the measurement (K/s)
+    float lastMeasurement;
+    float output;
+    bool initialized;       // False until the first step after a reset
+};
+
+// Function prototypes
+float computePID(const PIDGains &gains, PIDState &state, float setpoint, float measurement, float dt);
+void setupPID();
+void updateZonePID();
+bool setPIDGains(int zoneIndex, const PIDGains &gains);
+PIDGains getPIDGains(int zoneIndex);
+bool parsePIDGains(const uint8_t* payload, unsigned int length, PIDGains &gains);
+void startPIDTask();
+
+#endif // PID_MODULE_H
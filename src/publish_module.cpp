@@ -0,0 +1,263 @@
+// Module: publish_module.cpp
+// Purpose: Collects the values that changed during a publish cycle and sends them per topic or as one Signal K delta.
+//          With the Signal K WebSocket transport every cycle is sent as a delta on the WebSocket.
+// Functions:
+// - setupPublishing(): Resets the change tracking.
+// - publishData(): Collects changed values of a telemetry snapshot (zones, main temperature, heater and modes) and
+//   queues them per topic or sends them as a delta on the active transport.
+// - resendAllData(): Forces every value to be sent again in the next cycle.
+// - buildDelta(): Serializes a range of the collected values into a Signal K delta using a preallocated arena.
+// - sendDeltas(): Sends the collected values as one delta, or as several if they do not fit the buffer.
+
+
+#include "publish_module.h"
+#include "message_module.h"
+#include "topic_module.h"
+#include "transport_module.h"
+#include "signalk_module.h"
+#include "zone_descriptors.h"
+#include "log_module.h"
+#include <ArduinoJson.h>
+#include <time.h>
+
+PublishMode publishMode = DEFAULT_PUBLISH_MODE;
+
+// Structure of a value collected during a publish cycle
+struct PublishValue {
+    const char* topic;  // Per-topic destination
+    const char* path;   // Signal K path for the delta
+    float value;
+    bool integer;       // Send without decimals
+    OutboxPriority priority;
+    float* lastSent;    // Updated once the value was published or queued
+};
+
+// Values sent last, per zone and per zone topic
+static float lastSent[NUM_ZONES][ZONE_TOPIC_COUNT];
+static float lastGlobal[OUTBOUND_TOPIC_COUNT];
+
+// Values collected in the current cycle
+static PublishValue pending[NUM_ZONES * ZONE_TOPIC_COUNT + OUTBOUND_TOPIC_COUNT];
+static int pendingCount = 0;
+
+// Bump allocator backing the JSON document; reset after every delta
+class PublishArena : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        size_t total = align(size) + sizeof(size_t);
+        if (used + total > PUBLISH_ARENA_SIZE) {
+            return nullptr;
+        }
+        size_t* block = reinterpret_cast<size_t*>(memory + used);
+        *block = size;
+        last = block + 1;
+        used += total;
+        return last;
+    }
+
+    void deallocate(void* pointer) override {
+        // Memory is released as a whole by reset()
+    }
+
+    void* reallocate(void* pointer, size_t newSize) override {
+        if (pointer == nullptr) {
+            return allocate(newSize);
+        }
+        size_t* header = static_cast<size_t*>(pointer) - 1;
+        if (pointer == last) {
+            // Grow or shrink the most recent block in place
+            size_t start = reinterpret_cast<uint8_t*>(header) - memory;
+            if (start + sizeof(size_t) + align(newSize) > PUBLISH_ARENA_SIZE) {
+                return nullptr;
+            }
+            *header = newSize;
+            used = start + sizeof(size_t) + align(newSize);
+            return pointer;
+        }
+        void* moved = allocate(newSize);
+        if (moved != nullptr) {
+            memcpy(moved, pointer, min(*header, newSize));
+        }
+        return moved;
+    }
+
+    void reset() {
+        used = 0;
+        last = nullptr;
+    }
+
+private:
+    alignas(8) uint8_t memory[PUBLISH_ARENA_SIZE];
+    size_t used = 0;
+    void* last = nullptr;
+
+    static size_t align(size_t size) {
+        return (size + 7) & ~(size_t)7;
+    }
+};
+
+static PublishArena publishArena;
+static char deltaBuffer[PUBLISH_BUFFER_SIZE];
+
+// Function to reset the change tracking so every value is sent again
+void resendAllData() {
+    for (int i = 0; i < NUM_ZONES; i++) {
+        for (int t = 0; t < ZONE_TOPIC_COUNT; t++) {
+            lastSent[i][t] = NAN;
+        }
+    }
+    for (int t = 0; t < OUTBOUND_TOPIC_COUNT; t++) {
+        lastGlobal[t] = NAN;
+    }
+}
+
+void setupPublishing() {
+    resendAllData();
+}
+
+// Function to add a value to the current cycle if it changed since it was last sent
+static void collectValue(const char* topic, const char* path, float value, float* last, bool integer, OutboxPriority priority) {
+    if (isnan(value) || topic == nullptr || value == *last) {
+        return;
+    }
+    PublishValue &entry = pending[pendingCount++];
+    entry.topic = topic;
+    entry.path = path;
+    entry.value = value;
+    entry.integer = integer;
+    entry.priority = priority;
+    entry.lastSent = last;
+}
+
+// Function to serialize count collected values from first on into a Signal K delta; returns its length or 0 if it
+// does not fit the arena or the buffer
+static size_t buildDelta(int first, int count) {
+    size_t length = 0;
+    {
+        JsonDocument doc(&publishArena);
+        doc["context"] = "vessels.self";
+        JsonObject update = doc["updates"].add<JsonObject>();
+        update["source"]["label"] = SIGNALK_SOURCE;
+
+        // Add a timestamp once the clock is synchronized
+        time_t now = time(nullptr);
+        if (now > 1600000000) {
+            char timestamp[24];
+            struct tm utc;
+            gmtime_r(&now, &utc);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+            update["timestamp"] = (const char*)timestamp;
+        }
+
+        JsonArray values = update["values"].to<JsonArray>();
+        for (int i = first; i < first + count; i++) {
+            JsonObject entry = values.add<JsonObject>();
+            entry["path"] = pending[i].path;
+            if (pending[i].integer) {
+                entry["value"] = (int)pending[i].value;
+            } else {
+                entry["value"] = round(pending[i].value * 100.0) / 100.0;
+            }
+        }
+
+        if (!doc.overflowed() && measureJson(doc) < sizeof(deltaBuffer)) {
+            length = serializeJson(doc, deltaBuffer, sizeof(deltaBuffer));
+        }
+    }
+    publishArena.reset();
+    return length;
+}
+
+// Function to send the collected values as deltas; a delta that does not fit is split in halves until it does,
+// so the values that fit are sent and marked even when all of them together never would. Stops at the first
+// delta the transport does not take; the rest stays pending for the next cycle
+static void sendDeltas(bool signalK) {
+    int first = 0;
+    int count = pendingCount;
+    while (first < pendingCount) {
+        count = min(count, pendingCount - first);
+        size_t length = buildDelta(first, count);
+        if (length == 0) {
+            if (count > 1) {
+                count = (count + 1) / 2;
+            } else {
+                LOG_ERROR(LOG_MODULE_MQTT, "Signal K value of %s does not fit a delta", pending[first].path);
+                first++;
+            }
+            continue;
+        }
+
+        bool sent = signalK ? sendSignalKDelta(deltaBuffer, length)
+                            : publishMessage(getOutboundTopic(TOPIC_DELTA), deltaBuffer, false);
+        if (!sent) {
+            return;
+        }
+        for (int i = first; i < first + count; i++) {
+            *pending[i].lastSent = pending[i].value;
+        }
+        first += count;
+    }
+}
+
+// Function to add a zone value to the current cycle
+static void collectZoneValue(int zoneIndex, ZoneTopic topic, float value, bool integer) {
+    collectValue(getZoneTopic(zoneIndex, topic), getZonePath(zoneIndex, topic), value, &lastSent[zoneIndex][topic], integer, OUTBOX_PRIORITY_VALUE);
+}
+
+// Function to add a global value to the current cycle
+static void collectGlobalValue(OutboundTopic topic, float value, bool integer, OutboxPriority priority) {
+    collectValue(getOutboundTopic(topic), getOutboundPath(topic), value, &lastGlobal[topic], integer, priority);
+}
+
+// Function to publish all values of a snapshot that changed since the last cycle
+void publishData(const Telemetry &telemetry) {
+    pendingCount = 0;
+
+    // Collect changed data for each zone
+    for (uint8_t i : activeZones) {
+        const ZoneTelemetry &zone = telemetry.zones[i];
+        collectZoneValue(i, ZONE_TOPIC_TEMPERATURE, zone.temperature, false);
+        collectZoneValue(i, ZONE_TOPIC_HUMIDITY, zone.humidity, false);
+        collectZoneValue(i, ZONE_TOPIC_TARGET_TEMPERATURE, zone.temperatureTarget, false);
+        collectZoneValue(i, ZONE_TOPIC_PRESSURE, zone.pressure, false);
+        collectZoneValue(i, ZONE_TOPIC_VOC, zone.voc, false);
+        if (zone.valvePosition >= 0) {
+            collectZoneValue(i, ZONE_TOPIC_VALVE_POSITION, zone.valvePosition, true);
+        }
+    }
+
+    // Collect the main temperature, heater status, fault and modes
+    collectGlobalValue(TOPIC_MAIN_TEMPERATURE, telemetry.mainTemperature, false, OUTBOX_PRIORITY_VALUE);
+    collectGlobalValue(TOPIC_STATUS, telemetry.heaterStatus ? 1 : 0, true, OUTBOX_PRIORITY_STATE);
+    collectGlobalValue(TOPIC_HEATER_FAULT, telemetry.heaterFault ? 1 : 0, true, OUTBOX_PRIORITY_STATE);
+    collectGlobalValue(TOPIC_AUTOMATION_MODE, telemetry.automationActive ? 1 : 0, true, OUTBOX_PRIORITY_STATE);
+    collectGlobalValue(TOPIC_VALVE_MODE, telemetry.valveModeProportional ? 1 : 0, true, OUTBOX_PRIORITY_STATE);
+
+    if (pendingCount == 0) {
+        return;
+    }
+
+    bool signalK = getTransport() == TRANSPORT_SIGNALK;
+    if (signalK || publishMode == PUBLISH_DELTA) {
+        // One message for the whole cycle, split if it does not fit; values stay pending while the transport is
+        // down, so the first deltas after a reconnect carry the latest value of every path that changed
+        if (!isTransportConnected()) {
+            return;
+        }
+        sendDeltas(signalK);
+        return;
+    }
+
+    // One retained message per topic, coalesced in the outbound queue while the broker is unreachable
+    char payload[16];
+    for (int i = 0; i < pendingCount; i++) {
+        if (pending[i].integer) {
+            snprintf(payload, sizeof(payload), "%d", (int)pending[i].value);
+        } else {
+            snprintf(payload, sizeof(payload), "%.2f", pending[i].value);
+        }
+        if (queueMessage(pending[i].topic, payload, true, pending[i].priority)) {
+            *pending[i].lastSent = pending[i].value;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+// Module: publish_module.h
+// Purpose: Declares the publishing stage that sends changed zone data per topic or as one Signal K delta.
+// Definitions:
+// - PUBLISH_ARENA_SIZE: Size of the preallocated ArduinoJson memory arena.
+// - PUBLISH_BUFFER_SIZE: Size of the serialized delta document; larger cycles are split into several deltas.
+// Enumerations:
+// - PublishMode: One retained message per topic (Venus style) or one batched Signal K delta.
+// External Variables:
+// - publishMode: Current publish mode, changeable at runtime.
+// Function Prototypes:
+// - setupPublishing()
+// - publishData()
+// - resendAllData()
+
+
+#ifndef PUBLISH_MODULE_H
+#define PUBLISH_MODULE_H
+
+#include "config.h"
+#include "tasks_module.h"
+
+#define PUBLISH_ARENA_SIZE 8192     // Bytes available to the JSON document of one delta
+#define PUBLISH_BUFFER_SIZE 3072    // Bytes available to the serialized delta
+#define DEFAULT_PUBLISH_MODE PUBLISH_TOPICS
+
+// Enumeration of publish modes
+enum PublishMode {
+    PUBLISH_TOPICS, // One retained message per value and topic
+    PUBLISH_DELTA   // All changed values of a cycle in one Signal K delta document
+};
+
+// Current publish mode
+extern PublishMode publishMode;
+
+// Function prototypes
+void setupPublishing();
+void publishData(const Telemetry &telemetry);
+void resendAllData();
+
+#endif // PUBLISH_MODULE_H
@@ -0,0 +1,264 @@
+// Module: routing_module.cpp
+// Purpose: Maps sensor values to zone fields through a routing table stored in NVS and editable over MQTT.
+//          The table is compiled into index lists grouped by aggregation rule, so the assignment
+//          is a tight loop without per-zone branching.
+// Functions:
+// - setupRouting(): Loads the routing table from NVS (or the built-in default) and compiles it.
+// - routeSensorValues(): Assigns sensor values to the zones using the compiled table.
+// - parseRoutingTable(): Parses a routing table from a JSON payload.
+// - requestRoutingUpdate(): Stores a new table in NVS and hands it to the control task (network side).
+// - applyPendingRouting(): Compiles a pending table (control side).
+
+
+#include "routing_module.h"
+#include "zones_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+#include "zone_descriptors.h"
+#include "settings_module.h"
+#include <Preferences.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+static const char* const fieldNames[FIELD_COUNT] = {"temperature", "valve_temperature", "humidity", "pressure", "voc"};
+static const char* const aggregationNames[] = {"first", "min", "mean"};
+
+// Sensor array a field reads from: 0 temperatures, 1 humidities, 2 pressures, 3 VOCs
+static const uint8_t fieldSource[FIELD_COUNT] = {0, 0, 1, 2, 3};
+
+// Compiled routing: one group per routed zone field, grouped by aggregation rule
+struct RouteGroup {
+    float* destination; // Cold zone field, nullptr for the temperature in the zone control state
+    uint8_t zone;
+    uint8_t first;      // First entry in the source lists
+    uint8_t count;      // Number of sources
+};
+
+static uint8_t sourceArray[MAX_ROUTES];
+static uint8_t sourceSlot[MAX_ROUTES];
+static RouteGroup groups[3][NUM_ZONES * FIELD_COUNT];
+static uint8_t groupCount[3] = {0, 0, 0};
+
+// Table handed from the network task to the control task
+static RoutingTable pendingTable;
+static std::atomic<bool> routingPending(false);
+
+// Function to get the address of a cold zone field; the temperature is kept in zoneState
+static float* getFieldAddress(int zoneIndex, uint8_t field) {
+    switch (field) {
+        case FIELD_TEMPERATURE: return nullptr;
+        case FIELD_VALVE_TEMPERATURE: return &zones[zoneIndex].temperatureValve;
+        case FIELD_HUMIDITY: return &zones[zoneIndex].humidity;
+        case FIELD_PRESSURE: return &zones[zoneIndex].pressure;
+        default: return &zones[zoneIndex].voc;
+    }
+}
+
+// Function to store an aggregated value in its zone field
+static inline void storeGroupValue(const RouteGroup &group, float value) {
+    if (group.destination != nullptr) {
+        *group.destination = value;
+    } else {
+        setZoneTemperature(group.zone, value);
+    }
+}
+
+// Function to compile a table into grouped index lists; runs on the control task
+static void compileRouting(const RoutingTable &table) {
+    uint8_t sources = 0;
+    groupCount[0] = groupCount[1] = groupCount[2] = 0;
+
+    for (int zone = 0; zone < NUM_ZONES; zone++) {
+        for (int field = 0; field < FIELD_COUNT; field++) {
+            // Fields without a route are cleared so stale values do not linger
+            float* address = getFieldAddress(zone, field);
+            if (address != nullptr) {
+                *address = NAN;
+            } else {
+                setZoneTemperature(zone, NAN);
+            }
+
+            uint8_t first = sources;
+            for (int r = 0; r < table.count; r++) {
+                if (table.routes[r].zone == zone && table.routes[r].field == field) {
+                    sourceArray[sources] = fieldSource[field];
+                    sourceSlot[sources] = table.routes[r].sensor;
+                    sources++;
+                }
+            }
+            if (sources > first) {
+                uint8_t rule = min<uint8_t>(table.aggregation[zone][field], AGGREGATE_MEAN);
+                groups[rule][groupCount[rule]++] = {address, (uint8_t)zone, first, (uint8_t)(sources - first)};
+            }
+        }
+    }
+}
+
+// Function to assign sensor values to zones using the compiled table
+void routeSensorValues(const float sensors[], const float hums[], const float pressures[], const float vocs[]) {
+    const float* arrays[4] = {sensors, hums, pressures, vocs};
+
+    // First valid value
+    for (uint8_t g = 0; g < groupCount[AGGREGATE_FIRST_VALID]; g++) {
+        const RouteGroup &group = groups[AGGREGATE_FIRST_VALID][g];
+        float value = NAN;
+        for (uint8_t s = group.first; s < group.first + group.count && isnan(value); s++) {
+            value = arrays[sourceArray[s]][sourceSlot[s]];
+        }
+        storeGroupValue(group, value);
+    }
+
+    // Minimum of valid values
+    for (uint8_t g = 0; g < groupCount[AGGREGATE_MIN]; g++) {
+        const RouteGroup &group = groups[AGGREGATE_MIN][g];
+        float value = NAN;
+        for (uint8_t s = group.first; s < group.first + group.count; s++) {
+            float candidate = arrays[sourceArray[s]][sourceSlot[s]];
+            value = (candidate < value || isnan(value)) ? candidate : value;
+        }
+        storeGroupValue(group, value);
+    }
+
+    // Mean of valid values
+    for (uint8_t g = 0; g < groupCount[AGGREGATE_MEAN]; g++) {
+        const RouteGroup &group = groups[AGGREGATE_MEAN][g];
+        float sum = 0;
+        int valid = 0;
+        for (uint8_t s = group.first; s < group.first + group.count; s++) {
+            float candidate = arrays[sourceArray[s]][sourceSlot[s]];
+            bool ok = !isnan(candidate);
+            sum += ok ? candidate : 0;
+            valid += ok;
+        }
+        storeGroupValue(group, valid > 0 ? sum / valid : NAN);
+    }
+}
+
+// Function to fill a table with the default routing, generated from the sensor bindings of the zone descriptors
+static void loadDefaultRouting(RoutingTable &table) {
+    memset(&table, 0, sizeof(table));
+    table.version = ROUTING_VERSION;
+    table.count = DEFAULT_ROUTE_COUNT;
+    memcpy(table.routes, defaultRoutes.routes, DEFAULT_ROUTE_COUNT * sizeof(Route));
+}
+
+// Function to load the routing table from NVS and compile it; runs before the control task starts
+void setupRouting() {
+    RoutingTable table;
+    Preferences preferences;
+    bool loaded = false;
+
+    if (preferences.begin(ROUTING_NVS_NAMESPACE, true)) {
+        loaded = preferences.getBytesLength(ROUTING_NVS_KEY) == sizeof(table) &&
+                 preferences.getBytes(ROUTING_NVS_KEY, &table, sizeof(table)) == sizeof(table) &&
+                 table.version == ROUTING_VERSION && table.count <= MAX_ROUTES;
+        preferences.end();
+    }
+    if (!loaded) {
+        loadDefaultRouting(table);
+    }
+    compileRouting(table);
+    LOG_INFO(LOG_MODULE_SENSORS, "Sensor routing loaded (%s, %d routes)", loaded ? "NVS" : "default", table.count);
+}
+
+// Function to look up a name in a list; returns -1 if not found
+static int findName(const char* name, const char* const names[], int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to resolve a zone given by index or name
+static int findZone(JsonVariantConst zone) {
+    if (zone.is<int>()) {
+        int index = zone.as<int>();
+        return (index >= 0 && index < NUM_ZONES && zoneTopicSlot.slot[index] >= 0) ? index : -1;
+    }
+    const char* name = zone | "";
+    for (uint8_t i : activeZones) {
+        if (strcmp(zones[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to parse a table like
+// {"routes": [{"sensor": 16, "zone": "Cabin", "field": "temperature"}, ...],
+//  "aggregation": [{"zone": 0, "field": "temperature", "rule": "min"}]}
+bool parseRoutingTable(const uint8_t* payload, unsigned int length, RoutingTable &table) {
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length)) {
+        LOG_WARN(LOG_MODULE_SENSORS, "Sensor routing payload is not valid JSON");
+        return false;
+    }
+
+    // Without a route list the table would be applied and stored empty, leaving every zone without sensors
+    if (!doc["routes"].is<JsonArrayConst>()) {
+        LOG_WARN(LOG_MODULE_SENSORS, "Sensor routing payload without a routes array rejected");
+        return false;
+    }
+
+    memset(&table, 0, sizeof(table));
+    table.version = ROUTING_VERSION;
+
+    for (JsonObjectConst route : doc["routes"].as<JsonArrayConst>()) {
+        int sensor = route["sensor"] | -1;
+        int zone = findZone(route["zone"]);
+        int field = findName(route["field"] | "", fieldNames, FIELD_COUNT);
+        if (sensor < 0 || sensor >= NUM_SENSORS || zone < 0 || field < 0 || table.count >= MAX_ROUTES) {
+            LOG_WARN(LOG_MODULE_SENSORS, "Invalid sensor route %d rejected", table.count);
+            return false;
+        }
+        table.routes[table.count++] = {(uint8_t)sensor, (uint8_t)zone, (uint8_t)field};
+    }
+
+    for (JsonObjectConst rule : doc["aggregation"].as<JsonArrayConst>()) {
+        int zone = findZone(rule["zone"]);
+        int field = findName(rule["field"] | "", fieldNames, FIELD_COUNT);
+        int aggregation = findName(rule["rule"] | "", aggregationNames, 3);
+        if (zone < 0 || field < 0 || aggregation < 0) {
+            LOG_WARN(LOG_MODULE_SENSORS, "Invalid aggregation rule rejected");
+            return false;
+        }
+        table.aggregation[zone][field] = aggregation;
+    }
+    return true;
+}
+
+// Function to store a new table and hand it to the control task; runs on the network task
+bool requestRoutingUpdate(const RoutingTable &table) {
+    if (routingPending.load()) {
+        LOG_WARN(LOG_MODULE_SENSORS, "Previous sensor routing update still pending");
+        return false;
+    }
+
+    pendingTable = table;
+    routingPending.store(true);
+    if (!sendCommand(CMD_APPLY_ROUTING, -1, 0)) {
+        routingPending.store(false);
+        return false;
+    }
+
+    // Stored only once the control task will apply it, so a rejected table is not restored after a reboot
+    Preferences preferences;
+    if (preferences.begin(ROUTING_NVS_NAMESPACE, false)) {
+        preferences.putBytes(ROUTING_NVS_KEY, &table, sizeof(table));
+        countNVSWrite();
+        preferences.end();
+    }
+    return true;
+}
+
+// Function to compile a pending table; runs on the control task
+void applyPendingRouting() {
+    if (!routingPending.load()) {
+        return;
+    }
+    compileRouting(pendingTable);
+    routingPending.store(false);
+    LOG_INFO(LOG_MODULE_SENSORS, "Sensor routing updated (%d routes)", pendingTable.count);
+}
@@ -0,0 +1,69 @@
+// Module: routing_module.h
+// Purpose: Declares the runtime-configurable routing table that maps sensors to zone fields.
+// Definitions:
+// - MAX_ROUTES: Maximum number of sensor-to-zone routes.
+// - ROUTING_NVS_NAMESPACE, ROUTING_NVS_KEY: Where the routing table is stored.
+// Enumerations:
+// - ZoneField: Zone fields a sensor can be routed to.
+// - Aggregation: How several sensors routed to the same field are combined.
+// Structures:
+// - Route: Sensor slot (0-4 DHT, 5-14 DS18, 15-19 BME680), zone and field.
+// - RoutingTable: All routes plus the aggregation rule of every zone field.
+// Function Prototypes:
+// - setupRouting()
+// - routeSensorValues()
+// - parseRoutingTable()
+// - requestRoutingUpdate(), applyPendingRouting()
+
+
+#ifndef ROUTING_MODULE_H
+#define ROUTING_MODULE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define MAX_ROUTES 40
+#define ROUTING_NVS_NAMESPACE "heater"
+#define ROUTING_NVS_KEY "routing"
+#define ROUTING_VERSION 1
+
+// Enumeration of zone fields that can receive sensor values
+enum ZoneField : uint8_t {
+    FIELD_TEMPERATURE,
+    FIELD_VALVE_TEMPERATURE,
+    FIELD_HUMIDITY,
+    FIELD_PRESSURE,
+    FIELD_VOC,
+    FIELD_COUNT
+};
+
+// Enumeration of aggregation rules
+enum Aggregation : uint8_t {
+    AGGREGATE_FIRST_VALID, // First route (in table order) with a valid value
+    AGGREGATE_MIN,         // Lowest valid value
+    AGGREGATE_MEAN         // Mean of all valid values
+};
+
+// Structure of a single route
+struct Route {
+    uint8_t sensor;  // Sensor slot 0..NUM_SENSORS-1
+    uint8_t zone;    // Zone index
+    uint8_t field;   // ZoneField
+};
+
+// Structure of the routing table as stored in NVS
+struct RoutingTable {
+    uint8_t version;
+    uint8_t count;
+    Route routes[MAX_ROUTES];
+    uint8_t aggregation[NUM_ZONES][FIELD_COUNT];
+};
+
+// Function prototypes
+void setupRouting();
+void routeSensorValues(const float sensors[], const float hums[], const float pressures[], const float vocs[]);
+bool parseRoutingTable(const uint8_t* payload, unsigned int length, RoutingTable &table);
+bool requestRoutingUpdate(const RoutingTable &table);
+void applyPendingRouting();
+
+#endif // ROUTING_MODULE_H
@@ -0,0 +1,128 @@
+// Module: scheduler_module.cpp
+// Purpose: Implements the cooperative scheduler used by the main loop.
+// Class Methods:
+// - Scheduler::addTask(): Registers a task with period, phase offset, deadline and priority.
+// - Scheduler::start(): Releases every task at its phase offset from the current time.
+// - Scheduler::run(): Runs all due tasks in priority order and records their run time.
+// - Scheduler::appendStats(): Serializes per-task run counts, overruns, skipped releases and run times for the metrics
+//   document.
+
+
+#include "scheduler_module.h"
+#include "memory_module.h"
+
+// Constructor for Scheduler class
+Scheduler::Scheduler() : taskCount(0) {}
+
+// Register a task; tasks with the same priority keep their registration order
+int Scheduler::addTask(const char* name, void (*callback)(), unsigned long period, unsigned long phase,
+                       unsigned long deadline, uint8_t priority) {
+    if (taskCount >= MAX_SCHEDULER_TASKS || callback == nullptr) {
+        return -1;
+    }
+
+    SchedulerTask &task = tasks[taskCount];
+    task.name = name;
+    task.callback = callback;
+    task.period = period;
+    task.phase = phase;
+    task.deadline = deadline > 0 ? deadline : period;
+    task.priority = priority;
+    task.nextRun = millis() + phase;
+    task.lastRunTime = 0;
+    task.maxRunTime = 0;
+    task.totalRunTime = 0;
+    task.runCount = 0;
+    task.overruns = 0;
+    task.skipped = 0;
+
+    // Insert the new task into the priority order
+    int pos = taskCount;
+    while (pos > 0 && tasks[order[pos - 1]].priority > priority) {
+        order[pos] = order[pos - 1];
+        pos--;
+    }
+    order[pos] = taskCount;
+
+    return taskCount++;
+}
+
+// Release every task at its phase offset from now
+void Scheduler::start() {
+    unsigned long now = millis();
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].nextRun = now + tasks[i].phase;
+    }
+}
+
+// Run all tasks that are due, highest priority first
+void Scheduler::run() {
+    for (int i = 0; i < taskCount; i++) {
+        SchedulerTask &task = tasks[order[i]];
+        unsigned long now = millis();
+        if ((long)(now - task.nextRun) >= 0) {
+            runTask(task, now);
+        }
+    }
+}
+
+// Run a single task and update its statistics and next release time
+void Scheduler::runTask(SchedulerTask &task, unsigned long now) {
+    unsigned long release = task.nextRun;
+    unsigned long start = micros();
+    SET_ALLOCATION_TAG(task.name);
+    task.callback();
+    SET_ALLOCATION_TAG(nullptr);
+    unsigned long duration = micros() - start;
+
+    task.lastRunTime = duration;
+    task.totalRunTime += duration;
+    task.runCount++;
+    if (duration > task.maxRunTime) {
+        task.maxRunTime = duration;
+    }
+
+    // Overrun: completion later than release + deadline
+    if (task.period > 0 && (now - release) + duration / 1000 > task.deadline) {
+        task.overruns++;
+    }
+
+    // Keep a fixed rate on the configured phase. The release that is due runs on the next pass; only releases
+    // whose whole period already lies in the past are skipped instead of run back-to-back
+    task.nextRun = release + task.period;
+    if (task.period > 0) {
+        unsigned long late = millis() - task.nextRun;
+        if ((long)late >= (long)task.period) {
+            unsigned long skipped = late / task.period;
+            task.nextRun += skipped * task.period;
+            task.skipped += skipped;
+        }
+    }
+}
+
+int Scheduler::getTaskCount() const {
+    return taskCount;
+}
+
+const SchedulerTask* Scheduler::getTask(int index) const {
+    if (index < 0 || index >= taskCount) {
+        return nullptr;
+    }
+    return &tasks[index];
+}
+
+// Function to serialize the statistics as {"name": [runs, overruns, skipped, average us, max us], ...}; returns the
+// length snprintf would write. The counters of another core's scheduler are read without a lock, so a task's values may
+// be one run apart.
+size_t Scheduler::appendStats(char* buffer, size_t size) const {
+    size_t length = snprintf(buffer, size, "{");
+    for (int i = 0; i < taskCount && length < size; i++) {
+        const SchedulerTask &task = tasks[i];
+        unsigned long runs = task.runCount;
+        unsigned long average = runs > 0 ? (unsigned long)(task.totalRunTime / runs) : 0;
+        length += snprintf(buffer + length, size - length, "%s\"%s\":[%lu,%lu,%lu,%lu,%lu]", i == 0 ? "" : ",",
+                           task.name, runs, task.overruns, task.skipped, average, task.maxRunTime);
+    }
+    length += length < size ? snprintf(buffer + length, size - length, "}") : 0;
+    return length;
+}
@@ -0,0 +1,55 @@
+// Module: scheduler_module.h
+// Purpose: Declares a cooperative scheduler that runs registered tasks at fixed periods.
+// Definitions:
+// - MAX_SCHEDULER_TASKS: Maximum number of tasks per scheduler.
+// Structures:
+// - SchedulerTask: A registered task with its timing parameters and runtime statistics.
+// Class:
+// - Scheduler: Registers tasks and runs the ones that are due, highest priority first.
+
+
+#ifndef SCHEDULER_MODULE_H
+#define SCHEDULER_MODULE_H
+
+#include <Arduino.h>
+
+#define MAX_SCHEDULER_TASKS 16 // Maximum number of tasks per scheduler
+
+// Structure to hold a scheduled task and its statistics
+struct SchedulerTask {
+    const char* name;             // Name used in statistics output
+    void (*callback)();           // Function to run
+    unsigned long period;         // Period in ms (0: run on every pass)
+    unsigned long phase;          // Offset of the first run in ms, spreads tasks with equal periods
+    unsigned long deadline;       // Maximum time from release to completion in ms (0: period)
+    uint8_t priority;             // Lower value runs first when several tasks are due
+    unsigned long nextRun;        // Next release time in ms
+    unsigned long lastRunTime;    // Duration of the last run in us
+    unsigned long maxRunTime;     // Longest run in us
+    uint64_t totalRunTime;        // Accumulated run time in us; 32 bits wrap after 71 minutes of busy time
+    unsigned long runCount;       // Number of runs
+    unsigned long overruns;       // Runs that finished after their deadline
+    unsigned long skipped;        // Releases skipped because the task was late by a whole period or more
+};
+
+// Class representing a cooperative fixed-period scheduler
+class Scheduler {
+public:
+    Scheduler();
+
+    int addTask(const char* name, void (*callback)(), unsigned long period, unsigned long phase = 0,
+                unsigned long deadline = 0, uint8_t priority = 10); // Returns the task index or -1
+    void start();                                 // Sets the first release of every task relative to now
+    void run();                                   // Runs all tasks that are due
+    int getTaskCount() const;
+    const SchedulerTask* getTask(int index) const;
+    size_t appendStats(char* buffer, size_t size) const; // Serializes run time and overrun statistics
+
+private:
+    SchedulerTask tasks[MAX_SCHEDULER_TASKS];
+    uint8_t order[MAX_SCHEDULER_TASKS];           // Task indices sorted by priority
+    int taskCount;
+    void runTask(SchedulerTask &task, unsigned long now);
+};
+
+#endif // SCHEDULER_MODULE_H
@@ -1,22 +1,113 @@
 // Module: servo_control_module.cpp
 // Purpose: Controls servo motors that adjust air outlets for different heating zones.
 // Functions:
-// - setupServos(): Initializes servos and sets them to their starting positions.
-// - setServoPosition(): Moves a servo to a specified angle based on a percentage (0-100% open).
-// - getServoPosition(): Retrieves the current position (opening percentage) of a servo for a given zone.
+// - setupServos(): Initializes servos, sets them to their starting positions and starts the motion timer.
+// - setServoPosition(): Queues a target for a servo based on a percentage (0-100% open); returns immediately.
+// - getServoPosition(): Retrieves the commanded or in-flight position (opening percentage) of a servo for a given zone.
+// - setServoProfile(): Sets the slew rate and acceleration of a servo.
+// - isServoMoving(): Checks whether a servo is still moving towards its targets.
+// - updateServoMotion(): Timer callback that ramps all servos concurrently.
 
 
 #include "servo_control_module.h"
+#include "log_module.h"
+#include <esp_timer.h>
+
+#define SERVO_DEFAULT_PROFILE {SERVO_DEFAULT_SPEED, SERVO_DEFAULT_ACCELERATION}
 
 // Array to store servo configurations
 ServoControl servos[MAX_SERVOS] = {
-    {Servo(), 4, false, 0},
-    {Servo(), 5, false, 0},
-    {Servo(), 6, false, 0},
-    {Servo(), 1, false, 0},
-    {Servo(), 2, false, 0}
+    {Servo(), 4, false, 0, SERVO_DEFAULT_PROFILE},
+    {Servo(), 5, false, 0, SERVO_DEFAULT_PROFILE},
+    {Servo(), 6, false, 0, SERVO_DEFAULT_PROFILE},
+    {Servo(), 1, false, 0, SERVO_DEFAULT_PROFILE},
+    {Servo(), 2, false, 0, SERVO_DEFAULT_PROFILE}
 };
 
+// Protects the motion state shared between the motion timer and the callers
+static portMUX_TYPE servoMux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t servoTimer = nullptr;
+
+// Function to look up the servo of a zone; returns -1 if it is not available
+static int getServoIndex(int zoneIndex) {
+    // Check if the zone index is valid
+    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES) {
+        LOG_WARN(LOG_MODULE_SERVO, "Invalid zone index %d for servo.", zoneIndex);
+        return -1;
+    }
+
+    // Check if the servo for this zone is available
+    int servoIndex = zones[zoneIndex].servoValve - 1;
+    if (servoIndex < 0 || servoIndex >= MAX_SERVOS || !servos[servoIndex].isAttached) {
+        LOG_DEBUG(LOG_MODULE_SERVO, "Servo for zone %d not available or not attached.", zoneIndex);
+        return -1;
+    }
+    return servoIndex;
+}
+
+// Timer callback: advance every servo one step along its motion profile
+static void updateServoMotion(void* arg) {
+    const float dt = SERVO_UPDATE_INTERVAL / 1000.0f;
+
+    for (int i = 0; i < MAX_SERVOS; i++) {
+        ServoControl &s = servos[i];
+        if (!s.isAttached) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&servoMux);
+        // Take the next queued target once the current one is reached
+        if (s.position == s.targetAngle && s.velocity == 0 && s.queueCount > 0) {
+            s.targetAngle = s.queue[s.queueHead];
+            s.queueHead = (s.queueHead + 1) % SERVO_QUEUE_SIZE;
+            s.queueCount--;
+        }
+        float distance = s.targetAngle - s.position;
+        ServoProfile profile = s.profile;
+        portEXIT_CRITICAL(&servoMux);
+
+        if (distance == 0 && s.velocity == 0) {
+            continue;
+        }
+
+        // Trapezoidal profile: brake when moving away, decelerate once the stopping distance is reached
+        float direction = distance > 0 ? 1.0f : (distance < 0 ? -1.0f : (s.velocity > 0 ? -1.0f : 1.0f));
+        float velocity = s.velocity;
+        if (velocity * direction < 0 || distance == 0) {
+            velocity += direction * profile.acceleration * dt;
+            if (velocity * direction > 0) {
+                velocity = 0;
+            }
+        } else {
+            float speed = fabsf(velocity);
+            float stoppingDistance = speed * speed / (2.0f * profile.acceleration);
+            if (fabsf(distance) <= stoppingDistance) {
+                speed = max(profile.acceleration * dt, speed - profile.acceleration * dt);
+            } else {
+                speed = min(profile.maxSpeed, speed + profile.acceleration * dt);
+            }
+            velocity = direction * speed;
+        }
+
+        float newPosition = s.position + velocity * dt;
+        if (distance != 0 && velocity * direction > 0 && fabsf(velocity * dt) >= fabsf(distance)) {
+            newPosition = s.targetAngle; // Target reached
+            velocity = 0;
+        }
+
+        portENTER_CRITICAL(&servoMux);
+        s.position = newPosition;
+        s.velocity = velocity;
+        portEXIT_CRITICAL(&servoMux);
+
+        int angle = (int)lroundf(newPosition);
+        if (angle != s.writtenAngle) {
+            s.servo.write(angle);
+            s.writtenAngle = angle;
+        }
+    }
+}
+
 // Function to set up servos
 void setupServos() {
     for (int i = 0; i < MAX_SERVOS; i++) {
@@ -25,68 +116,103 @@ void setupServos() {
             servos[i].isAttached = true;
             servos[i].servo.write(0); // Set servo to 0° at start
             servos[i].currentAnglePercentage = 0;
+            servos[i].position = 0;
+            servos[i].velocity = 0;
+            servos[i].writtenAngle = 0;
+            servos[i].targetAngle = 0;
+            servos[i].queueHead = 0;
+            servos[i].queueCount = 0;
             Serial.printf("Servo on pin %d set to starting position 0°.\n", servos[i].pin);
         }
     }
+
+    // Start the motion timer that ramps all servos concurrently
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &updateServoMotion,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "servo_motion"
+    };
+    if (esp_timer_create(&timerArgs, &servoTimer) == ESP_OK) {
+        esp_timer_start_periodic(servoTimer, SERVO_UPDATE_INTERVAL * 1000);
+    } else {
+        LOG_ERROR(LOG_MODULE_SERVO, "Failed to create servo motion timer.");
+    }
 }
 
 // Function to set the position of a servo based on zone index and angle percentage
 void setServoPosition(int zoneIndex, int anglePercentage) {
-    static bool isServoOperating = false;
-    while (isServoOperating) {
-        delay(10); // Wait until the current servo operation is complete
-    }
-    isServoOperating = true;
-    // Check if the zone index is valid
-    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES) {
-        Serial.println("Invalid zone index for servo positioning.");
-        isServoOperating = false;
-        return;
-    }
-
-    // Check if the servo for this zone is available
-    int servoIndex = zones[zoneIndex].servoValve - 1;
-    if (servoIndex < 0 || servoIndex >= MAX_SERVOS || !servos[servoIndex].isAttached) {
-        Serial.printf("Servo for zone %d not available or not attached.\n", zoneIndex);
-        isServoOperating = false;
+    int servoIndex = getServoIndex(zoneIndex);
+    if (servoIndex < 0) {
         return;
     }
+    ServoControl &s = servos[servoIndex];
 
-    // Calculate angle based on the specified opening percentage (0% to 90%)
-    int angle = map(anglePercentage, 0, 100, 0, 90);
+    // Calculate angle based on the specified opening percentage (0% to 90°)
+    anglePercentage = constrain(anglePercentage, 0, 100);
+    int angle = map(anglePercentage, 0, 100, 0, SERVO_MAX_ANGLE);
 
-    // Move the servo slowly to the calculated angle
-    int currentAngle = servos[servoIndex].servo.read();
-    if (currentAngle < angle) {
-        for (int pos = currentAngle; pos <= angle; pos++) {
-            servos[servoIndex].servo.write(pos);
-            delay(SERVO_SPEED_DELAY); // Slow upward movement
-        }
-    } else {
-        for (int pos = currentAngle; pos >= angle; pos--) {
-            servos[servoIndex].servo.write(pos);
-            delay(SERVO_SPEED_DELAY); // Slow downward movement
+    portENTER_CRITICAL(&servoMux);
+    int lastTarget = s.queueCount > 0 ? s.queue[(s.queueHead + s.queueCount - 1) % SERVO_QUEUE_SIZE] : s.targetAngle;
+    bool queued = false;
+    if (angle != lastTarget) {
+        if (s.queueCount < SERVO_QUEUE_SIZE) {
+            s.queue[(s.queueHead + s.queueCount) % SERVO_QUEUE_SIZE] = angle;
+            s.queueCount++;
+        } else {
+            // Queue full: the newest command replaces the last queued target
+            s.queue[(s.queueHead + s.queueCount - 1) % SERVO_QUEUE_SIZE] = angle;
         }
+        queued = true;
+    }
+    s.currentAnglePercentage = anglePercentage;
+    portEXIT_CRITICAL(&servoMux);
+
+    if (queued) {
+        LOG_DEBUG(LOG_MODULE_SERVO, "Servo in zone %d set to %d%% (angle: %d°, pin: %d).", zoneIndex, anglePercentage, angle, s.pin);
     }
-    servos[servoIndex].currentAnglePercentage = anglePercentage;
-    isServoOperating = false;
-    Serial.printf("Servo in zone %d set to %d%% (angle: %d°, pin: %d).\n", zoneIndex, anglePercentage, angle, servos[servoIndex].pin);
 }
 
-// Function to get the current position (angle percentage) of a servo
-int getServoPosition(int zoneIndex) {
-    // Check if the zone index is valid
-    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES) {
-        Serial.println("Invalid zone index for servo position query.");
+// Function to get the commanded or in-flight position (angle percentage) of a servo
+int getServoPosition(int zoneIndex, bool inFlight) {
+    int servoIndex = getServoIndex(zoneIndex);
+    if (servoIndex < 0) {
         return -1;
     }
 
-    // Check if the servo for this zone is available
-    int servoIndex = zones[zoneIndex].servoValve - 1;
-    if (servoIndex < 0 || servoIndex >= MAX_SERVOS || !servos[servoIndex].isAttached) {
-        Serial.printf("Servo for zone %d not available or not attached.\n", zoneIndex);
-        return -1;
+    if (!inFlight) {
+        return servos[servoIndex].currentAnglePercentage;
+    }
+
+    portENTER_CRITICAL(&servoMux);
+    float position = servos[servoIndex].position;
+    portEXIT_CRITICAL(&servoMux);
+    return (int)lroundf(position * 100.0f / SERVO_MAX_ANGLE);
+}
+
+// Function to set the slew rate (degrees/s) and acceleration (degrees/s^2) of a zone's servo
+void setServoProfile(int zoneIndex, float maxSpeed, float acceleration) {
+    int servoIndex = getServoIndex(zoneIndex);
+    if (servoIndex < 0 || maxSpeed <= 0 || acceleration <= 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&servoMux);
+    servos[servoIndex].profile.maxSpeed = maxSpeed;
+    servos[servoIndex].profile.acceleration = acceleration;
+    portEXIT_CRITICAL(&servoMux);
+}
+
+// Function to check whether a zone's servo is still moving or has queued targets
+bool isServoMoving(int zoneIndex) {
+    int servoIndex = getServoIndex(zoneIndex);
+    if (servoIndex < 0) {
+        return false;
     }
 
-    return servos[servoIndex].currentAnglePercentage;
+    portENTER_CRITICAL(&servoMux);
+    const ServoControl &s = servos[servoIndex];
+    bool moving = s.queueCount > 0 || s.position != s.targetAngle || s.velocity != 0;
+    portEXIT_CRITICAL(&servoMux);
+    return moving;
 }
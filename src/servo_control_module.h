@@ -2,13 +2,18 @@
 // Purpose: Declares functions and structures for controlling servo motors.
 // Definitions:
 // - MAX_SERVOS: Maximum number of servos supported.
-// - SERVO_SPEED_DELAY: Delay between servo movements for smooth operation.
+// - SERVO_UPDATE_INTERVAL: Period of the motion timer.
+// - SERVO_DEFAULT_SPEED, SERVO_DEFAULT_ACCELERATION: Default motion profile.
+// - SERVO_QUEUE_SIZE: Number of targets that can be queued per servo.
 // Structures:
-// - ServoControl: Contains information about a servo, including its pin, attachment status, and current angle.
+// - ServoProfile: Slew rate and acceleration limits of a servo.
+// - ServoControl: Contains information about a servo, including its pin, attachment status, motion state and target queue.
 // Function Prototypes:
 // - setupServos()
 // - setServoPosition()
 // - getServoPosition()
+// - setServoProfile()
+// - isServoMoving()
 
 
 #ifndef SERVO_CONTROL_MODULE_H
@@ -18,20 +23,40 @@
 #include <Arduino.h>
 #include <ESP32Servo.h> // Use the ESP32-specific Servo library
 
-#define MAX_SERVOS 5          // Maximum number of connected servos
-#define SERVO_SPEED_DELAY 5   // Delay for smooth servo movement (in ms)
+#define MAX_SERVOS 5                    // Maximum number of connected servos
+#define SERVO_MAX_ANGLE 90              // Angle for a fully open valve (100%)
+#define SERVO_UPDATE_INTERVAL 20        // Motion timer period (in ms)
+#define SERVO_DEFAULT_SPEED 200.0f      // Default slew rate (in degrees per second)
+#define SERVO_DEFAULT_ACCELERATION 800.0f // Default acceleration (in degrees per second^2)
+#define SERVO_QUEUE_SIZE 4              // Queued targets per servo
+
+// Structure to hold the motion profile of a servo
+struct ServoProfile {
+    float maxSpeed;     // Maximum slew rate in degrees per second
+    float acceleration; // Acceleration and deceleration in degrees per second^2
+};
 
 // Structure to hold servo control information
 struct ServoControl {
     Servo servo;
     int pin;
     bool isAttached;
-    int currentAnglePercentage; // Stores the current opening percentage
+    int currentAnglePercentage;          // Stores the commanded opening percentage
+    ServoProfile profile;                // Motion profile
+    float position;                      // In-flight angle in degrees
+    float velocity;                      // Current velocity in degrees per second
+    int writtenAngle;                    // Last angle written to the servo
+    int targetAngle;                     // Angle of the target currently being approached
+    int queue[SERVO_QUEUE_SIZE];         // Queued target angles
+    uint8_t queueHead;
+    uint8_t queueCount;
 };
 
 // Function prototypes
 void setupServos();
 void setServoPosition(int zoneIndex, int anglePercentage);
-int getServoPosition(int zoneIndex);
+int getServoPosition(int zoneIndex, bool inFlight = false);
+void setServoProfile(int zoneIndex, float maxSpeed, float acceleration);
+bool isServoMoving(int zoneIndex);
 
 #endif // SERVO_CONTROL_MODULE_H
@@ -0,0 +1,178 @@
+// Module: settings_module.cpp
+// Purpose: Write-behind store of the zone targets and modes. The network task compares every telemetry
+//          snapshot with the values seen last; a difference marks the record dirty, and the record is written
+//          when the changes have been quiet long enough or the first of them is too old. Values that changed
+//          back before the write cost nothing. The record carries its lifetime write count, which the metrics
+//          document reports as "nvs": {"writes": 3, "settings_writes": 41, "coalesced": 17, "pending": false}
+//          next to the writes of all modules and the changes absorbed since boot.
+// Functions:
+// - setupSettings(): Loads the record and applies it to the control state.
+// - settingsTask(): Collects changes from the telemetry and writes the record when due.
+// - flushSettings(), requestSettingsFlush(): Write pending changes now, or on the next pass.
+// - countNVSWrite(): Counts a write for the statistics.
+// - appendSettingsMetrics(): Serializes the statistics.
+// - captureSettings(): Takes the persisted values from a snapshot.
+// - writeSettings(): Writes the record if it differs from the stored one.
+
+
+#include "settings_module.h"
+#include "tasks_module.h"
+#include "zones_module.h"
+#include "heater_automation_module.h"
+#include "zone_descriptors.h"
+#include "log_module.h"
+#include <Preferences.h>
+#include <atomic>
+
+// Structure of the NVS record
+struct StoredSettings {
+    uint8_t version;
+    uint32_t writes;        // Writes of this record since it was first stored
+    PersistentSettings settings;
+};
+
+// Record as stored and the latest values seen; owned by the network task after setup
+static PersistentSettings storedSettings;
+static PersistentSettings pendingSettings;
+static bool settingsDirty = false;
+static unsigned long firstChange = 0;
+static unsigned long lastChange = 0;
+static unsigned long lastTimestamp = 0;
+static std::atomic<bool> flushRequested(false);
+
+// Write statistics
+static uint32_t settingsWrites = 0;     // Lifetime writes of the record
+static uint32_t nvsWrites = 0;          // Writes of all modules since boot
+static uint32_t coalescedChanges = 0;   // Changes since boot that were absorbed by a later write
+
+// Function to restore the stored record; zones without a stored record keep the defaults of zone_descriptors
+void setupSettings() {
+    StoredSettings stored;
+    Preferences preferences;
+    bool loaded = false;
+
+    if (preferences.begin(SETTINGS_NVS_NAMESPACE, true)) {
+        loaded = preferences.getBytesLength(SETTINGS_NVS_KEY) == sizeof(stored) &&
+                 preferences.getBytes(SETTINGS_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+                 stored.version == SETTINGS_VERSION;
+        preferences.end();
+    }
+    if (loaded) {
+        // The record holds the centi-degrees of ZoneState, so they are copied as they are
+        memcpy(zoneState.target, stored.settings.target, sizeof(zoneState.target));
+        zoneState.targetValid = stored.settings.targetValid;
+        automationActive = stored.settings.automationActive;
+        valveModeProportional = stored.settings.valveModeProportional;
+        settingsWrites = stored.writes;
+    }
+
+    memset(&storedSettings, 0, sizeof(storedSettings));
+    memcpy(storedSettings.target, zoneState.target, sizeof(storedSettings.target));
+    storedSettings.targetValid = zoneState.targetValid;
+    storedSettings.automationActive = automationActive;
+    storedSettings.valveModeProportional = valveModeProportional;
+    pendingSettings = storedSettings;
+    LOG_INFO(LOG_MODULE_MAIN, "Settings restored (%s), %lu writes", loaded ? "NVS" : "default", (unsigned long)settingsWrites);
+}
+
+// Function to take the persisted values from a snapshot; zones outside the snapshot keep their values
+static void captureSettings(const Telemetry &telemetry, PersistentSettings &settings) {
+    settings = pendingSettings;
+    for (uint8_t i : activeZones) {
+        float target = telemetry.zones[i].temperatureTarget;
+        if (isnan(target)) {
+            settings.targetValid &= ~ZONE_BIT(i);
+        } else {
+            settings.target[i] = toCentiDegrees(target);
+            settings.targetValid |= ZONE_BIT(i);
+        }
+    }
+    settings.automationActive = telemetry.automationActive;
+    settings.valveModeProportional = telemetry.valveModeProportional;
+}
+
+// Function to write the pending values; nothing is written if they match the stored record
+static void writeSettings() {
+    settingsDirty = false;
+    if (memcmp(&pendingSettings, &storedSettings, sizeof(PersistentSettings)) == 0) {
+        LOG_DEBUG(LOG_MODULE_MAIN, "Settings changed back, nothing to write");
+        return;
+    }
+
+    StoredSettings stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.version = SETTINGS_VERSION;
+    stored.writes = settingsWrites + 1;
+    stored.settings = pendingSettings;
+
+    Preferences preferences;
+    size_t written = 0;
+    if (preferences.begin(SETTINGS_NVS_NAMESPACE, false)) {
+        written = preferences.putBytes(SETTINGS_NVS_KEY, &stored, sizeof(stored));
+        preferences.end();
+    }
+    if (written != sizeof(stored)) {
+        // Try again after another quiet period
+        settingsDirty = true;
+        firstChange = lastChange = millis();
+        LOG_ERROR(LOG_MODULE_MAIN, "Settings could not be written to NVS");
+        return;
+    }
+
+    storedSettings = pendingSettings;
+    settingsWrites = stored.writes;
+    countNVSWrite();
+    LOG_INFO(LOG_MODULE_MAIN, "Settings written (write %lu)", (unsigned long)settingsWrites);
+}
+
+// Task: collect changes from the latest snapshot and write them once quiet or overdue
+void settingsTask() {
+    unsigned long now = millis();
+    if (hasTelemetry()) {
+        const Telemetry &telemetry = receiveTelemetry();
+        if (telemetry.timestamp != lastTimestamp) {
+            lastTimestamp = telemetry.timestamp;
+            PersistentSettings current;
+            captureSettings(telemetry, current);
+            if (memcmp(&current, &pendingSettings, sizeof(current)) != 0) {
+                pendingSettings = current;
+                if (settingsDirty) {
+                    coalescedChanges++;
+                } else {
+                    settingsDirty = true;
+                    firstChange = now;
+                }
+                lastChange = now;
+            }
+        }
+    }
+
+    bool requested = flushRequested.exchange(false);
+    if (settingsDirty && (requested || now - lastChange >= SETTINGS_QUIET_PERIOD || now - firstChange >= SETTINGS_MAX_DELAY)) {
+        writeSettings();
+    }
+}
+
+// Function to write pending changes at once; runs on the network task
+void flushSettings() {
+    if (settingsDirty) {
+        writeSettings();
+    }
+}
+
+// Function to have the next settingsTask() pass write pending changes; safe from any task
+void requestSettingsFlush() {
+    flushRequested.store(true);
+}
+
+// Function to count a write to NVS; runs on the network task
+void countNVSWrite() {
+    nvsWrites++;
+}
+
+// Function to serialize the statistics as "nvs": {...}; returns the length snprintf would write
+size_t appendSettingsMetrics(char* buffer, size_t size) {
+    return snprintf(buffer, size, "\"nvs\":{\"writes\":%lu,\"settings_writes\":%lu,\"coalesced\":%lu,\"pending\":%s}",
+                    (unsigned long)nvsWrites, (unsigned long)settingsWrites, (unsigned long)coalescedChanges,
+                    settingsDirty ? "true" : "false");
+}
@@ -0,0 +1,50 @@
+// Module: settings_module.h
+// Purpose: Declares the persistence of the zone targets, the automation switch and the valve mode. Changes are
+//          taken from the telemetry snapshots, collected in RAM and written to NVS as one record once they have
+//          been quiet for SETTINGS_QUIET_PERIOD, or at the latest SETTINGS_MAX_DELAY after the first of them.
+//          A slider dragged through twenty values costs one flash write.
+// Definitions:
+// - SETTINGS_NVS_NAMESPACE, SETTINGS_NVS_KEY: Where the record is stored.
+// - SETTINGS_VERSION: Record layout; increment when PersistentSettings changes.
+// - SETTINGS_QUIET_PERIOD: Time without changes before the record is written.
+// - SETTINGS_MAX_DELAY: Longest time a change stays unwritten while changes keep coming.
+// Structures:
+// - PersistentSettings: The persisted values.
+// Function Prototypes:
+// - setupSettings(): Restores the stored values; runs before the control task starts.
+// - settingsTask(): Collects changes and writes them when due (network task).
+// - flushSettings(): Writes pending changes at once (network task), e.g. before an OTA update.
+// - requestSettingsFlush(): Has the next settingsTask() pass write pending changes; safe from any task.
+// - countNVSWrite(): Counts a write of another module for the write statistics (network task).
+// - appendSettingsMetrics(): Serializes the write statistics into the metrics document.
+
+
+#ifndef SETTINGS_MODULE_H
+#define SETTINGS_MODULE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define SETTINGS_NVS_NAMESPACE "settings"
+#define SETTINGS_NVS_KEY "state"
+#define SETTINGS_VERSION 1
+#define SETTINGS_QUIET_PERIOD 10000     // (in ms)
+#define SETTINGS_MAX_DELAY 60000        // (in ms)
+
+// Structure of the persisted values; targets in the centi-degrees of ZoneState
+struct PersistentSettings {
+    int16_t target[NUM_ZONES];
+    uint16_t targetValid;
+    bool automationActive;
+    bool valveModeProportional;
+};
+
+// Function prototypes
+void setupSettings();
+void settingsTask();
+void flushSettings();
+void requestSettingsFlush();
+void countNVSWrite();
+size_t appendSettingsMetrics(char* buffer, size_t size);
+
+#endif // SETTINGS_MODULE_H
@@ -0,0 +1,191 @@
+// Module: signalk_module.cpp
+// Purpose: Signal K WebSocket client. After connecting it sends one subscription for the control paths:
+//          {"context": "vessels.self", "subscribe": [{"path": "heater.*.target_temperature", "policy": "instant"}, ...]}
+//          and dispatches the values of incoming deltas through the topic registry, so a path is handled exactly
+//          like the matching N/ topic. Updates labelled with SIGNALK_SOURCE are echoes of the own deltas and are
+//          skipped. Outgoing deltas are built by publish_module.
+// Functions:
+// - setupSignalK(): Builds the subscription message and the parse filter.
+// - serviceSignalK(): Starts the client once WiFi is up and runs it on every network task pass.
+// - disconnectSignalK(): Closes the connection and stops reconnecting.
+// - isSignalKConnected(): Returns whether the connection is up.
+// - sendSignalKDelta(): Sends a delta as one text frame.
+// - handleSignalKEvent(): Handles connection changes and text frames.
+// - handleSignalKMessage(): Parses a hello or delta message and dispatches the values.
+
+
+#include "signalk_module.h"
+#include "message_module.h"
+#include "publish_module.h"
+#include "topic_module.h"
+#include "metrics_module.h"
+#include "log_module.h"
+#include <WebSocketsClient.h>
+
+// Paths the controller acts on, relative to vessels.self
+static const char* const subscriptionPaths[] = {
+    SIGNALK_PATH ".*.target_temperature",
+    SIGNALK_PATH ".toggle",
+    SIGNALK_PATH ".heater_automation_mode",
+    SIGNALK_PATH ".valve_mode",
+    SIGNALK_PATH ".transport"
+};
+
+static WebSocketsClient webSocket;
+static bool signalKStarted = false;
+static bool signalKConnected = false;
+static char subscribeMessage[384];
+static size_t subscribeLength = 0;
+static JsonDocument messageFilter;
+
+// Function to check whether an update was sent by this controller
+static bool isOwnUpdate(JsonObjectConst update) {
+    const size_t sourceLength = strlen(SIGNALK_SOURCE);
+    const char* label = update["source"]["label"] | "";
+    const char* source = update["$source"] | "";
+    return strcmp(label, SIGNALK_SOURCE) == 0 ||
+           (strncmp(source, SIGNALK_SOURCE, sourceLength) == 0 && (source[sourceLength] == '\0' || source[sourceLength] == '.'));
+}
+
+// Function to hand the value of a path to the inbound handler of the path; booleans become 1 or 0. Path and value
+// live in the parsed document, so they are logged with logPrintf()
+static void dispatchValue(const char* path, JsonVariantConst value) {
+    const InboundTopic* route = findInboundTopic(path);
+    if (route == nullptr || value.isNull()) {
+        return;
+    }
+
+    char payload[SIGNALK_VALUE_SIZE];
+    size_t length;
+    if (value.is<bool>()) {
+        length = snprintf(payload, sizeof(payload), "%d", value.as<bool>() ? 1 : 0);
+    } else if (measureJson(value) < sizeof(payload)) {
+        length = serializeJson(value, payload, sizeof(payload));
+    } else {
+        logPrintf(LEVEL_WARN, LOG_MODULE_MQTT, "Signal K value of %s does not fit the buffer", path);
+        return;
+    }
+    logPrintf(LEVEL_DEBUG, LOG_MODULE_MQTT, "Signal K %s = %s", path, payload);
+    handleInboundMessage(route, (const uint8_t*)payload, length);
+}
+
+// Function to parse a message from the server, e.g.
+// {"context": "vessels.urn:mrn:...", "updates": [{"$source": "ws.app", "values": [{"path": "heater.Cabin.target_temperature", "value": 21}]}]}
+static void handleSignalKMessage(const uint8_t* payload, size_t length) {
+    if (length > SIGNALK_MESSAGE_SIZE) {
+        LOG_WARN(LOG_MODULE_MQTT, "Signal K message of %u bytes ignored", (unsigned)length);
+        return;
+    }
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length, DeserializationOption::Filter(messageFilter))) {
+        LOG_WARN(LOG_MODULE_MQTT, "Signal K message is not valid JSON");
+        return;
+    }
+
+    // The hello message after connecting names the server
+    if (doc["name"].is<const char*>()) {
+        logPrintf(LEVEL_INFO, LOG_MODULE_MQTT, "Signal K server %s %s", doc["name"].as<const char*>(), doc["version"] | "");
+        return;
+    }
+
+    for (JsonObjectConst update : doc["updates"].as<JsonArrayConst>()) {
+        if (isOwnUpdate(update)) {
+            continue;
+        }
+        for (JsonObjectConst entry : update["values"].as<JsonArrayConst>()) {
+            dispatchValue(entry["path"] | "", entry["value"]);
+        }
+    }
+}
+
+// Callback for connection changes and received frames; runs inside webSocket.loop()
+static void handleSignalKEvent(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_CONNECTED:
+            signalKConnected = true;
+            LOG_INFO(LOG_MODULE_MQTT, "Signal K connected to %s:%d", SIGNALK_HOST, SIGNALK_PORT);
+            webSocket.sendTXT(subscribeMessage, subscribeLength);
+            resendAllData(); // The server may have restarted; the next delta carries every value
+            break;
+
+        case WStype_DISCONNECTED:
+            if (signalKConnected) {
+                LOG_WARN(LOG_MODULE_MQTT, "Signal K connection lost");
+            }
+            signalKConnected = false;
+            break;
+
+        case WStype_TEXT:
+            handleSignalKMessage(payload, length);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Function to build the subscription message and the parse filter
+void setupSignalK() {
+    subscribeLength = snprintf(subscribeMessage, sizeof(subscribeMessage), "{\"context\":\"vessels.self\",\"subscribe\":[");
+    for (size_t i = 0; i < sizeof(subscriptionPaths) / sizeof(subscriptionPaths[0]); i++) {
+        subscribeLength += snprintf(subscribeMessage + subscribeLength, sizeof(subscribeMessage) - subscribeLength,
+                                    "%s{\"path\":\"%s\",\"policy\":\"instant\"}", i == 0 ? "" : ",", subscriptionPaths[i]);
+    }
+    subscribeLength += snprintf(subscribeMessage + subscribeLength, sizeof(subscribeMessage) - subscribeLength, "]}");
+    if (subscribeLength >= sizeof(subscribeMessage)) {
+        LOG_ERROR(LOG_MODULE_MQTT, "Signal K subscription does not fit the buffer");
+        subscribeLength = 0;
+    }
+
+    // Only the fields read by handleSignalKMessage() are kept while parsing
+    messageFilter["name"] = true;
+    messageFilter["version"] = true;
+    JsonObject update = messageFilter["updates"].add<JsonObject>();
+    update["$source"] = true;
+    update["source"]["label"] = true;
+    JsonObject value = update["values"].add<JsonObject>();
+    value["path"] = true;
+    value["value"] = true;
+}
+
+// Function to connect and run the client; the client reconnects on its own every SIGNALK_RECONNECT_INTERVAL
+void serviceSignalK() {
+    if (WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+    if (!signalKStarted) {
+        webSocket.begin(SIGNALK_HOST, SIGNALK_PORT, SIGNALK_STREAM_URL);
+        if (strlen(SIGNALK_TOKEN) > 0) {
+            webSocket.setExtraHeaders("Authorization: Bearer " SIGNALK_TOKEN);
+        }
+        webSocket.onEvent(handleSignalKEvent);
+        webSocket.setReconnectInterval(SIGNALK_RECONNECT_INTERVAL);
+        webSocket.enableHeartbeat(SIGNALK_PING_INTERVAL, SIGNALK_PONG_TIMEOUT, SIGNALK_PONG_MISSES);
+        signalKStarted = true;
+    }
+    uint32_t probe = beginProbe();
+    webSocket.loop();
+    endProbe(METRIC_SIGNALK_LOOP, probe);
+}
+
+// Function to close the connection; serviceSignalK() starts the client again
+void disconnectSignalK() {
+    if (signalKStarted) {
+        signalKConnected = false; // Not a lost connection, so the event handler stays quiet
+        signalKStarted = false;
+        webSocket.disconnect();
+    }
+}
+
+// Function to check whether the connection is up
+bool isSignalKConnected() {
+    return signalKConnected && webSocket.isConnected();
+}
+
+// Function to send a delta document; returns false if it was not sent
+bool sendSignalKDelta(const char* delta, size_t length) {
+    if (!isSignalKConnected()) {
+        return false;
+    }
+    return webSocket.sendTXT(delta, length);
+}
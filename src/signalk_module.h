@@ -0,0 +1,41 @@
+// Module: signalk_module.h
+// Purpose: Declares the Signal K WebSocket transport. The controller connects straight to the stream endpoint of
+//          a Signal K server, subscribes only to the paths it acts on and sends its values as batched deltas
+//          over the one persistent connection.
+// Definitions:
+// - SIGNALK_STREAM_URL: Stream endpoint; subscribe=none, so only the explicit subscription is delivered.
+// - SIGNALK_RECONNECT_INTERVAL: Delay between connection attempts.
+// - SIGNALK_PING_INTERVAL, SIGNALK_PONG_TIMEOUT, SIGNALK_PONG_MISSES: WebSocket heartbeat; the connection is
+//   dropped after SIGNALK_PONG_MISSES unanswered pings.
+// - SIGNALK_MESSAGE_SIZE: Largest inbound message that is parsed.
+// - SIGNALK_VALUE_SIZE: Largest serialized value handed to the inbound handlers.
+// Function Prototypes:
+// - setupSignalK(): Prepares the client; nothing connects until serviceSignalK() runs.
+// - serviceSignalK(): Connects, reconnects and runs the client (network task).
+// - disconnectSignalK(): Closes the connection when another transport is selected.
+// - isSignalKConnected(): Returns whether the connection is up.
+// - sendSignalKDelta(): Sends a serialized delta document.
+
+
+#ifndef SIGNALK_MODULE_H
+#define SIGNALK_MODULE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define SIGNALK_STREAM_URL "/signalk/v1/stream?subscribe=none"
+#define SIGNALK_RECONNECT_INTERVAL 5000     // (in ms)
+#define SIGNALK_PING_INTERVAL 15000         // (in ms)
+#define SIGNALK_PONG_TIMEOUT 3000           // (in ms)
+#define SIGNALK_PONG_MISSES 2
+#define SIGNALK_MESSAGE_SIZE 4096
+#define SIGNALK_VALUE_SIZE 96
+
+// Function prototypes
+void setupSignalK();
+void serviceSignalK();
+void disconnectSignalK();
+bool isSignalKConnected();
+bool sendSignalKDelta(const char* delta, size_t length);
+
+#endif // SIGNALK_MODULE_H
@@ -0,0 +1,93 @@
+// Module: dht_capture_sim.cpp
+// Purpose: Native replacement of dht_capture_module.cpp. A capture synthesizes the pulse train of the
+//          fake DHT22 on the pin, so the firmware decodes the same frames it gets from the RMT receiver.
+// Functions:
+// - simEncodeDHT22(): Encodes temperature and humidity as a DHT22 frame with slightly jittered timing.
+// - setupDHTCapture(), holdDHTStart(), startDHTCapture(), collectDHTCapture(): Fake capture API.
+
+
+#include "dht_capture_module.h"
+#include "hal/sim_hal.h"
+#include <esp_timer.h>
+
+#define SIM_DHT_FRAME_TIME 5000     // A frame is complete about 5 ms after the start signal ends
+
+// Structure of a fake receive channel
+struct SimCaptureChannel {
+    bool receiving;
+    uint64_t ready;         // Time the frame is complete
+    DHTPulse pulses[DHT_MAX_PULSES];
+    int count;
+};
+
+static SimCaptureChannel captureChannels[DHT_CAPTURE_CHANNELS];
+
+// Function to append a pulse; the duration varies by a few µs like the clock of a real sensor
+static void addPulse(DHTPulse* pulses, int &count, int maxPulses, uint8_t level, int duration) {
+    if (count < maxPulses) {
+        pulses[count++] = {level, (uint16_t)(duration + random(-3, 4))};
+    }
+}
+
+// Function to encode a DHT22 frame; returns the number of pulses
+int simEncodeDHT22(float temperature, float humidity, DHTPulse* pulses, int maxPulses) {
+    uint16_t rawHumidity = (uint16_t)lroundf(constrain(humidity, 0.0f, 100.0f) * 10);
+    uint16_t rawTemperature = (uint16_t)lroundf(fabsf(temperature) * 10) & 0x7FFF;
+    if (temperature < 0) {
+        rawTemperature |= 0x8000;
+    }
+    uint8_t data[5] = {(uint8_t)(rawHumidity >> 8), (uint8_t)rawHumidity,
+                       (uint8_t)(rawTemperature >> 8), (uint8_t)rawTemperature, 0};
+    data[4] = data[0] + data[1] + data[2] + data[3];
+
+    int count = 0;
+    addPulse(pulses, count, maxPulses, 1, 30);     // Pull-up after the host released the line
+    addPulse(pulses, count, maxPulses, 0, 80);     // Response
+    addPulse(pulses, count, maxPulses, 1, 80);
+    for (int bit = 0; bit < 40; bit++) {
+        bool one = data[bit / 8] & (0x80 >> (bit % 8));
+        addPulse(pulses, count, maxPulses, 0, 50);
+        addPulse(pulses, count, maxPulses, 1, one ? 70 : 26);
+    }
+    addPulse(pulses, count, maxPulses, 0, 50);     // End of frame
+    return count;
+}
+
+bool setupDHTCapture() {
+    for (SimCaptureChannel &channel : captureChannels) {
+        channel = {};
+    }
+    return true;
+}
+
+void holdDHTStart(uint8_t pin) {
+    digitalWrite(pin, LOW);
+}
+
+bool startDHTCapture(int channel, uint8_t pin) {
+    if (channel < 0 || channel >= DHT_CAPTURE_CHANNELS) {
+        return false;
+    }
+    SimCaptureChannel &capture = captureChannels[channel];
+    float temperature, humidity;
+    capture.count = simGetDHT(pin, temperature, humidity) ? simEncodeDHT22(temperature, humidity, capture.pulses, DHT_MAX_PULSES) : 0;
+    capture.ready = esp_timer_get_time() + SIM_DHT_FRAME_TIME;
+    capture.receiving = true;
+    digitalWrite(pin, HIGH);
+    return true;
+}
+
+int collectDHTCapture(int channel, DHTPulse* pulses, int maxPulses) {
+    if (channel < 0 || channel >= DHT_CAPTURE_CHANNELS) {
+        return 0;
+    }
+    SimCaptureChannel &capture = captureChannels[channel];
+    // Without a sensor the line stays idle and the receiver never delivers a frame
+    if (!capture.receiving || capture.count == 0 || (uint64_t)esp_timer_get_time() < capture.ready) {
+        return -1;
+    }
+    capture.receiving = false;
+    int count = min(capture.count, maxPulses);
+    memcpy(pulses, capture.pulses, count * sizeof(DHTPulse));
+    return count;
+}
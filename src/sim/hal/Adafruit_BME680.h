@@ -0,0 +1,52 @@
+// Module: Adafruit_BME680.h (native simulator)
+// Purpose: Fake BME680 driver; sensors are registered with simSetBME680() by I2C address. A measurement
+//          takes BME680_SIM_TPH_TIME plus the gas heater duration on the virtual clock.
+
+
+#ifndef ADAFRUIT_BME680_H
+#define ADAFRUIT_BME680_H
+
+#include <Arduino.h>
+
+#define BME680_SIM_TPH_TIME 60 // Duration of a temperature, pressure and humidity conversion (ms)
+
+#define BME680_OS_NONE 0
+#define BME680_OS_1X 1
+#define BME680_OS_2X 2
+#define BME680_OS_4X 3
+#define BME680_OS_8X 4
+#define BME680_OS_16X 5
+
+#define BME680_FILTER_SIZE_0 0
+#define BME680_FILTER_SIZE_1 1
+#define BME680_FILTER_SIZE_3 2
+#define BME680_FILTER_SIZE_7 3
+#define BME680_FILTER_SIZE_15 4
+
+// Class representing a BME680 sensor
+class Adafruit_BME680 {
+public:
+    bool begin(uint8_t address = 0x77, bool initSettings = true);
+    bool setTemperatureOversampling(uint8_t oversampling) { return true; }
+    bool setHumidityOversampling(uint8_t oversampling) { return true; }
+    bool setPressureOversampling(uint8_t oversampling) { return true; }
+    bool setIIRFilterSize(uint8_t filterSize) { return true; }
+    bool setGasHeater(uint16_t heaterTemperature, uint16_t heaterTime);
+    bool performReading();
+    uint32_t beginReading();
+    int remainingReadingMillis();
+    bool endReading();
+
+    float temperature = NAN;
+    uint32_t pressure = 0;
+    float humidity = NAN;
+    uint32_t gas_resistance = 0;
+
+private:
+    uint8_t address = 0;
+    uint16_t heaterTime = 150;
+    bool gasEnabled = true;
+    uint32_t measurementEnd = 0;  // 0: no measurement running
+};
+
+#endif // ADAFRUIT_BME680_H
@@ -0,0 +1,173 @@
+// Module: Arduino.h (native simulator)
+// Purpose: Host replacement for the Arduino core used by the native build. Time is virtual and only
+//          advances through delay() and simAdvance(), so the control code runs as fast as the host allows.
+// Definitions:
+// - Pin levels and modes, HEX/DEC, constrain().
+// Classes:
+// - Print, Stream, HardwareSerial: Output to stdout.
+// - String: Minimal Arduino String on top of std::string.
+// - EspClass: Cycle counter on host time at 240 MHz.
+// Function Prototypes:
+// - millis(), micros(), delay(), delayMicroseconds()
+// - pinMode(), digitalRead(), digitalWrite()
+// - map(), random()
+
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Virtual time
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+long random(long max);
+long random(long min, long max);
+
+// Class representing a character output
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return length > 0 ? write((const uint8_t*)buffer, min((size_t)length, sizeof(buffer) - 1)) : 0;
+    }
+    size_t print(const char* text) { return write(text); }
+    size_t print(const std::string &text) { return write((const uint8_t*)text.data(), text.size()); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    size_t println() { return write("\n"); }
+    template <typename T> size_t println(const T &value) { return print(value) + println(); }
+};
+
+// Class representing a bidirectional character stream
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+// Class representing the serial port; writes to stdout
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Class representing the chip functions used by the firmware
+class EspClass {
+public:
+    uint32_t getCycleCount();                 // Host time in 240 MHz cycles, so probes measure host cost
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+// Class representing an Arduino String
+class String {
+public:
+    String(const char* text = "") : value(text ? text : "") {}
+    String(const std::string &text) : value(text) {}
+    String(char c) : value(1, c) {}
+    String(int number, unsigned char base = DEC) : value(toText((long)number, base)) {}
+    String(unsigned int number, unsigned char base = DEC) : value(toText((unsigned long)number, base)) {}
+    String(long number, unsigned char base = DEC) : value(toText(number, base)) {}
+    String(unsigned long number, unsigned char base = DEC) : value(toText(number, base)) {}
+    String(unsigned char number, unsigned char base = DEC) : value(toText((unsigned long)number, base)) {}
+    String(double number, unsigned int decimals = 2) {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+        value = buffer;
+    }
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    int toInt() const { return atoi(value.c_str()); }
+    float toFloat() const { return atof(value.c_str()); }
+    bool equals(const String &other) const { return value == other.value; }
+    bool operator==(const String &other) const { return value == other.value; }
+    bool operator!=(const String &other) const { return value != other.value; }
+    char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+    String &operator+=(const String &other) { value += other.value; return *this; }
+    String &operator+=(const char* other) { value += other; return *this; }
+    String &operator+=(char c) { value += c; return *this; }
+    friend String operator+(const String &a, const String &b) { return String(a.value + b.value); }
+    friend String operator+(const char* a, const String &b) { return String(a + b.value); }
+    friend String operator+(const String &a, const char* b) { return String(a.value + b); }
+
+private:
+    std::string value;
+
+    static std::string toText(long number, unsigned char base) {
+        return base == DEC ? std::to_string(number) : toText((unsigned long)number, base);
+    }
+    static std::string toText(unsigned long number, unsigned char base) {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), base == HEX ? "%lx" : "%lu", number);
+        return buffer;
+    }
+};
+
+#endif // ARDUINO_H
@@ -0,0 +1,37 @@
+// Module: DallasTemperature.h (native simulator)
+// Purpose: Fake DS18B20 driver. Devices are registered with simSetDS18(); conversions take the
+//          resolution-dependent time on the virtual clock.
+
+
+#ifndef DALLAS_TEMPERATURE_H
+#define DALLAS_TEMPERATURE_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+// Class representing the DS18B20 devices on a OneWire bus
+class DallasTemperature {
+public:
+    explicit DallasTemperature(OneWire* bus) : bus(bus) {}
+
+    void begin() {}
+    uint8_t getDeviceCount();
+    bool getAddress(uint8_t* address, uint8_t index);
+    bool validAddress(const uint8_t* address);
+    bool isParasitePowerMode() { return false; }
+    void setWaitForConversion(bool wait) { waitForConversion = wait; }
+    bool setResolution(const uint8_t* address, uint8_t resolution, bool skipGlobalCalculation = false);
+    int16_t millisToWaitForConversion(uint8_t resolution);
+    bool requestTemperaturesByAddress(const uint8_t* address);
+    float getTempC(const uint8_t* address);
+
+private:
+    OneWire* bus;
+    bool waitForConversion = true;
+};
+
+#endif // DALLAS_TEMPERATURE_H
@@ -0,0 +1,24 @@
+// Module: ESP32Servo.h (native simulator)
+// Purpose: Fake servo; the written angle can be read back with simGetServoAngle().
+
+
+#ifndef ESP32SERVO_H
+#define ESP32SERVO_H
+
+#include <Arduino.h>
+
+// Class representing a hobby servo
+class Servo {
+public:
+    int attach(int pin);
+    void detach();
+    void write(int angle);
+    int read() const { return angle; }
+    bool attached() const { return pin >= 0; }
+
+private:
+    int pin = -1;
+    int angle = 0;
+};
+
+#endif // ESP32SERVO_H
@@ -0,0 +1,24 @@
+// Module: OneWire.h (native simulator)
+// Purpose: Fake OneWire bus; the devices live in the DallasTemperature fake and are found by search().
+
+
+#ifndef ONEWIRE_H
+#define ONEWIRE_H
+
+#include <Arduino.h>
+
+// Class representing a OneWire bus
+class OneWire {
+public:
+    explicit OneWire(uint8_t pin) : pin(pin) {}
+    uint8_t reset() { return 1; }
+    void reset_search() { searchIndex = 0; }
+    bool search(uint8_t* address, bool searchMode = true);
+    static uint8_t crc8(const uint8_t* data, uint8_t length);
+
+private:
+    uint8_t pin;
+    int searchIndex = 0;
+};
+
+#endif // ONEWIRE_H
@@ -0,0 +1,40 @@
+// Module: Preferences.h (native simulator)
+// Purpose: NVS key-value storage kept in memory for the lifetime of the process.
+
+
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <Arduino.h>
+
+// Class representing an NVS namespace
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    void end() {}
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t length);
+
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+    float getFloat(const char* key, float defaultValue = NAN) { return getValue(key, defaultValue); }
+    size_t putBool(const char* key, bool value) { return putBytes(key, &value, sizeof(value)); }
+    bool getBool(const char* key, bool defaultValue = false) { return getValue(key, defaultValue); }
+
+private:
+    std::string name;
+    bool readOnly = true;
+
+    template <typename T> T getValue(const char* key, T defaultValue) {
+        T value;
+        return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+    }
+};
+
+#endif // PREFERENCES_H
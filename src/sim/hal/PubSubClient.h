@@ -0,0 +1,52 @@
+// Module: PubSubClient.h (native simulator)
+// Purpose: Fake MQTT client. Always connected; publications are counted and the last one is kept
+//          so the simulator can inspect what the firmware would have sent.
+
+
+#ifndef PUBSUBCLIENT_H
+#define PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <functional>
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+// Class representing an MQTT client
+class PubSubClient {
+public:
+    PubSubClient() {}
+    explicit PubSubClient(WiFiClient &client) {}
+
+    PubSubClient &setServer(const char* host, uint16_t port) { return *this; }
+    PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE) { this->callback = callback; return *this; }
+    PubSubClient &setClient(WiFiClient &client) { return *this; }
+    PubSubClient &setKeepAlive(uint16_t keepAlive) { return *this; }
+    PubSubClient &setSocketTimeout(uint16_t timeout) { return *this; }
+    bool setBufferSize(uint16_t size) { bufferSize = size; return true; }
+    uint16_t getBufferSize() { return bufferSize; }
+
+    bool connect(const char* id) { return true; }
+    bool connect(const char* id, const char* user, const char* password) { return true; }
+    void disconnect() {}
+    bool connected() { return true; }
+    int state() { return 0; }
+    bool loop() { return true; }
+
+    bool publish(const char* topic, const char* payload, bool retained = false);
+    bool subscribe(const char* topic, uint8_t qos = 0) { return true; }
+    bool unsubscribe(const char* topic) { return true; }
+
+    // Delivers a message to the registered callback as if it had arrived from the broker
+    void inject(const char* topic, const char* payload);
+
+    unsigned long published = 0;
+    std::string lastTopic;
+    std::string lastPayload;
+
+private:
+    MQTT_CALLBACK_SIGNATURE;
+    uint16_t bufferSize = 256;
+};
+
+#endif // PUBSUBCLIENT_H
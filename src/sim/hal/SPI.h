@@ -0,0 +1,20 @@
+// Module: SPI.h (native simulator)
+// Purpose: Fake SPI bus.
+
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <Arduino.h>
+
+// Class representing an SPI bus
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    uint8_t transfer(uint8_t data) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_H
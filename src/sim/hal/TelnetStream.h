@@ -0,0 +1,21 @@
+// Module: TelnetStream.h (native simulator)
+// Purpose: Fake telnet stream; output is discarded, the log already goes to Serial.
+
+
+#ifndef TELNETSTREAM_H
+#define TELNETSTREAM_H
+
+#include <Arduino.h>
+
+// Class representing the telnet stream
+class TelnetStreamClass : public Stream {
+public:
+    void begin(int port = 23) {}
+    size_t write(uint8_t c) override { return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return size; }
+    using Print::write;
+};
+
+extern TelnetStreamClass TelnetStream;
+
+#endif // TELNETSTREAM_H
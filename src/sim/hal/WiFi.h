@@ -0,0 +1,29 @@
+// Module: WiFi.h (native simulator)
+// Purpose: Fake WiFi station that reports a permanent connection.
+
+
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+#define WIFI_STA 1
+
+// Class representing the WiFi station
+class WiFiClass {
+public:
+    void mode(int mode) {}
+    void begin(const char* ssid, const char* password) {}
+    void setAutoReconnect(bool enable) {}
+    int status() { return WL_CONNECTED; }
+    bool isConnected() { return true; }
+    int32_t RSSI() { return -60; }
+    String localIP() { return String("127.0.0.1"); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // WIFI_H
@@ -0,0 +1,22 @@
+// Module: WiFiClient.h (native simulator)
+// Purpose: Fake TCP client; connections always fail, nothing is sent.
+
+
+#ifndef WIFICLIENT_H
+#define WIFICLIENT_H
+
+#include <Arduino.h>
+
+// Class representing a TCP client
+class WiFiClient : public Stream {
+public:
+    int connect(const char* host, uint16_t port) { return 0; }
+    int connect(const char* host, uint16_t port, int32_t timeout) { return 0; }
+    uint8_t connected() { return 0; }
+    void stop() {}
+    void setTimeout(uint32_t timeout) {}
+    size_t write(uint8_t c) override { return 1; }
+    using Print::write;
+};
+
+#endif // WIFICLIENT_H
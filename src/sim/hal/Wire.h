@@ -0,0 +1,23 @@
+// Module: Wire.h (native simulator)
+// Purpose: Fake I2C bus; addresses of BME680 fakes registered with simSetBME680() acknowledge.
+
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+// Class representing an I2C bus
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+    void beginTransmission(uint8_t address) { this->address = address; }
+    uint8_t endTransmission(bool sendStop = true); // 0: acknowledged, 2: address not acknowledged
+
+private:
+    uint8_t address = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
@@ -0,0 +1,22 @@
+// Module: esp_heap_caps.h (native simulator)
+// Purpose: Heap statistics for the native build. The host heap is not observed; the fake reports a fixed,
+//          unfragmented internal heap and no PSRAM.
+
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define SIM_HEAP_SIZE 200000
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_total_size(uint32_t caps);
+
+#endif // ESP_HEAP_CAPS_H
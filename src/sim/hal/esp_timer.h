@@ -0,0 +1,39 @@
+// Module: esp_timer.h (native simulator)
+// Purpose: High resolution timers on the virtual clock. Callbacks fire from simAdvance() in time order.
+
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef struct esp_timer* esp_timer_handle_t;
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+bool esp_timer_is_active(esp_timer_handle_t timer);
+int64_t esp_timer_get_time();
+
+#endif // ESP_TIMER_H
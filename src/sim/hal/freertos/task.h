@@ -0,0 +1,22 @@
+// Module: freertos/task.h (native simulator)
+// Purpose: Task functions for the native build. Tasks are not started; the simulator runs the
+//          schedulers itself. Delays advance the virtual clock.
+
+
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+void vTaskDelete(TaskHandle_t task);
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetHandle(const char* name);
+
+#endif // FREERTOS_TASK_H
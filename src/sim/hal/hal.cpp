@@ -0,0 +1,567 @@
+// Module: hal.cpp (native simulator)
+// Purpose: Implements the hardware fakes of the native build on a virtual clock.
+// Functions:
+// - millis(), micros(), delay(): Virtual time; delay() advances the clock.
+// - simAdvance(): Advances the clock in timer order so callbacks see their own expiry time.
+// - pinMode(), digitalRead(), digitalWrite(), simSetPin(), simGetPin(): Pin levels.
+// - esp_timer_*(): One-shot and periodic timers.
+// - heap_caps_*(): A fixed, unfragmented internal heap and no PSRAM.
+// - EspClass::getCycleCount(): Host steady clock scaled to 240 MHz.
+// - DallasTemperature, Adafruit_BME680, Servo, PubSubClient, Preferences: Fake drivers.
+
+
+#include "sim_hal.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <DallasTemperature.h>
+#include <Adafruit_BME680.h>
+#include <ESP32Servo.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <TelnetStream.h>
+#include <Preferences.h>
+#include <map>
+#include <vector>
+#include <chrono>
+
+HardwareSerial Serial;
+EspClass ESP;
+TelnetStreamClass TelnetStream;
+TwoWire Wire;
+SPIClass SPI;
+WiFiClass WiFi;
+
+// Virtual clock in microseconds
+static uint64_t now = 0;
+
+// Pin levels; inputs are set by the simulator, outputs by the firmware
+static uint8_t pinLevels[SIM_MAX_PINS];
+static int servoAngles[SIM_MAX_PINS];
+
+// Structure of a fake esp_timer
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t expiry;
+    uint64_t period;   // 0: one-shot
+    bool active;
+    bool used;
+};
+static esp_timer timers[SIM_MAX_TIMERS];
+
+// Structure of a fake DS18B20
+struct SimDS18 {
+    DeviceAddress address;
+    float temperature;
+    uint8_t resolution;
+    uint64_t conversionDone;  // Time the last requested conversion finishes
+    float converting;         // Value of the conversion in progress
+    float converted;          // Value of the last finished conversion
+};
+static SimDS18 ds18Devices[SIM_MAX_DS18];
+static int ds18Count = 0;
+
+// Structure of the values of a fake DHT or BME680
+struct SimClimate {
+    bool present;
+    float temperature;
+    float humidity;
+    float pressure;
+    float gasResistance;
+};
+static SimClimate dhtValues[SIM_MAX_PINS];
+static SimClimate bme680Values[128];
+
+static std::map<std::string, std::vector<uint8_t>> nvs;
+
+unsigned long millis() {
+    return (unsigned long)(now / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)now;
+}
+
+uint32_t EspClass::getCycleCount() {
+    auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() * 6 / 25);
+}
+
+void delay(uint32_t ms) {
+    simAdvance(ms);
+}
+
+void delayMicroseconds(uint32_t us) {
+    now += us;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    simAdvance(ticks);
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    *previousWakeTime += increment;
+    int32_t remaining = (int32_t)(*previousWakeTime - xTaskGetTickCount());
+    if (remaining > 0) {
+        simAdvance(remaining);
+    }
+}
+
+void vTaskDelete(TaskHandle_t task) {}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 0;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+    return nullptr;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : SIM_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+// Function to advance the virtual clock, firing due timers in expiry order
+void simAdvance(uint32_t ms) {
+    uint64_t target = now + (uint64_t)ms * 1000;
+    for (;;) {
+        esp_timer* next = nullptr;
+        for (esp_timer &timer : timers) {
+            if (timer.used && timer.active && timer.expiry <= target && (next == nullptr || timer.expiry < next->expiry)) {
+                next = &timer;
+            }
+        }
+        if (next == nullptr) {
+            break;
+        }
+        now = max(now, next->expiry);
+        if (next->period > 0) {
+            next->expiry += next->period;
+        } else {
+            next->active = false;
+        }
+        next->callback(next->arg);
+    }
+    now = target;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + rand() % (max - min) : min;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+int digitalRead(uint8_t pin) {
+    return pin < SIM_MAX_PINS ? pinLevels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < SIM_MAX_PINS) {
+        pinLevels[pin] = value ? HIGH : LOW;
+    }
+}
+
+void simSetPin(uint8_t pin, int level) {
+    digitalWrite(pin, level);
+}
+
+int simGetPin(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    for (esp_timer &timer : timers) {
+        if (!timer.used) {
+            timer = {args->callback, args->arg, 0, 0, false, true};
+            *handle = &timer;
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    if (timer == nullptr || timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expiry = now + timeoutUs;
+    timer->period = 0;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs) {
+    if (timer == nullptr || timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expiry = now + periodUs;
+    timer->period = periodUs;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (timer == nullptr || !timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (timer == nullptr) {
+        return ESP_FAIL;
+    }
+    timer->used = false;
+    timer->active = false;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    return timer != nullptr && timer->active;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)now;
+}
+
+// DHT
+void simSetDHT(uint8_t pin, float temperature, float humidity) {
+    if (pin < SIM_MAX_PINS) {
+        dhtValues[pin] = {true, temperature, humidity, NAN, NAN};
+    }
+}
+
+bool simGetDHT(uint8_t pin, float &temperature, float &humidity) {
+    if (pin >= SIM_MAX_PINS || !dhtValues[pin].present) {
+        return false;
+    }
+    temperature = dhtValues[pin].temperature;
+    humidity = dhtValues[pin].humidity;
+    return true;
+}
+
+// DS18B20
+static SimDS18* findDS18(const uint8_t* address) {
+    for (int i = 0; i < ds18Count; i++) {
+        if (memcmp(ds18Devices[i].address, address, sizeof(DeviceAddress)) == 0) {
+            return &ds18Devices[i];
+        }
+    }
+    return nullptr;
+}
+
+void simSetDS18(const char* id, float temperature) {
+    DeviceAddress address;
+    for (int j = 0; j < 8; j++) {
+        unsigned int value;
+        sscanf(&id[j * 2], "%02X", &value);
+        address[j] = (uint8_t)value;
+    }
+    SimDS18* device = findDS18(address);
+    if (device == nullptr) {
+        if (ds18Count >= SIM_MAX_DS18) {
+            return;
+        }
+        device = &ds18Devices[ds18Count++];
+        memcpy(device->address, address, sizeof(DeviceAddress));
+        device->resolution = 12;
+        device->conversionDone = 0;
+        device->converting = 85.0f; // Power-on reset value
+        device->converted = 85.0f;
+    }
+    device->temperature = temperature;
+}
+
+uint8_t DallasTemperature::getDeviceCount() {
+    return ds18Count;
+}
+
+bool DallasTemperature::getAddress(uint8_t* address, uint8_t index) {
+    if (index >= ds18Count) {
+        return false;
+    }
+    memcpy(address, ds18Devices[index].address, sizeof(DeviceAddress));
+    return true;
+}
+
+bool DallasTemperature::validAddress(const uint8_t* address) {
+    return address[0] != 0;
+}
+
+bool DallasTemperature::setResolution(const uint8_t* address, uint8_t resolution, bool skipGlobalCalculation) {
+    SimDS18* device = findDS18(address);
+    if (device == nullptr) {
+        return false;
+    }
+    device->resolution = constrain(resolution, 9, 12);
+    return true;
+}
+
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t resolution) {
+    switch (resolution) {
+        case 9: return 94;
+        case 10: return 188;
+        case 11: return 375;
+        default: return 750;
+    }
+}
+
+bool DallasTemperature::requestTemperaturesByAddress(const uint8_t* address) {
+    SimDS18* device = findDS18(address);
+    if (device == nullptr) {
+        return false;
+    }
+    if (now >= device->conversionDone) {
+        device->converted = device->converting;
+    }
+    float step = 0.5f / (1 << (device->resolution - 9));
+    device->converting = roundf(device->temperature / step) * step;
+    device->conversionDone = now + (uint64_t)millisToWaitForConversion(device->resolution) * 1000;
+    if (waitForConversion) {
+        simAdvance(millisToWaitForConversion(device->resolution));
+    }
+    return true;
+}
+
+float DallasTemperature::getTempC(const uint8_t* address) {
+    SimDS18* device = findDS18(address);
+    if (device == nullptr) {
+        return DEVICE_DISCONNECTED_C;
+    }
+    // Reading the scratchpad before the conversion finished returns the previous value
+    return now >= device->conversionDone ? device->converting : device->converted;
+}
+
+// OneWire
+bool OneWire::search(uint8_t* address, bool searchMode) {
+    if (searchIndex >= ds18Count) {
+        return false;
+    }
+    memcpy(address, ds18Devices[searchIndex++].address, sizeof(DeviceAddress));
+    return true;
+}
+
+uint8_t OneWire::crc8(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+    while (length--) {
+        uint8_t byte = *data++;
+        for (int i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+// I2C
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    return address < 128 && bme680Values[address].present ? 0 : 2;
+}
+
+// BME680
+void simSetBME680(uint8_t address, float temperature, float humidity, float pressure, float gasResistance) {
+    if (address < 128) {
+        bme680Values[address] = {true, temperature, humidity, pressure, gasResistance};
+    }
+}
+
+bool Adafruit_BME680::begin(uint8_t address, bool initSettings) {
+    this->address = address;
+    return address < 128 && bme680Values[address].present;
+}
+
+bool Adafruit_BME680::setGasHeater(uint16_t heaterTemperature, uint16_t heaterTime) {
+    gasEnabled = heaterTemperature != 0 && heaterTime != 0;
+    this->heaterTime = heaterTime;
+    return true;
+}
+
+bool Adafruit_BME680::performReading() {
+    return endReading();
+}
+
+uint32_t Adafruit_BME680::beginReading() {
+    if (measurementEnd != 0) {
+        return measurementEnd;
+    }
+    if (address >= 128 || !bme680Values[address].present) {
+        return 0;
+    }
+    measurementEnd = millis() + BME680_SIM_TPH_TIME + (gasEnabled ? heaterTime : 0);
+    return measurementEnd;
+}
+
+int Adafruit_BME680::remainingReadingMillis() {
+    if (measurementEnd == 0) {
+        return -1;
+    }
+    long remaining = (long)(measurementEnd - millis());
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+bool Adafruit_BME680::endReading() {
+    if (beginReading() == 0) {
+        return false;
+    }
+    int remaining = remainingReadingMillis();
+    if (remaining > 0) {
+        delay(remaining);
+    }
+    measurementEnd = 0;
+
+    const SimClimate &values = bme680Values[address];
+    temperature = values.temperature;
+    humidity = values.humidity;
+    pressure = (uint32_t)lroundf(values.pressure);
+    gas_resistance = gasEnabled ? (uint32_t)lroundf(values.gasResistance) : 0;
+    return true;
+}
+
+// Servo
+int Servo::attach(int pin) {
+    this->pin = pin;
+    if (pin >= 0 && pin < SIM_MAX_PINS) {
+        servoAngles[pin] = angle;
+    }
+    return pin;
+}
+
+void Servo::detach() {
+    if (pin >= 0 && pin < SIM_MAX_PINS) {
+        servoAngles[pin] = -1;
+    }
+    pin = -1;
+}
+
+void Servo::write(int angle) {
+    this->angle = constrain(angle, 0, 180);
+    if (pin >= 0 && pin < SIM_MAX_PINS) {
+        servoAngles[pin] = this->angle;
+    }
+}
+
+int simGetServoAngle(uint8_t pin) {
+    return pin < SIM_MAX_PINS ? servoAngles[pin] : -1;
+}
+
+// MQTT
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    published++;
+    lastTopic = topic;
+    lastPayload = payload;
+    return true;
+}
+
+void PubSubClient::inject(const char* topic, const char* payload) {
+    if (callback) {
+        std::string topicCopy = topic;
+        callback(&topicCopy[0], (uint8_t*)payload, strlen(payload));
+    }
+}
+
+// NVS
+bool Preferences::begin(const char* name, bool readOnly) {
+    this->name = name;
+    this->readOnly = readOnly;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (readOnly) {
+        return false;
+    }
+    std::string prefix = name + "/";
+    for (auto it = nvs.begin(); it != nvs.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? nvs.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    return !readOnly && nvs.erase(name + "/" + key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return nvs.count(name + "/" + key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (readOnly) {
+        return 0;
+    }
+    const uint8_t* bytes = (const uint8_t*)value;
+    nvs[name + "/" + key].assign(bytes, bytes + length);
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    auto it = nvs.find(name + "/" + key);
+    return it == nvs.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+    auto it = nvs.find(name + "/" + key);
+    if (it == nvs.end() || it->second.size() > length) {
+        return 0;
+    }
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+// Function to clear all fake hardware state
+void simReset() {
+    now = 0;
+    memset(pinLevels, 0, sizeof(pinLevels));
+    for (int &angle : servoAngles) {
+        angle = -1;
+    }
+    for (esp_timer &timer : timers) {
+        timer.used = false;
+        timer.active = false;
+    }
+    ds18Count = 0;
+    memset(dhtValues, 0, sizeof(dhtValues));
+    memset(bme680Values, 0, sizeof(bme680Values));
+    nvs.clear();
+}
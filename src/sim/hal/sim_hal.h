@@ -0,0 +1,37 @@
+// Module: sim_hal.h
+// Purpose: Control interface of the native hardware fakes, used by the simulator to drive time,
+//          inputs and sensors and to observe the outputs of the firmware.
+// Function Prototypes:
+// - simAdvance(): Advances the virtual clock and fires due esp_timer callbacks.
+// - simSetPin(), simGetPin(): Input and output pin levels.
+// - simSetDHT(), simSetDS18(), simSetBME680(): Values returned by the sensor fakes.
+// - simGetDHT(): Values a fake DHT sensor transmits, false if no sensor is on the pin.
+// - simEncodeDHT22(): Synthesizes the pulse train a DHT22 sends for the given values.
+// - simGetServoAngle(): Last angle written to the servo on a pin.
+// - simReset(): Clears all fake hardware state.
+
+
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <Arduino.h>
+
+#define SIM_MAX_PINS 64
+#define SIM_MAX_DS18 16
+#define SIM_MAX_TIMERS 16
+
+struct DHTPulse;
+
+// Function prototypes
+void simAdvance(uint32_t ms);
+void simSetPin(uint8_t pin, int level);
+int simGetPin(uint8_t pin);
+void simSetDHT(uint8_t pin, float temperature, float humidity);
+bool simGetDHT(uint8_t pin, float &temperature, float &humidity);
+int simEncodeDHT22(float temperature, float humidity, DHTPulse* pulses, int maxPulses);
+void simSetDS18(const char* id, float temperature);
+void simSetBME680(uint8_t address, float temperature, float humidity, float pressure, float gasResistance);
+int simGetServoAngle(uint8_t pin);
+void simReset();
+
+#endif // SIM_HAL_H
@@ -0,0 +1,31 @@
+// Module: network_stubs.cpp
+// Purpose: Stands in for the network side of the firmware (message_module.cpp), which is not part of
+//          the native build. Messages go to the log instead of MQTT.
+// Functions:
+// - sendMessage(): Writes the message to the log.
+// - publishMessage(): Writes topic and payload to the log.
+// - getOutboundTopic(): Returns a placeholder topic.
+
+
+#include "message_module.h"
+#include "topic_module.h"
+#include "log_module.h"
+
+WiFiClient wifiClient;
+PubSubClient mqttClient(wifiClient);
+
+// Function to send a message; the simulator has no broker, so everything is logged
+void sendMessage(const String &message, const String &path, int priority) {
+    logText(priority <= 2 ? LEVEL_INFO : LEVEL_DEBUG, LOG_MODULE_MQTT, message.c_str());
+}
+
+// Function to publish a message; logged like sendMessage()
+bool publishMessage(const char* topic, const char* payload, bool retained) {
+    LOG_DEBUG(LOG_MODULE_MQTT, "%s: %s", topic, payload);
+    return true;
+}
+
+// Function to return an outbound topic; the simulator has no topic registry
+const char* getOutboundTopic(OutboundTopic topic) {
+    return "sim";
+}
@@ -0,0 +1,132 @@
+// Module: plant.cpp
+// Purpose: Thermal plant model of the native simulator.
+// Functions:
+// - setupPlant(): Sets the zone parameters, binds the sensors of the default routing and starts at ambient.
+// - updatePlant(): Runs the heater state machine (toggle pulses), distributes the heat by valve opening,
+//   integrates the zone temperatures and refreshes the fake sensors.
+// - getAmbientTemperature(): Daily ambient cycle with the minimum at 05:00.
+
+
+#include "plant.h"
+#include "hal/sim_hal.h"
+#include "gpio_module.h"
+#include "servo_control_module.h"
+#include "dht_module.h"
+#include "ds18_module.h"
+
+extern ServoControl servos[MAX_SERVOS];
+
+PlantState plant;
+
+// Function to get the ambient temperature of the daily cycle
+float getAmbientTemperature(unsigned long ms) {
+    float hours = fmodf(ms / 3600000.0f, 24.0f);
+    return PLANT_AMBIENT_MEAN - PLANT_AMBIENT_SWING * cosf((hours - 5.0f) * 2.0f * (float)M_PI / 24.0f);
+}
+
+// Function to get the opening (0-1) of a zone's valve from the angle written to its servo
+static float getValveOpening(int zoneIndex) {
+    int servoIndex = zones[zoneIndex].servoValve - 1;
+    if (servoIndex < 0 || servoIndex >= MAX_SERVOS) {
+        return 0;
+    }
+    int angle = simGetServoAngle(servos[servoIndex].pin);
+    return angle < 0 ? 0 : constrain(angle / (float)SERVO_MAX_ANGLE, 0.0f, 1.0f);
+}
+
+// Function to write the plant state to the fake sensors
+static void updateSensors() {
+    for (int i = 0; i < plant.sensorCount; i++) {
+        const PlantSensor &sensor = plant.sensors[i];
+        float temperature = sensor.zone < 0 ? plant.supplyTemperature : plant.zones[sensor.zone].temperature;
+        float humidity = sensor.zone < 0 ? 20.0f : plant.zones[sensor.zone].humidity;
+        switch (sensor.type) {
+            case PLANT_SENSOR_DHT:
+                simSetDHT(sensor.pin, temperature, humidity);
+                break;
+            case PLANT_SENSOR_DS18:
+                simSetDS18(sensor.id, temperature);
+                break;
+            case PLANT_SENSOR_BME680:
+                simSetBME680(sensor.pin, temperature, humidity, 101325.0f, 50000.0f);
+                break;
+        }
+    }
+}
+
+// Function to set up the plant
+void setupPlant() {
+    memset(&plant, 0, sizeof(plant));
+    plant.ambient = getAmbientTemperature(millis());
+    plant.supplyTemperature = plant.ambient;
+
+    // Zones with sensors in the default routing: Cabin, Bath, Plicht
+    const float capacity[3] = {400000.0f, 120000.0f, 200000.0f};
+    const float loss[3] = {60.0f, 20.0f, 45.0f};
+    for (int i = 0; i < 3; i++) {
+        plant.zones[i] = {true, plant.ambient, 60.0f, capacity[i], loss[i], 0};
+    }
+
+    // Sensors matching the default routing (see routing_module.cpp)
+    const PlantSensor sensors[] = {
+        {PLANT_SENSOR_BME680, 0x77, nullptr, 0},    // Slot 16
+        {PLANT_SENSOR_DHT, DHTPIN_5, nullptr, 1},   // Slot 4
+        {PLANT_SENSOR_DS18, 0, SENSOR6_ID, 2},      // Slot 5
+        {PLANT_SENSOR_DS18, 0, SENSOR9_ID, -1}      // Slot 8, valve temperature of zone 0
+    };
+    plant.sensorCount = sizeof(sensors) / sizeof(sensors[0]);
+    memcpy(plant.sensors, sensors, sizeof(sensors));
+
+    simSetPin(HEATER_STATUS_PIN, LOW);
+    updateSensors();
+}
+
+// Function to advance the plant by a time step
+void updatePlant(uint32_t ms) {
+    float dt = ms / 1000.0f;
+    unsigned long now = millis();
+
+    // Heater control panel: a toggle pulse flips the heater after the start delay
+    bool toggleLevel = simGetPin(HEATER_TOGGLE_PIN) == HIGH;
+    if (toggleLevel && !plant.toggleLevel && plant.switchAt == 0) {
+        plant.switchAt = now + PLANT_HEATER_START_DELAY;
+    }
+    plant.toggleLevel = toggleLevel;
+    if (plant.switchAt != 0 && (long)(now - plant.switchAt) >= 0) {
+        plant.heaterOn = !plant.heaterOn;
+        plant.switchAt = 0;
+        simSetPin(HEATER_STATUS_PIN, plant.heaterOn ? HIGH : LOW);
+    }
+
+    // Heater output follows its state with a first-order lag
+    float targetOutput = plant.heaterOn ? PLANT_HEATER_POWER : 0;
+    plant.heaterOutput += (targetOutput - plant.heaterOutput) * min(1.0f, dt / PLANT_HEATER_TIME_CONSTANT);
+    plant.ambient = getAmbientTemperature(now);
+    plant.supplyTemperature = plant.ambient + plant.heaterOutput * PLANT_SUPPLY_RISE;
+
+    // Distribute the airflow by valve opening
+    float weights[NUM_ZONES];
+    float totalWeight = 0;
+    for (int i = 0; i < NUM_ZONES; i++) {
+        weights[i] = plant.zones[i].active ? PLANT_VALVE_LEAKAGE + (1 - PLANT_VALVE_LEAKAGE) * getValveOpening(i) : 0;
+        totalWeight += weights[i];
+    }
+
+    for (int i = 0; i < NUM_ZONES; i++) {
+        PlantZone &zone = plant.zones[i];
+        if (!zone.active) {
+            continue;
+        }
+        // Closing valves throttles the airflow; heat that cannot leave the heater is lost
+        zone.heatInput = plant.heaterOutput * weights[i] / max(totalWeight, 1.0f);
+        zone.temperature += (zone.heatInput - zone.loss * (zone.temperature - plant.ambient)) * dt / zone.capacity;
+        // Warm air holds more water: relative humidity drops by about 4 % per K above ambient
+        zone.humidity = constrain(75.0f - 4.0f * (zone.temperature - plant.ambient), 20.0f, 95.0f);
+    }
+
+    // Sensors are read every 2 s at most, so they are refreshed once per second
+    if (now - plant.lastSensorUpdate >= PLANT_SENSOR_INTERVAL) {
+        plant.lastSensorUpdate = now;
+        updateSensors();
+    }
+}
@@ -0,0 +1,80 @@
+// Module: plant.h
+// Purpose: Declares the thermal plant model of the native simulator: a forced-air heater feeding
+//          several zones through the servo valves, with heat loss to a daily ambient cycle.
+// Definitions:
+// - PLANT_*: Default plant parameters.
+// Structures:
+// - PlantZone: Thermal state and parameters of a zone.
+// - PlantSensor: Binding of a fake sensor to a zone (or the supply air).
+// - PlantState: Heater, ambient and zone state.
+// External Variables:
+// - plant: The simulated plant.
+// Function Prototypes:
+// - setupPlant(): Initializes the plant and registers its sensors with the hardware fakes.
+// - updatePlant(): Integrates the plant over a time step and updates the sensors and the heater status pin.
+// - getAmbientTemperature(): Ambient temperature at a given time.
+
+
+#ifndef PLANT_H
+#define PLANT_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define PLANT_HEATER_POWER 2000.0f        // Heat output of the air heater at full power (W)
+#define PLANT_HEATER_TIME_CONSTANT 90.0f  // Warm-up and cool-down time constant of the heater (s)
+#define PLANT_HEATER_START_DELAY 3000     // Time from toggle pulse to status change (ms)
+#define PLANT_SUPPLY_RISE 0.02f           // Supply air temperature rise per W of heater output (K/W)
+#define PLANT_AMBIENT_MEAN 8.0f           // Mean ambient temperature (°C)
+#define PLANT_AMBIENT_SWING 4.0f          // Amplitude of the daily ambient cycle (K)
+#define PLANT_VALVE_LEAKAGE 0.05f         // Share of airflow passing a closed valve
+#define PLANT_SENSOR_INTERVAL 1000        // Refresh interval of the fake sensors (ms)
+#define PLANT_MAX_SENSORS 8
+
+// Structure of a simulated zone
+struct PlantZone {
+    bool active;            // Zone is part of the plant
+    float temperature;      // Air temperature (°C)
+    float humidity;         // Relative humidity (%)
+    float capacity;         // Heat capacity (J/K)
+    float loss;             // Heat loss coefficient to ambient (W/K)
+    float heatInput;        // Heat delivered during the last step (W)
+};
+
+// Sensor types that can be bound to a zone
+enum PlantSensorType {
+    PLANT_SENSOR_DHT,
+    PLANT_SENSOR_DS18,
+    PLANT_SENSOR_BME680
+};
+
+// Structure binding a fake sensor to a zone
+struct PlantSensor {
+    PlantSensorType type;
+    uint8_t pin;            // DHT pin or BME680 I2C address
+    const char* id;         // DS18B20 ID
+    int zone;               // Zone index, -1 for the supply air
+};
+
+// Structure of the complete plant state
+struct PlantState {
+    PlantZone zones[NUM_ZONES];
+    PlantSensor sensors[PLANT_MAX_SENSORS];
+    int sensorCount;
+    float ambient;              // Current ambient temperature (°C)
+    float heaterOutput;         // Current heat output (W)
+    float supplyTemperature;    // Temperature of the supply air (°C)
+    bool heaterOn;              // Heater state as reported on the status pin
+    bool toggleLevel;           // Last seen level of the toggle pin
+    unsigned long switchAt;     // Time a pending state change becomes effective, 0 if none
+    unsigned long lastSensorUpdate; // Time the fake sensors were last refreshed
+};
+
+extern PlantState plant;
+
+// Function prototypes
+void setupPlant();
+void updatePlant(uint32_t ms);
+float getAmbientTemperature(unsigned long ms);
+
+#endif // PLANT_H
@@ -0,0 +1,503 @@
+// Module: sim_main.cpp
+// Purpose: Entry point of the native simulator. Runs the control task of the firmware (same tasks and
+//          periods as main.cpp) against the thermal plant on a virtual clock, much faster than real time.
+// Usage: program [--days N] [--csv SECONDS] [--proportional] [--verbose] [--bench ITERATIONS] [--bench-dht FRAMES] [--bench-pid TICKS] [--bench-metrics PROBES] [--check-ds18]
+// Functions:
+// - main(): Parses the options, sets up the firmware modules and the plant, runs the simulation or the benchmark.
+// - runSimulation(): Replays days of operation with a comfort/setback schedule and prints a summary.
+// - runBenchmark(): Measures the throughput of one control pass over all configured zones.
+// - runDHTBenchmark(): Measures the DHT22 decoder on synthesized frames and checks the decoded values.
+// - runPIDBenchmark(): Measures one PID tick for NUM_ZONES controllers and the full valve update of the simulated zones.
+// - runMetricsBenchmark(): Measures a stage probe (begin and end around an empty stage).
+// - runDS18Check(): Checks the conversion wait per resolution and the reported value age of the DS18B20 acquisition.
+
+
+#include <Arduino.h>
+#include "hal/sim_hal.h"
+#include "plant.h"
+#include "dht_module.h"
+#include "ds18_module.h"
+#include "i2c.h"
+#include "gpio_module.h"
+#include "temperature_module.h"
+#include "heater_automation_module.h"
+#include "servo_control_module.h"
+#include "routing_module.h"
+#include "tasks_module.h"
+#include "log_module.h"
+#include "inventory_module.h"
+#include "dht_decoder.h"
+#include "pid_module.h"
+#include "metrics_module.h"
+#include "zone_descriptors.h"
+#include <chrono>
+
+#define SIM_STEP 10                 // Simulation step (in ms)
+#define SIM_COMFORT_START 6         // Start of the comfort period (hour)
+#define SIM_COMFORT_END 23          // End of the comfort period (hour)
+#define SIM_SETBACK 4.0f            // Target reduction outside the comfort period (K)
+
+// Comfort targets of the simulated zones
+static const float comfortTargets[] = {20.0f, 22.0f, 18.0f};
+static const int simulatedZones = sizeof(comfortTargets) / sizeof(comfortTargets[0]);
+
+// Latest raw sensor values, indexed by sensor slot (as in main.cpp)
+static float sensorTemps[NUM_SENSORS];
+static float sensorHums[NUM_SENSORS];
+static float sensorPressures[NUM_SENSORS];
+static float sensorVocs[NUM_SENSORS];
+
+// Wall-clock time spent in the control functions
+static std::chrono::nanoseconds controlTime(0);
+static unsigned long controlRuns = 0;
+
+// Task: advance the non-blocking DS18B20 acquisition
+static void ds18Task() {
+    updateDS18();
+}
+
+// Task: advance the non-blocking BME680 acquisition
+static void bme680Task() {
+    updateBME680();
+}
+
+// Task: advance the non-blocking DHT acquisition
+static void dhtTask() {
+    updateDHT();
+}
+
+// Task: read sensor data and assign it to the zones
+static void sensorTask() {
+    readDHT(sensorTemps[0], sensorHums[0], sensorTemps[1], sensorHums[1], sensorTemps[2], sensorHums[2], sensorTemps[3], sensorHums[3], sensorTemps[4], sensorHums[4]);
+    readDS18(sensorTemps);
+    readBME680(sensorTemps, sensorHums, sensorPressures, sensorVocs);
+    readHeaterStatus();
+    assignSensorValues(sensorTemps, sensorHums, sensorPressures, sensorVocs);
+}
+
+// Task: determine the main temperature and control the heater
+static void heaterTask() {
+    auto start = std::chrono::steady_clock::now();
+    determineMainTemperature();
+    controlHeaterBasedOnZones();
+    controlTime += std::chrono::steady_clock::now() - start;
+    controlRuns++;
+}
+
+// Task: verify heater toggle pulses
+static void heaterToggleTask() {
+    processHeaterToggle();
+}
+
+// Task: control the servo valves
+static void servoTask() {
+    auto start = std::chrono::steady_clock::now();
+    controlServoValvesBasedOnZones();
+    controlTime += std::chrono::steady_clock::now() - start;
+}
+
+// Function to set the targets of the simulated zones for the hour of the day
+static void updateSchedule(unsigned long ms, int &lastPeriod) {
+    int hour = (ms / 3600000UL) % 24;
+    int period = hour >= SIM_COMFORT_START && hour < SIM_COMFORT_END ? 1 : 0;
+    if (period == lastPeriod) {
+        return;
+    }
+    lastPeriod = period;
+    for (int i = 0; i < simulatedZones; i++) {
+        sendCommand(CMD_SET_TARGET, i, comfortTargets[i] - (period ? 0 : SIM_SETBACK));
+    }
+}
+
+// Function to replay the given number of days and print a summary
+static void runSimulation(float days, unsigned long csvInterval, bool verbose) {
+    const unsigned long duration = (unsigned long)(days * 86400000.0f);
+    int lastPeriod = -1;
+    unsigned long nextCsv = 0;
+    unsigned long heaterOnTime = 0;
+    unsigned long heaterStarts = 0;
+    bool heaterWasOn = false;
+    double errorSum[NUM_ZONES] = {0};
+    float minTemperature[NUM_ZONES];
+    float maxTemperature[NUM_ZONES];
+    unsigned long errorSamples = 0;
+
+    for (int i = 0; i < simulatedZones; i++) {
+        minTemperature[i] = INFINITY;
+        maxTemperature[i] = -INFINITY;
+    }
+
+    if (csvInterval > 0) {
+        Serial.print("time_s,ambient,supply,heater");
+        for (int i = 0; i < simulatedZones; i++) {
+            Serial.printf(",%s_temp,%s_target,%s_valve", zones[i].name, zones[i].name, zones[i].name);
+        }
+        Serial.println();
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    controlScheduler.start();
+
+    for (unsigned long t = 0; t < duration; t += SIM_STEP) {
+        updateSchedule(millis(), lastPeriod);
+        simAdvance(SIM_STEP);
+        updatePlant(SIM_STEP);
+        controlScheduler.run();
+        if (verbose) {
+            flushLog();
+        }
+
+        // Statistics, sampled once per second after the first hour
+        if (millis() % 1000 == 0) {
+            if (plant.heaterOn) {
+                heaterOnTime++;
+            }
+            if (plant.heaterOn && !heaterWasOn) {
+                heaterStarts++;
+            }
+            heaterWasOn = plant.heaterOn;
+            if (millis() >= 3600000UL) {
+                for (int i = 0; i < simulatedZones; i++) {
+                    float temperature = plant.zones[i].temperature;
+                    errorSum[i] += fabsf(temperature - getZoneTarget(i));
+                    minTemperature[i] = min(minTemperature[i], temperature);
+                    maxTemperature[i] = max(maxTemperature[i], temperature);
+                }
+                errorSamples++;
+            }
+        }
+
+        if (csvInterval > 0 && millis() >= nextCsv) {
+            nextCsv += csvInterval * 1000;
+            Serial.printf("%lu,%.2f,%.2f,%d", millis() / 1000, plant.ambient, plant.supplyTemperature, plant.heaterOn ? 1 : 0);
+            for (int i = 0; i < simulatedZones; i++) {
+                Serial.printf(",%.2f,%.1f,%d", plant.zones[i].temperature, getZoneTarget(i), getServoPosition(i, true));
+            }
+            Serial.println();
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    flushLog();
+
+    Serial.printf("\nSimulated %.2f days in %.2f s (%.0fx real time)\n", days, wallSeconds, duration / 1000.0 / wallSeconds);
+    Serial.printf("Heater on %.1f%% of the time, %lu starts, fault: %s\n",
+                  100.0 * heaterOnTime / (duration / 1000), heaterStarts, heaterFault ? "yes" : "no");
+    for (int i = 0; i < simulatedZones && errorSamples > 0; i++) {
+        Serial.printf("Zone %-8s mean |error| %.2f K, min %.2f, max %.2f\n", zones[i].name,
+                      errorSum[i] / errorSamples, minTemperature[i], maxTemperature[i]);
+    }
+    Serial.printf("Control iterations: %lu, %.0f ns each\n", controlRuns,
+                  controlRuns ? (double)controlTime.count() / controlRuns : 0.0);
+}
+
+// Function to measure the control pass (main temperature, heater decision, on/off valves) for all configured
+// zones; the temperatures are drawn before the timing so only the control functions are measured
+static void runBenchmark(unsigned long iterations) {
+    const int variants = 64;
+    float samples[variants][NUM_ZONES];
+    srand(1);
+    for (int v = 0; v < variants; v++) {
+        for (int i = 0; i < NUM_ZONES; i++) {
+            samples[v][i] = 20.0f + (rand() % 100 - 50) / 10.0f;
+        }
+    }
+    for (uint8_t i : activeZones) {
+        setZoneTarget(i, 20.0f);
+    }
+
+    // Storing the samples alone, subtracted from the passes below
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < iterations; n++) {
+        const float* sample = samples[n % variants];
+        for (uint8_t i : activeZones) {
+            setZoneTemperature(i, sample[i]);
+        }
+    }
+    double storeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Main temperature and heater decision
+    start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < iterations; n++) {
+        const float* sample = samples[n % variants];
+        for (uint8_t i : activeZones) {
+            setZoneTemperature(i, sample[i]);
+        }
+        determineMainTemperature();
+        controlHeaterBasedOnZones();
+    }
+    double decisionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Complete pass including the valve commands
+    start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < iterations; n++) {
+        const float* sample = samples[n % variants];
+        for (uint8_t i : activeZones) {
+            setZoneTemperature(i, sample[i]);
+        }
+        determineMainTemperature();
+        controlHeaterBasedOnZones();
+        controlServoValvesBasedOnZones();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double storeNs = storeSeconds * 1e9 / iterations;
+    Serial.printf("%lu control iterations for %d zones: storing the temperatures %.1f ns, then decision %.1f ns, "
+                  "full pass %.1f ns/iteration\n", iterations, ACTIVE_ZONE_COUNT, storeNs,
+                  decisionSeconds * 1e9 / iterations - storeNs, seconds * 1e9 / iterations - storeNs);
+}
+
+// Function to measure the DHT22 decoder; every frame is checked against the encoded values
+static void runDHTBenchmark(unsigned long frames) {
+    const int variants = 64;
+    DHTPulse traces[variants][DHT_MAX_PULSES];
+    int counts[variants];
+    float expected[variants][2];
+
+    srand(1);
+    for (int i = 0; i < variants; i++) {
+        expected[i][0] = (rand() % 1200 - 400) / 10.0f;   // -40.0 to 79.9 °C
+        expected[i][1] = (rand() % 1000) / 10.0f;
+        counts[i] = simEncodeDHT22(expected[i][0], expected[i][1], traces[i], DHT_MAX_PULSES);
+    }
+
+    unsigned long failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < frames; n++) {
+        int i = n % variants;
+        uint8_t data[5];
+        float temperature, humidity;
+        if (decodeDHT(traces[i], counts[i], data) != DHT_OK) {
+            failures++;
+            continue;
+        }
+        convertDHT22(data, temperature, humidity);
+        if (fabsf(temperature - expected[i][0]) > 0.05f || fabsf(humidity - expected[i][1]) > 0.05f) {
+            failures++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Serial.printf("%lu DHT22 frames in %.3f s: %.0f ns/frame, %lu failures\n",
+                  frames, seconds, seconds * 1e9 / frames, failures);
+}
+
+// Function to measure the cost of a PID tick; the result bounds how far PID_PERIOD can be lowered
+static void runPIDBenchmark(unsigned long ticks) {
+    PIDGains gains = getPIDGains(0);
+    PIDState states[NUM_ZONES] = {};
+    float measurements[64];
+    float sink = 0;
+
+    srand(1);
+    for (float &measurement : measurements) {
+        measurement = 18.0f + (rand() % 60) / 10.0f;
+    }
+
+    // Controller arithmetic for all NUM_ZONES zones
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < ticks; n++) {
+        for (int i = 0; i < NUM_ZONES; i++) {
+            sink += computePID(gains, states[i], 21.0f, measurements[(n + i) % 64], PID_PERIOD / 1000.0f);
+        }
+    }
+    double computeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Complete tick including the servo queue of the configured zones
+    valveModeProportional = true;
+    heaterStatus = true;
+    start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < ticks; n++) {
+        for (int i = 0; i < simulatedZones; i++) {
+            setZoneTemperature(i, measurements[(n + i) % 64]);
+        }
+        updateZonePID();
+    }
+    double tickSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double computeNs = computeSeconds * 1e9 / ticks;
+    Serial.printf("%lu PID ticks: %.0f ns/tick for %d zones (%.1f ns/zone), checksum %.0f\n",
+                  ticks, computeNs, NUM_ZONES, computeNs / NUM_ZONES, sink);
+    Serial.printf("Full tick with %d valves: %.0f ns; host CPU share at %d ms period: %.5f%%\n",
+                  simulatedZones, tickSeconds * 1e9 / ticks, PID_PERIOD, tickSeconds * 1e9 / ticks / (PID_PERIOD * 1e6) * 100);
+}
+
+// Function to measure the cost of a probe; the cycle counter of the simulator reads the host clock, so the
+// result is an upper bound for the single-instruction counter read on the ESP32
+static void runMetricsBenchmark(unsigned long probes) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < probes; n++) {
+        uint32_t probe = beginProbe();
+        endProbe(METRIC_PID, probe);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    StageSummary summary = getStageSummary(METRIC_PID);
+    Serial.printf("%lu probes: %.1f ns/probe; empty stage min %.3f us, p50 %.3f us, p99 %.3f us, max %.1f us\n",
+                  probes, seconds * 1e9 / probes, summary.min, summary.p50, summary.p99, summary.max);
+}
+
+// Function to check the DS18B20 acquisition against the fake sensors: sensor i converts at 9 + i bit, so its value
+// must be collected exactly its datasheet conversion time after the start (an early read returns the 85 °C power-on
+// value) and quantized to its resolution. The sensors then stop answering, and the age must grow from the collection
+// until the value is dropped after DS18_MAX_AGE. Returns the number of failures
+static unsigned long runDS18Check() {
+    const char* ids[] = {SENSOR6_ID, SENSOR7_ID, SENSOR8_ID, SENSOR9_ID};
+    const int count = sizeof(ids) / sizeof(ids[0]);
+    const unsigned long conversionTimes[] = {94, 188, 375, 750}; // Datasheet maximum at 9 to 12 bit (in ms)
+    const float temperature = 21.3f;
+    unsigned long collected[count];
+    unsigned long failures = 0;
+
+    simAdvance(1000); // A conversion start at millis() 0 would read as "never started"
+    for (int i = 0; i < count; i++) {
+        simSetDS18(ids[i], temperature);
+        setDS18Resolution(i, 9 + i);
+        collected[i] = 0;
+    }
+    setupDS18();
+
+    // Conversion waits and quantization; all conversions start on the first pass
+    float temps[NUM_SENSORS];
+    unsigned long start = millis();
+    int pending = count;
+    while (pending > 0 && millis() - start <= 1000) {
+        updateDS18();
+        readDS18(temps);
+        for (int i = 0; i < count; i++) {
+            if (collected[i] == 0 && !isnan(temps[i + 5])) {
+                collected[i] = millis();
+                pending--;
+                int resolution = 9 + i;
+                unsigned long wait = collected[i] - start;
+                unsigned long expectedWait = conversionTimes[i];
+                float step = 0.5f / (1 << (resolution - 9));
+                float expected = roundf(temperature / step) * step;
+                bool ok = wait == expectedWait && temps[i + 5] == expected;
+                failures += ok ? 0 : 1;
+                Serial.printf("%d bit: collected after %lu ms (expected %lu), %.4f °C (expected %.4f) %s\n",
+                              resolution, wait, expectedWait, temps[i + 5], expected, ok ? "ok" : "FAILED");
+            }
+        }
+        simAdvance(1);
+    }
+    if (pending > 0) {
+        Serial.printf("%d sensors never delivered a value\n", pending);
+        failures += pending;
+    }
+    if (getDS18Age(count) != DS18_AGE_UNKNOWN) {
+        Serial.printf("Sensor %d without a device reports age %lu\n", count, getDS18Age(count));
+        failures++;
+    }
+
+    // Value age: no further good values, so the age runs from the collection until the value is dropped
+    for (int i = 0; i < count; i++) {
+        simSetDS18(ids[i], DEVICE_DISCONNECTED_C);
+    }
+    unsigned long ageFailures = 0;
+    while (millis() - start <= 1000 + DS18_MAX_AGE + 100) {
+        updateDS18();
+        readDS18(temps);
+        for (int i = 0; i < count; i++) {
+            unsigned long age = millis() - collected[i];
+            bool ok = getDS18Age(i) == age && (age <= DS18_MAX_AGE ? !isnan(temps[i + 5]) : isnan(temps[i + 5]));
+            ageFailures += ok ? 0 : 1;
+        }
+        simAdvance(1);
+    }
+    Serial.printf("Value age: %lu mismatches over %lu ms\n", ageFailures, (unsigned long)(DS18_MAX_AGE + 100));
+    failures += ageFailures;
+
+    Serial.printf("DS18 check: %lu failures\n", failures);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    float days = 1;
+    unsigned long csvInterval = 0;
+    unsigned long benchIterations = 0;
+    unsigned long benchDHTFrames = 0;
+    unsigned long benchPIDTicks = 0;
+    unsigned long benchMetricsProbes = 0;
+    bool verbose = false;
+    bool proportional = false;
+    bool checkDS18 = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            days = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvInterval = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchIterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench-dht") == 0 && i + 1 < argc) {
+            benchDHTFrames = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench-pid") == 0 && i + 1 < argc) {
+            benchPIDTicks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench-metrics") == 0 && i + 1 < argc) {
+            benchMetricsProbes = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--check-ds18") == 0) {
+            checkDS18 = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "--proportional") == 0) {
+            proportional = true;
+        } else {
+            Serial.printf("Usage: %s [--days N] [--csv SECONDS] [--proportional] [--verbose] [--bench ITERATIONS] [--bench-dht FRAMES] [--bench-pid TICKS] [--bench-metrics PROBES] [--check-ds18]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Without --verbose nothing is drained, so logging is switched off to keep the ring buffer out of the timing
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        setLogLevel((LogModule)i, verbose ? LEVEL_INFO : LEVEL_NONE);
+    }
+
+    simReset();
+    if (checkDS18) {
+        return runDS18Check() == 0 ? 0 : 1;
+    }
+    setupPlant();
+    setupGPIO();
+    setupDHT();
+    setupDS18();
+    setupBME680();
+    setupInventory();
+    setupRouting();
+    setupServos();
+    setupPID();
+    automationActive = true;
+    valveModeProportional = proportional;
+
+    if (benchIterations > 0) {
+        runBenchmark(benchIterations);
+        return 0;
+    }
+    if (benchDHTFrames > 0) {
+        runDHTBenchmark(benchDHTFrames);
+        return 0;
+    }
+    if (benchPIDTicks > 0) {
+        runPIDBenchmark(benchPIDTicks);
+        return 0;
+    }
+    if (benchMetricsProbes > 0) {
+        runMetricsBenchmark(benchMetricsProbes);
+        return 0;
+    }
+
+    // Control tasks as registered in main.cpp
+    controlScheduler.addTask("commands", processCommands, 0, 0, 0, 0);
+    controlScheduler.addTask("ds18", ds18Task, 50, 0, 20, 1);
+    controlScheduler.addTask("bme680", bme680Task, 50, 25, 20, 1);
+    controlScheduler.addTask("dht", dhtTask, 50, 10, 20, 1);
+    controlScheduler.addTask("heater", heaterTask, 5000, 1000, 100, 2);
+    controlScheduler.addTask("toggle", heaterToggleTask, 50, 0, 20, 2);
+    controlScheduler.addTask("servos", servoTask, 5000, 1050, 100, 3);
+    controlScheduler.addTask("sensors", sensorTask, 2000, 0, 1500, 4);
+    controlScheduler.addTask("inventory", scanInventory, 100, 75, 50, 9);
+    // The PID task of the firmware; the virtual clock has no jitter, so a scheduler slot is equivalent
+    controlScheduler.addTask("pid", updateZonePID, PID_PERIOD, 0, 20, 0);
+
+    runSimulation(days, csvInterval, verbose);
+    return 0;
+}
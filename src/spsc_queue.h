@@ -0,0 +1,82 @@
+// Module: spsc_queue.h
+// Purpose: Bounded lock-free single-producer/single-consumer queue and latest-value mailbox for passing data
+//          between tasks.
+// Class:
+// - SpscQueue<T, N>: Ring buffer of N - 1 usable slots; push() is called by exactly one task, pop() by exactly one other.
+// - SpscMailbox<T>: Triple buffer that keeps only the newest item; write() never fails and replaces an unread item.
+
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Queue size must be a power of two");
+
+public:
+    // Add an item; returns false (and drops the item) if the queue is full
+    bool push(const T &item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        size_t next = (position + 1) & (N - 1);
+        if (next == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        items[position] = item;
+        head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Remove the oldest item; returns false if the queue is empty
+    bool pop(T &item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[position];
+        tail.store((position + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[N];
+    std::atomic<size_t> head{0}; // Written by the producer only
+    std::atomic<size_t> tail{0}; // Written by the consumer only
+};
+
+template <typename T>
+class SpscMailbox {
+public:
+    // Store an item, replacing one the consumer has not read yet
+    void write(const T &item) {
+        items[back] = item;
+        back = shared.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Take the newest item; returns false if nothing was written since the last read
+    bool read(T &item) {
+        if (!(shared.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = shared.exchange(front, std::memory_order_acq_rel) & INDEX;
+        item = items[front];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+    T items[3];
+    std::atomic<uint8_t> shared{1}; // Buffer between the two sides, FRESH once written
+    uint8_t back = 0;               // Written by the producer only
+    uint8_t front = 2;              // Read by the consumer only
+};
+
+#endif // SPSC_QUEUE_H
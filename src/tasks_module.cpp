@@ -0,0 +1,127 @@
+// Module: tasks_module.cpp
+// Purpose: Runs the network and control schedulers in their own FreeRTOS tasks on separate cores.
+//          The tasks exchange commands through bounded SPSC queues and telemetry through a mailbox, so a slow
+//          broker or WiFi reconnect never delays a control decision.
+// Functions:
+// - sendCommand(): Queues a command for the control task (network or HTTP side).
+// - processCommands(): Applies queued commands (control side).
+// - sendTelemetry(): Hands a snapshot of the control state to the network side (control side).
+// - receiveTelemetry(), hasTelemetry(): Return the latest snapshot (network side).
+// - startTasks(): Creates the two pinned tasks.
+
+
+#include "tasks_module.h"
+#include "spsc_queue.h"
+#include "data_module.h"
+#include "gpio_module.h"
+#include "heater_automation_module.h"
+#include "temperature_module.h"
+#include "servo_control_module.h"
+#include "log_module.h"
+#include "routing_module.h"
+#include "zone_descriptors.h"
+
+Scheduler controlScheduler;
+Scheduler networkScheduler;
+
+static SpscQueue<Command, COMMAND_QUEUE_SIZE> commandQueues[COMMAND_SOURCE_COUNT]; // Network, HTTP -> control
+static SpscMailbox<Telemetry> telemetryMailbox;                                    // Control -> network, newest only
+
+static Telemetry latestTelemetry;      // Owned by the network task
+static bool telemetryReceived = false;
+
+// Function to queue a command for the control task; returns false if the queue is full
+bool sendCommand(CommandType type, int zone, float value, CommandSource source) {
+    Command command = {type, (int8_t)zone, value};
+    if (!commandQueues[source].push(command)) {
+        LOG_WARN(LOG_MODULE_MAIN, "Command queue full, command %d dropped", (int)type);
+        return false;
+    }
+    return true;
+}
+
+// Function to apply a command; runs on the control task
+static void applyCommand(const Command &command) {
+    switch (command.type) {
+        case CMD_SET_TARGET:
+            processIncomingData(command.zone, command.value);
+            break;
+        case CMD_SET_AUTOMATION:
+            automationActive = command.value == 1;
+            break;
+        case CMD_SET_VALVE_MODE:
+            valveModeProportional = command.value == 1;
+            break;
+        case CMD_TOGGLE_HEATER:
+            clearHeaterFault(); // An explicit command tries again after a fault
+            toggleHeater(command.value == 1);
+            break;
+        case CMD_APPLY_ROUTING:
+            applyPendingRouting();
+            break;
+    }
+}
+
+// Function to apply all queued commands of all producers; runs on the control task
+void processCommands() {
+    Command command;
+    for (auto &queue : commandQueues) {
+        while (queue.pop(command)) {
+            applyCommand(command);
+        }
+    }
+}
+
+// Function to queue a snapshot of the control state; runs on the control task
+void sendTelemetry() {
+    static Telemetry snapshot;
+    for (uint8_t i : activeZones) {
+        ZoneTelemetry &zone = snapshot.zones[i];
+        zone.temperature = getZoneTemperature(i);
+        zone.humidity = zones[i].humidity;
+        zone.temperatureTarget = getZoneTarget(i);
+        zone.pressure = zones[i].pressure;
+        zone.voc = zones[i].voc;
+        zone.valvePosition = zones[i].servoValve > 0 ? getServoPosition(i) : -1;
+    }
+    snapshot.mainTemperature = mainTemperature;
+    snapshot.heaterStatus = heaterStatus;
+    snapshot.heaterFault = heaterFault;
+    snapshot.automationActive = automationActive;
+    snapshot.valveModeProportional = valveModeProportional;
+    snapshot.timestamp = millis();
+
+    // The network side only needs the newest snapshot; one it has not read yet is replaced
+    telemetryMailbox.write(snapshot);
+}
+
+// Function to get the latest snapshot; runs on the network task
+const Telemetry& receiveTelemetry() {
+    if (telemetryMailbox.read(latestTelemetry)) {
+        telemetryReceived = true;
+    }
+    return latestTelemetry;
+}
+
+bool hasTelemetry() {
+    receiveTelemetry();
+    return telemetryReceived;
+}
+
+// Task body: run a scheduler forever, yielding between passes
+static void runScheduler(void* parameter) {
+    Scheduler* scheduler = static_cast<Scheduler*>(parameter);
+    scheduler->start();
+    for (;;) {
+        scheduler->run();
+        vTaskDelay(1);
+    }
+}
+
+// Function to start the network and control tasks
+void startTasks() {
+    xTaskCreatePinnedToCore(runScheduler, "control", CONTROL_TASK_STACK, &controlScheduler,
+                            CONTROL_TASK_PRIORITY, nullptr, CONTROL_TASK_CORE);
+    xTaskCreatePinnedToCore(runScheduler, "network", NETWORK_TASK_STACK, &networkScheduler,
+                            NETWORK_TASK_PRIORITY, nullptr, NETWORK_TASK_CORE);
+}
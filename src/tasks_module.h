@@ -0,0 +1,93 @@
+// Module: tasks_module.h
+// Purpose: Declares the split into a network task (core 0) and an acquisition/control task (core 1)
+//          and the lock-free queues they use to exchange commands, and the mailbox that carries the newest
+//          telemetry snapshot.
+// Definitions:
+// - NETWORK_TASK_CORE, CONTROL_TASK_CORE: Cores the tasks are pinned to.
+// - TELEMETRY_INTERVAL: Period of telemetry snapshots sent from control to network.
+// Enumerations:
+// - CommandType: Commands from the network side to the control side.
+// - CommandSource: Producer of a command; each has its own queue, so every queue keeps one producer.
+// Structures:
+// - Command: A command with its zone and value.
+// - ZoneTelemetry, Telemetry: Snapshot of the control state for publishing.
+// External Variables:
+// - controlScheduler, networkScheduler: Schedulers run by the two tasks.
+// Function Prototypes:
+// - sendCommand(), processCommands()
+// - sendTelemetry(), receiveTelemetry(), hasTelemetry()
+// - startTasks()
+
+
+#ifndef TASKS_MODULE_H
+#define TASKS_MODULE_H
+
+#include "config.h"
+#include "scheduler_module.h"
+
+#define NETWORK_TASK_CORE 0         // WiFi, MQTT, OTA and Telnet
+#define CONTROL_TASK_CORE 1         // Sensors, heater and servos
+#define NETWORK_TASK_STACK 8192
+#define CONTROL_TASK_STACK 8192
+#define NETWORK_TASK_PRIORITY 1
+#define CONTROL_TASK_PRIORITY 2
+#define TELEMETRY_INTERVAL 1000     // Telemetry snapshot period (in ms)
+#define COMMAND_QUEUE_SIZE 16       // Power of two
+
+// Enumeration of commands sent from the network side to the control side
+enum CommandType : uint8_t {
+    CMD_SET_TARGET,       // zone, value: new target temperature
+    CMD_SET_AUTOMATION,   // value: 1 on, 0 off
+    CMD_SET_VALVE_MODE,   // value: 1 proportional, 0 on/off
+    CMD_TOGGLE_HEATER,    // value: 1 on, 0 off
+    CMD_APPLY_ROUTING     // pending routing table is ready
+};
+
+// Enumeration of command producers
+enum CommandSource : uint8_t {
+    COMMAND_SOURCE_NETWORK, // Network task: MQTT and Signal K handlers
+    COMMAND_SOURCE_HTTP,    // HTTP server task (see http_module)
+    COMMAND_SOURCE_COUNT
+};
+
+// Structure of a command
+struct Command {
+    CommandType type;
+    int8_t zone;
+    float value;
+};
+
+// Structure of the telemetry of a zone
+struct ZoneTelemetry {
+    float temperature;
+    float humidity;
+    float temperatureTarget;
+    float pressure;
+    float voc;
+    int valvePosition;      // Commanded opening percentage, -1 without servo
+};
+
+// Structure of a telemetry snapshot
+struct Telemetry {
+    ZoneTelemetry zones[NUM_ZONES];
+    float mainTemperature;
+    bool heaterStatus;
+    bool heaterFault;
+    bool automationActive;
+    bool valveModeProportional;
+    unsigned long timestamp;    // millis() when the snapshot was taken
+};
+
+// Schedulers run by the two tasks
+extern Scheduler controlScheduler;
+extern Scheduler networkScheduler;
+
+// Function prototypes
+bool sendCommand(CommandType type, int zone, float value, CommandSource source = COMMAND_SOURCE_NETWORK);
+void processCommands();
+void sendTelemetry();
+const Telemetry& receiveTelemetry();
+bool hasTelemetry();
+void startTasks();
+
+#endif // TASKS_MODULE_H
@@ -7,53 +7,50 @@
 #include "temperature_module.h"
 #include "message_module.h"
 #include "mcp41hv51_module.h"
+#include "log_module.h"
+#include "zone_descriptors.h"
 #include <Arduino.h>
 
 // External instance of the MCP41HV51 module
 extern MCP41HV51 mcp41hv51;
-// External zones array
-extern Zone zones[NUM_ZONES];
 
 // Define the mainTemperature variable
 float mainTemperature = NAN;
 
 // Function to determine the main temperature used for control logic
 float determineMainTemperature() {
-    float selectedTemperature = NAN;
+    int selectedTemperature = INT16_MAX;
     int selectedZoneIndex = -1;
 
     // Find the coldest zone below its target temperature
-    for (int i = 0; i < NUM_ZONES; i++) {
-        if (strlen(zones[i].name) > 0 && !isnan(zones[i].temperature) && !isnan(zones[i].temperatureTarget)) {
-            if (zones[i].temperature < zones[i].temperatureTarget) {
-                if (isnan(selectedTemperature) || zones[i].temperature < selectedTemperature) {
-                    selectedTemperature = zones[i].temperature;
-                    selectedZoneIndex = i;
-                }
-            }
+    uint16_t ready = zoneState.temperatureValid & zoneState.targetValid & ACTIVE_ZONE_MASK;
+    for (; ready != 0; ready &= ready - 1) {
+        int i = __builtin_ctz(ready);
+        int temperature = zoneState.temperature[i];
+        if (temperature < zoneState.target[i] && (selectedZoneIndex == -1 || temperature < selectedTemperature)) {
+            selectedTemperature = temperature;
+            selectedZoneIndex = i;
         }
     }
 
     // Fallback to zone[0] if no zone is below its target temperature
-    if (isnan(selectedTemperature)) {
-        if (!isnan(zones[0].temperature)) {
-            selectedTemperature = zones[0].temperature;
-            selectedZoneIndex = 0;
-        }
+    if (selectedZoneIndex == -1 && (zoneState.temperatureValid & ZONE_BIT(0))) {
+        selectedTemperature = zoneState.temperature[0];
+        selectedZoneIndex = 0;
     }
 
     // Update the main temperature only if it has changed
-    if (!isnan(selectedTemperature) && selectedZoneIndex != -1) {
-        float roundedTemperature = round(selectedTemperature); // Round to whole numbers
+    if (selectedZoneIndex != -1) {
+        float roundedTemperature = round(fromCentiDegrees(selectedTemperature)); // Round to whole numbers
         if (isnan(mainTemperature) || mainTemperature != roundedTemperature) {
-            Serial.printf("mainTemperature changes from %.2f to %.2f (Zone: %s)\n",
-                          mainTemperature, roundedTemperature, zones[selectedZoneIndex].name);
+            LOG_INFO(LOG_MODULE_HEATER, "mainTemperature changes from %.2f to %.2f (Zone: %s)",
+                     mainTemperature, roundedTemperature, zones[selectedZoneIndex].name);
             mainTemperature = roundedTemperature;
 
             // Set the MCP value based on the rounded main temperature
             // mcp41hv51.setTemperature(mainTemperature);
         } else {
-            Serial.printf("mainTemperature remains the same: %.2f\n", mainTemperature);
+            LOG_DEBUG(LOG_MODULE_HEATER, "mainTemperature remains the same: %.2f", mainTemperature);
         }
     }
 
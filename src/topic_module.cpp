@@ -0,0 +1,177 @@
+// Module: topic_module.cpp
+// Purpose: Builds all MQTT topics once and provides constant-time, allocation-free inbound dispatch lookup.
+//          Per-zone topics are generated at compile time from the zone descriptors (zone_descriptors.h).
+// Functions:
+// - setupTopics(): Builds inbound and outbound topics and fills the inbound hash table.
+// - hashTopic(): Computes the FNV-1a hash of a topic.
+// - findInboundTopic(): Looks up the handler and zone of an inbound topic or Signal K path.
+// - getOutboundTopic(), getZoneTopic(): Return prebuilt outbound topics (including the "W/" prefix).
+// - getOutboundPath(), getZonePath(): Return prebuilt Signal K paths used in delta documents.
+// - getSubscriptionTopic(): Returns the single wildcard subscription covering all inbound topics.
+
+
+#include "topic_module.h"
+#include "log_module.h"
+#include "zone_descriptors.h"
+#include <stdarg.h>
+
+// Pool holding all topic strings
+static char topicPool[TOPIC_POOL_SIZE];
+static size_t topicPoolUsed = 0;
+
+// Prebuilt topics
+static const char* outboundTopics[OUTBOUND_TOPIC_COUNT] = {nullptr};
+static const char* outboundPaths[OUTBOUND_TOPIC_COUNT] = {nullptr};
+static const char* subscriptionTopic = nullptr;
+static InboundTopic inboundTable[INBOUND_TABLE_SIZE];
+
+// Function to format a topic into the pool; returns nullptr if the pool is exhausted
+static const char* addTopic(const char* format, ...) {
+    char* topic = &topicPool[topicPoolUsed];
+    size_t available = TOPIC_POOL_SIZE - topicPoolUsed;
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(topic, available, format, args);
+    va_end(args);
+
+    if (length < 0 || (size_t)length >= available) {
+        LOG_ERROR(LOG_MODULE_MQTT, "Topic pool exhausted.");
+        return nullptr;
+    }
+    topicPoolUsed += length + 1;
+    return topic;
+}
+
+// Function to insert a topic into the inbound hash table (linear probing)
+static void addInboundTopic(const char* topic, InboundHandler handler, int zoneIndex) {
+    if (topic == nullptr) {
+        return;
+    }
+    uint32_t hash = hashTopic(topic);
+    for (int probe = 0; probe < INBOUND_TABLE_SIZE; probe++) {
+        InboundTopic &slot = inboundTable[(hash + probe) & (INBOUND_TABLE_SIZE - 1)];
+        if (slot.topic == nullptr) {
+            slot.topic = topic;
+            slot.hash = hash;
+            slot.handler = handler;
+            slot.zone = zoneIndex;
+            return;
+        }
+    }
+    LOG_ERROR(LOG_MODULE_MQTT, "Inbound topic table full.");
+}
+
+// FNV-1a hash of a topic string
+uint32_t hashTopic(const char* topic) {
+    uint32_t hash = 2166136261UL;
+    while (*topic) {
+        hash ^= (uint8_t)*topic++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// Function to build all topics; must run before any MQTT traffic
+void setupTopics() {
+    topicPoolUsed = 0;
+    memset(inboundTable, 0, sizeof(inboundTable));
+
+    // Single wildcard subscription, routed locally by the inbound table
+    subscriptionTopic = addTopic("N/%s/#", MQTT_BASE_PATH);
+
+    // Inbound topics
+    addInboundTopic(addTopic("N/%s/firmware_update", MQTT_BASE_PATH), HANDLER_FIRMWARE_UPDATE, -1);
+    addInboundTopic(addTopic("N/%s/toggle", MQTT_BASE_PATH), HANDLER_TOGGLE, -1);
+    addInboundTopic(addTopic("N/%s/heater_automation_mode", MQTT_BASE_PATH), HANDLER_AUTOMATION_MODE, -1);
+    addInboundTopic(addTopic("N/%s/valve_mode", MQTT_BASE_PATH), HANDLER_VALVE_MODE, -1);
+    addInboundTopic(addTopic("N/%s/sensor_ids_request", MQTT_BASE_PATH), HANDLER_SENSOR_IDS_REQUEST, -1);
+    addInboundTopic(addTopic("N/%s/log_level", MQTT_BASE_PATH), HANDLER_LOG_LEVEL, -1);
+    addInboundTopic(addTopic("N/%s/publish_mode", MQTT_BASE_PATH), HANDLER_PUBLISH_MODE, -1);
+    addInboundTopic(addTopic("N/%s/sensor_routing", MQTT_BASE_PATH), HANDLER_SENSOR_ROUTING, -1);
+    addInboundTopic(addTopic("N/%s/history_request", MQTT_BASE_PATH), HANDLER_HISTORY_REQUEST, -1);
+    addInboundTopic(addTopic("N/%s/metrics_request", MQTT_BASE_PATH), HANDLER_METRICS_REQUEST, -1);
+    addInboundTopic(addTopic("N/%s/transport", MQTT_BASE_PATH), HANDLER_TRANSPORT, -1);
+
+    // Global outbound topics
+    outboundTopics[TOPIC_MAIN_TEMPERATURE] = addTopic("W/%s/main_temperature", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_STATUS] = addTopic("W/%s/status", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_AUTOMATION_MODE] = addTopic("W/%s/heater_automation_mode", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_VALVE_MODE] = addTopic("W/%s/valve_mode", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_SENSOR_IDS_RESPONSE] = addTopic( // Historic topic, consumers expect the doubled prefix
+        "W/W/%s/sensor_ids_response", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_HEATER_FAULT] = addTopic("W/%s/heater_fault", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_HISTORY_RESPONSE] = addTopic("W/%s/history_response", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_BOOT_TIMING] = addTopic("W/%s/boot_timing", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_UPDATE_STATUS] = addTopic("W/%s/firmware_update_status", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_METRICS] = addTopic("W/%s/metrics", MQTT_BASE_PATH);
+    outboundTopics[TOPIC_KEEPALIVE] = addTopic("R/signalk/%s/keepalive", SYSTEM_ID);
+    outboundTopics[TOPIC_DELTA] = addTopic("W/signalk/%s/delta", SYSTEM_ID);
+
+    // Signal K paths of global values
+    outboundPaths[TOPIC_MAIN_TEMPERATURE] = addTopic("%s.main_temperature", SIGNALK_PATH);
+    outboundPaths[TOPIC_STATUS] = addTopic("%s.status", SIGNALK_PATH);
+    outboundPaths[TOPIC_HEATER_FAULT] = addTopic("%s.heater_fault", SIGNALK_PATH);
+    outboundPaths[TOPIC_AUTOMATION_MODE] = addTopic("%s.heater_automation_mode", SIGNALK_PATH);
+    outboundPaths[TOPIC_VALVE_MODE] = addTopic("%s.valve_mode", SIGNALK_PATH);
+
+    // Inbound Signal K paths (WebSocket transport); the mode paths carry both the state and the commands
+    addInboundTopic(addTopic("%s.toggle", SIGNALK_PATH), HANDLER_TOGGLE, -1);
+    addInboundTopic(outboundPaths[TOPIC_AUTOMATION_MODE], HANDLER_AUTOMATION_MODE, -1);
+    addInboundTopic(outboundPaths[TOPIC_VALVE_MODE], HANDLER_VALVE_MODE, -1);
+    addInboundTopic(addTopic("%s.transport", SIGNALK_PATH), HANDLER_TRANSPORT, -1);
+
+    // Inbound per-zone topics and target paths of all configured zones; the strings are generated at compile time
+    for (uint8_t i : activeZones) {
+        const ZoneTopics &topics = zoneTopicTable.zones[zoneTopicSlot.slot[i]];
+        addInboundTopic(topics.targetTemperature, HANDLER_TARGET_TEMPERATURE, i);
+        addInboundTopic(topics.pidGains, HANDLER_PID_GAINS, i);
+        addInboundTopic(topics.paths[ZONE_TOPIC_TARGET_TEMPERATURE], HANDLER_TARGET_TEMPERATURE, i);
+    }
+}
+
+// Function to look up an inbound topic; returns nullptr for unknown topics
+const InboundTopic* findInboundTopic(const char* topic) {
+    uint32_t hash = hashTopic(topic);
+    for (int probe = 0; probe < INBOUND_TABLE_SIZE; probe++) {
+        const InboundTopic &slot = inboundTable[(hash + probe) & (INBOUND_TABLE_SIZE - 1)];
+        if (slot.topic == nullptr) {
+            return nullptr;
+        }
+        if (slot.hash == hash && strcmp(slot.topic, topic) == 0) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// Function to get a global outbound topic
+const char* getOutboundTopic(OutboundTopic topic) {
+    return topic < OUTBOUND_TOPIC_COUNT ? outboundTopics[topic] : nullptr;
+}
+
+// Function to get a per-zone outbound topic; nullptr for unconfigured zones
+const char* getZoneTopic(int zoneIndex, ZoneTopic topic) {
+    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES || topic >= ZONE_TOPIC_COUNT || zoneTopicSlot.slot[zoneIndex] < 0) {
+        return nullptr;
+    }
+    return zoneTopicTable.zones[zoneTopicSlot.slot[zoneIndex]].outbound[topic];
+}
+
+// Function to get the Signal K path of a global value
+const char* getOutboundPath(OutboundTopic topic) {
+    return topic < OUTBOUND_TOPIC_COUNT ? outboundPaths[topic] : nullptr;
+}
+
+// Function to get the Signal K path of a per-zone value
+const char* getZonePath(int zoneIndex, ZoneTopic topic) {
+    if (zoneIndex < 0 || zoneIndex >= NUM_ZONES || topic >= ZONE_TOPIC_COUNT || zoneTopicSlot.slot[zoneIndex] < 0) {
+        return nullptr;
+    }
+    return zoneTopicTable.zones[zoneTopicSlot.slot[zoneIndex]].paths[topic];
+}
+
+// Function to get the wildcard subscription topic
+const char* getSubscriptionTopic() {
+    return subscriptionTopic;
+}
@@ -0,0 +1,95 @@
+// Module: topic_module.h
+// Purpose: Declares the MQTT topic registry; every inbound and outbound topic is built once at startup. The inbound
+//          table also holds the Signal K paths the WebSocket transport acts on.
+// Definitions:
+// - TOPIC_POOL_SIZE: Size of the character pool holding all topic strings.
+// - INBOUND_TABLE_SIZE: Size of the hashed inbound lookup table (power of two).
+// Enumerations:
+// - InboundHandler: Handler that processes an inbound topic.
+// - OutboundTopic: Global outbound topics.
+// - ZoneTopic: Per-zone outbound topics.
+// Structures:
+// - InboundTopic: Entry of the inbound lookup table (topic or Signal K path, hash, handler, zone index).
+// Function Prototypes:
+// - setupTopics()
+// - findInboundTopic()
+// - getOutboundTopic()
+// - getZoneTopic()
+// - getOutboundPath(), getZonePath()
+// - getSubscriptionTopic()
+
+
+#ifndef TOPIC_MODULE_H
+#define TOPIC_MODULE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TOPIC_POOL_SIZE 3072    // Characters available for the global topic strings; zone topics are constexpr
+#define INBOUND_TABLE_SIZE 128  // Slots of the inbound hash table, at least twice the number of inbound topics and paths
+
+// Enumeration of inbound topic handlers
+enum InboundHandler : uint8_t {
+    HANDLER_NONE,
+    HANDLER_FIRMWARE_UPDATE,
+    HANDLER_TOGGLE,
+    HANDLER_AUTOMATION_MODE,
+    HANDLER_VALVE_MODE,
+    HANDLER_SENSOR_IDS_REQUEST,
+    HANDLER_TARGET_TEMPERATURE,
+    HANDLER_LOG_LEVEL,
+    HANDLER_PUBLISH_MODE,
+    HANDLER_SENSOR_ROUTING,
+    HANDLER_PID_GAINS,
+    HANDLER_HISTORY_REQUEST,
+    HANDLER_METRICS_REQUEST,
+    HANDLER_TRANSPORT
+};
+
+// Enumeration of global outbound topics
+enum OutboundTopic : uint8_t {
+    TOPIC_MAIN_TEMPERATURE,
+    TOPIC_STATUS,
+    TOPIC_AUTOMATION_MODE,
+    TOPIC_VALVE_MODE,
+    TOPIC_SENSOR_IDS_RESPONSE,
+    TOPIC_HEATER_FAULT,
+    TOPIC_KEEPALIVE,
+    TOPIC_DELTA,
+    TOPIC_HISTORY_RESPONSE,
+    TOPIC_BOOT_TIMING,
+    TOPIC_UPDATE_STATUS,
+    TOPIC_METRICS,
+    OUTBOUND_TOPIC_COUNT
+};
+
+// Enumeration of per-zone outbound topics
+enum ZoneTopic : uint8_t {
+    ZONE_TOPIC_TEMPERATURE,
+    ZONE_TOPIC_HUMIDITY,
+    ZONE_TOPIC_TARGET_TEMPERATURE,
+    ZONE_TOPIC_PRESSURE,
+    ZONE_TOPIC_VOC,
+    ZONE_TOPIC_VALVE_POSITION,
+    ZONE_TOPIC_COUNT
+};
+
+// Structure of an inbound lookup table entry
+struct InboundTopic {
+    const char* topic;      // Full topic string (nullptr: empty slot)
+    uint32_t hash;          // FNV-1a hash of the topic
+    InboundHandler handler; // Handler for messages on this topic
+    int8_t zone;            // Zone index for per-zone topics, -1 otherwise
+};
+
+// Function prototypes
+void setupTopics();
+uint32_t hashTopic(const char* topic);
+const InboundTopic* findInboundTopic(const char* topic);
+const char* getOutboundTopic(OutboundTopic topic);
+const char* getZoneTopic(int zoneIndex, ZoneTopic topic);
+const char* getOutboundPath(OutboundTopic topic);
+const char* getZonePath(int zoneIndex, ZoneTopic topic);
+const char* getSubscriptionTopic();
+
+#endif // TOPIC_MODULE_H
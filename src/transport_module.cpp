@@ -0,0 +1,82 @@
+// Module: transport_module.cpp
+// Purpose: Keeps the selected transport and runs it. Only one transport is connected at a time; values are
+//          sent again in full after a switch. Documents outside the telemetry (metrics, history, boot timing,
+//          sensor inventory, update status) are MQTT only and stay queued while Signal K is selected.
+// Functions:
+// - setupTransport(): Loads the choice from NVS and prepares the Signal K client.
+// - serviceTransport(): Switches transports between two passes, never from inside a client callback.
+// - requestTransport(): Stores the choice in NVS.
+// - getTransport(), isTransportConnected()
+
+
+#include "transport_module.h"
+#include "message_module.h"
+#include "signalk_module.h"
+#include "publish_module.h"
+#include "log_module.h"
+#include "settings_module.h"
+#include <Preferences.h>
+
+static const char* const transportNames[] = {"MQTT", "Signal K"};
+
+// Active transport and the one requested by the last transport message; both owned by the network task
+static Transport activeTransport = DEFAULT_TRANSPORT;
+static Transport requestedTransport = DEFAULT_TRANSPORT;
+
+// Function to load the stored transport; runs before the network task starts
+void setupTransport() {
+    Preferences preferences;
+    uint8_t stored = DEFAULT_TRANSPORT;
+    if (preferences.begin(TRANSPORT_NVS_NAMESPACE, true)) {
+        stored = preferences.getUChar(TRANSPORT_NVS_KEY, DEFAULT_TRANSPORT);
+        preferences.end();
+    }
+    activeTransport = requestedTransport = stored == TRANSPORT_SIGNALK ? TRANSPORT_SIGNALK : TRANSPORT_MQTT;
+    setupSignalK();
+    LOG_INFO(LOG_MODULE_MQTT, "Transport: %s", transportNames[activeTransport]);
+}
+
+// Function to run the active transport; a requested change closes the old connection first
+void serviceTransport() {
+    if (requestedTransport != activeTransport) {
+        if (activeTransport == TRANSPORT_MQTT) {
+            disconnectMQTT();
+        } else {
+            disconnectSignalK();
+        }
+        activeTransport = requestedTransport;
+        resendAllData();
+        LOG_INFO(LOG_MODULE_MQTT, "Transport switched to %s", transportNames[activeTransport]);
+    }
+
+    if (activeTransport == TRANSPORT_SIGNALK) {
+        serviceSignalK();
+    } else {
+        serviceMQTT();
+    }
+}
+
+// Function to select a transport; runs on the network task, usually inside a message handler
+void requestTransport(Transport transport) {
+    if (transport == requestedTransport) {
+        return;
+    }
+    requestedTransport = transport;
+
+    Preferences preferences;
+    if (preferences.begin(TRANSPORT_NVS_NAMESPACE, false)) {
+        preferences.putUChar(TRANSPORT_NVS_KEY, transport);
+        countNVSWrite();
+        preferences.end();
+    }
+}
+
+// Function to get the active transport
+Transport getTransport() {
+    return activeTransport;
+}
+
+// Function to check whether the active transport is connected
+bool isTransportConnected() {
+    return activeTransport == TRANSPORT_SIGNALK ? isSignalKConnected() : isMQTTConnected();
+}
@@ -0,0 +1,40 @@
+// Module: transport_module.h
+// Purpose: Declares the runtime choice of the messaging transport: MQTT with Venus-style N/, W/ and R/ topics,
+//          or a direct WebSocket connection to a Signal K server. The choice is stored in NVS and can be
+//          changed on either transport through the "transport" topic or path ({"value": 0} MQTT, 1 Signal K).
+// Definitions:
+// - DEFAULT_TRANSPORT: Transport used until another one is stored.
+// - TRANSPORT_NVS_NAMESPACE, TRANSPORT_NVS_KEY: Where the choice is stored.
+// Enumerations:
+// - Transport: Available transports.
+// Function Prototypes:
+// - setupTransport(): Loads the stored choice.
+// - serviceTransport(): Applies a requested change and runs the active transport (network task).
+// - requestTransport(): Stores a new choice; it takes effect on the next network task pass.
+// - getTransport(): Returns the active transport.
+// - isTransportConnected(): Returns whether the active transport is connected.
+
+
+#ifndef TRANSPORT_MODULE_H
+#define TRANSPORT_MODULE_H
+
+#include <Arduino.h>
+
+#define DEFAULT_TRANSPORT TRANSPORT_MQTT
+#define TRANSPORT_NVS_NAMESPACE "heater"
+#define TRANSPORT_NVS_KEY "transport"
+
+// Enumeration of transports
+enum Transport : uint8_t {
+    TRANSPORT_MQTT,     // PubSubClient, one topic per value or deltas on the delta topic (see publish_module)
+    TRANSPORT_SIGNALK   // Signal K stream WebSocket, batched deltas (see signalk_module)
+};
+
+// Function prototypes
+void setupTransport();
+void serviceTransport();
+void requestTransport(Transport transport);
+Transport getTransport();
+bool isTransportConnected();
+
+#endif // TRANSPORT_MODULE_H
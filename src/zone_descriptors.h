@@ -0,0 +1,262 @@
+// Module: zone_descriptors.h
+// Purpose: Declares the heating zones once, as constexpr descriptors. Everything that depends on the zone
+//          set is derived from them at compile time: the dense lists of configured zones and of zones
+//          with a valve, the initial zone state, the default sensor routes and every per-zone MQTT topic
+//          and Signal K path. Zone loops walk these lists instead of testing names at run time.
+// Definitions:
+// - ZONE_MAX_BINDINGS: Default sensor bindings per zone.
+// - ZONE_TOPIC_SIZE: Storage per generated topic; a longer topic fails the build.
+// Structures:
+// - SensorBinding: Default route of a sensor slot to a field of the zone.
+// - ZoneDescriptor: Name, servo valve, default target and sensor bindings of a zone.
+// - ZoneList: Dense list of zone indices.
+// - ZoneTopics, ZoneTopicTable: Generated topic strings.
+// - DefaultRoutes: Generated default routing table entries.
+// Constants:
+// - zoneDescriptors[]: The zones; the position is the zone index used in NVS and on the topics.
+// - activeZones, valveZones: Configured zones and configured zones with a servo valve.
+// - ACTIVE_ZONE_MASK, VALVE_ZONE_MASK: The same sets as ZONE_BIT() masks.
+// - zoneTopicSlot[]: Position of a zone in zoneTopicTable, -1 for unconfigured zones.
+// - zoneTopicTable, defaultRoutes
+// Functions:
+// - makeZones(): Initial state of the zones array.
+// - makeZoneState(): Initial control state with the default targets.
+
+
+#ifndef ZONE_DESCRIPTORS_H
+#define ZONE_DESCRIPTORS_H
+
+#include "config.h"
+#include "zones_module.h"
+#include "topic_module.h"
+#include "routing_module.h"
+#include <utility>
+
+#define ZONE_MAX_BINDINGS 6
+#define ZONE_TOPIC_SIZE 112
+#define NO_SENSOR 0xFF
+
+// Structure of a default sensor binding
+struct SensorBinding {
+    uint8_t sensor = NO_SENSOR;     // Sensor slot (0-4 DHT, 5-14 DS18, 15-19 BME680)
+    uint8_t field = FIELD_TEMPERATURE;
+};
+
+// Structure of a zone descriptor
+struct ZoneDescriptor {
+    const char* name;               // Topic and display name; "" keeps the index free
+    int8_t servoValve;              // Servo valve number, -1 without valve
+    float defaultTarget;            // Target temperature after boot
+    SensorBinding bindings[ZONE_MAX_BINDINGS];
+};
+
+// Zone descriptors; add, remove or rename zones only here
+inline constexpr ZoneDescriptor zoneDescriptors[] = {
+    {"Cabin", 1, 4.0f, {{16, FIELD_TEMPERATURE}, {16, FIELD_HUMIDITY}, {8, FIELD_VALVE_TEMPERATURE}, {16, FIELD_PRESSURE}, {16, FIELD_VOC}}},
+    {"Bath", 2, 4.0f, {{4, FIELD_TEMPERATURE}, {4, FIELD_HUMIDITY}, {4, FIELD_PRESSURE}, {4, FIELD_VOC}}},
+    {"Plicht", 3, 4.0f, {{5, FIELD_TEMPERATURE}}},
+    {"Air Inlet", 4, 20.0f, {}},
+    {"Underfloor", 5, 23.0f, {}},
+    {"Bilge", 6, 18.0f, {}},
+    {"Reserve", 7, 20.0f, {}},
+    {"Airtronic", 8, 19.0f, {}}
+};
+inline constexpr int ZONE_DESCRIPTOR_COUNT = sizeof(zoneDescriptors) / sizeof(zoneDescriptors[0]);
+static_assert(ZONE_DESCRIPTOR_COUNT <= NUM_ZONES, "More zone descriptors than NUM_ZONES");
+
+// Topic suffixes of the per-zone outbound topics, in ZoneTopic order
+inline constexpr const char* zoneTopicNames[ZONE_TOPIC_COUNT] = {
+    "temperature", "humidity", "target_temperature", "pressure", "voc", "valve_position"
+};
+
+// Function to check whether a descriptor slot holds a configured zone
+constexpr bool isZoneConfigured(int index) {
+    return index < ZONE_DESCRIPTOR_COUNT && zoneDescriptors[index].name[0] != '\0';
+}
+
+// Function to check whether a descriptor slot holds a configured zone with a servo valve
+constexpr bool hasZoneValve(int index) {
+    return isZoneConfigured(index) && zoneDescriptors[index].servoValve > 0;
+}
+
+// Function to count the zones matching a predicate
+constexpr int countZones(bool (*predicate)(int)) {
+    int count = 0;
+    for (int i = 0; i < NUM_ZONES; i++) {
+        count += predicate(i) ? 1 : 0;
+    }
+    return count;
+}
+
+// Structure of a dense zone list; usable in range-based for loops
+template <int Count>
+struct ZoneList {
+    uint8_t index[Count > 0 ? Count : 1];
+
+    constexpr const uint8_t* begin() const { return index; }
+    constexpr const uint8_t* end() const { return index + Count; }
+    constexpr int size() const { return Count; }
+};
+
+// Function to list the zones matching a predicate in index order
+template <int Count>
+constexpr ZoneList<Count> makeZoneList(bool (*predicate)(int)) {
+    ZoneList<Count> list = {};
+    int count = 0;
+    for (int i = 0; i < NUM_ZONES; i++) {
+        if (predicate(i)) {
+            list.index[count++] = i;
+        }
+    }
+    return list;
+}
+
+inline constexpr int ACTIVE_ZONE_COUNT = countZones(isZoneConfigured);
+inline constexpr int VALVE_ZONE_COUNT = countZones(hasZoneValve);
+inline constexpr ZoneList<ACTIVE_ZONE_COUNT> activeZones = makeZoneList<ACTIVE_ZONE_COUNT>(isZoneConfigured);
+inline constexpr ZoneList<VALVE_ZONE_COUNT> valveZones = makeZoneList<VALVE_ZONE_COUNT>(hasZoneValve);
+
+// Function to build the ZONE_BIT() mask of a zone list
+template <int Count>
+constexpr uint16_t makeZoneMask(const ZoneList<Count> &list) {
+    uint16_t mask = 0;
+    for (uint8_t zone : list) {
+        mask |= ZONE_BIT(zone);
+    }
+    return mask;
+}
+
+inline constexpr uint16_t ACTIVE_ZONE_MASK = makeZoneMask(activeZones);
+inline constexpr uint16_t VALVE_ZONE_MASK = makeZoneMask(valveZones);
+
+// Structure of the position of every zone in zoneTopicTable
+struct ZoneSlots {
+    int8_t slot[NUM_ZONES];
+};
+
+// Function to map zone indices to their position in activeZones
+constexpr ZoneSlots makeZoneSlots() {
+    ZoneSlots slots = {};
+    for (int i = 0; i < NUM_ZONES; i++) {
+        slots.slot[i] = -1;
+    }
+    for (int position = 0; position < ACTIVE_ZONE_COUNT; position++) {
+        slots.slot[activeZones.index[position]] = position;
+    }
+    return slots;
+}
+
+inline constexpr ZoneSlots zoneTopicSlot = makeZoneSlots();
+
+// Structure of the generated strings of a zone
+struct ZoneTopics {
+    char outbound[ZONE_TOPIC_COUNT][ZONE_TOPIC_SIZE];   // W/<base>/<zone>/<value>
+    char paths[ZONE_TOPIC_COUNT][ZONE_TOPIC_SIZE];      // <signalk>.<zone>.<value>
+    char targetTemperature[ZONE_TOPIC_SIZE];            // N/<base>/<zone>/target_temperature
+    char pidGains[ZONE_TOPIC_SIZE];                     // N/<base>/<zone>/pid_gains
+};
+
+// Structure of the generated strings of all configured zones
+struct ZoneTopicTable {
+    ZoneTopics zones[ACTIVE_ZONE_COUNT > 0 ? ACTIVE_ZONE_COUNT : 1];
+    bool overflow;                                      // A topic did not fit ZONE_TOPIC_SIZE
+};
+
+// Function to concatenate up to seven parts into a topic; returns false if the result does not fit
+constexpr bool buildTopic(char (&topic)[ZONE_TOPIC_SIZE], const char* a, const char* b, const char* c,
+                          const char* d, const char* e, const char* f = "", const char* g = "") {
+    const char* parts[] = {a, b, c, d, e, f, g};
+    int length = 0;
+    for (const char* part : parts) {
+        for (; *part != '\0'; part++) {
+            if (length + 1 >= ZONE_TOPIC_SIZE) {
+                topic[length] = '\0';
+                return false;
+            }
+            topic[length++] = *part;
+        }
+    }
+    topic[length] = '\0';
+    return true;
+}
+
+// Function to generate the topics and paths of all configured zones
+constexpr ZoneTopicTable makeZoneTopicTable() {
+    ZoneTopicTable table = {};
+    bool fits = true;
+    for (int position = 0; position < ACTIVE_ZONE_COUNT; position++) {
+        const char* name = zoneDescriptors[activeZones.index[position]].name;
+        ZoneTopics &topics = table.zones[position];
+        for (int t = 0; t < ZONE_TOPIC_COUNT; t++) {
+            fits &= buildTopic(topics.outbound[t], "W/", MQTT_BASE_PATH, "/", name, "/", zoneTopicNames[t]);
+            fits &= buildTopic(topics.paths[t], SIGNALK_PATH, ".", name, ".", zoneTopicNames[t]);
+        }
+        fits &= buildTopic(topics.targetTemperature, "N/", MQTT_BASE_PATH, "/", name, "/target_temperature");
+        fits &= buildTopic(topics.pidGains, "N/", MQTT_BASE_PATH, "/", name, "/pid_gains");
+    }
+    table.overflow = !fits;
+    return table;
+}
+
+inline constexpr ZoneTopicTable zoneTopicTable = makeZoneTopicTable();
+static_assert(!zoneTopicTable.overflow, "A zone topic is longer than ZONE_TOPIC_SIZE");
+
+// Function to count the sensor bindings of all configured zones
+constexpr int countBindings() {
+    int count = 0;
+    for (uint8_t zone : activeZones) {
+        for (const SensorBinding &binding : zoneDescriptors[zone].bindings) {
+            count += binding.sensor != NO_SENSOR ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+inline constexpr int DEFAULT_ROUTE_COUNT = countBindings();
+static_assert(DEFAULT_ROUTE_COUNT <= MAX_ROUTES, "More sensor bindings than MAX_ROUTES");
+
+// Structure of the generated default routes
+struct DefaultRoutes {
+    Route routes[DEFAULT_ROUTE_COUNT > 0 ? DEFAULT_ROUTE_COUNT : 1];
+};
+
+// Function to generate the default routes in descriptor order
+constexpr DefaultRoutes makeDefaultRoutes() {
+    DefaultRoutes table = {};
+    int count = 0;
+    for (uint8_t zone : activeZones) {
+        for (const SensorBinding &binding : zoneDescriptors[zone].bindings) {
+            if (binding.sensor != NO_SENSOR) {
+                table.routes[count++] = {binding.sensor, zone, binding.field};
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr DefaultRoutes defaultRoutes = makeDefaultRoutes();
+
+// Function to build the initial cold data of a zone from its descriptor
+constexpr Zone makeZone(int index) {
+    return index < ZONE_DESCRIPTOR_COUNT
+        ? Zone{zoneDescriptors[index].name, NAN, NAN, zoneDescriptors[index].servoValve, NAN, NAN}
+        : Zone{"", NAN, NAN, -1, NAN, NAN};
+}
+
+// Function to build the initial cold data of all zones
+template <size_t... Index>
+constexpr std::array<Zone, NUM_ZONES> makeZones(std::index_sequence<Index...>) {
+    return {{makeZone(Index)...}};
+}
+
+// Function to build the initial control state: default targets set, no temperatures yet
+constexpr ZoneState makeZoneState() {
+    ZoneState state = {};
+    for (uint8_t zone : activeZones) {
+        state.target[zone] = toCentiDegrees(zoneDescriptors[zone].defaultTarget);
+        state.targetValid |= ZONE_BIT(zone);
+    }
+    return state;
+}
+
+#endif // ZONE_DESCRIPTORS_H
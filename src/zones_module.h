@@ -1,15 +1,69 @@
 // Module: zones_module.h
-// Purpose: Declares functions related to zone management.
+// Purpose: Declares functions related to zone management and the accessors of the zone control state.
+//          Temperatures and targets are stored as int16 centi-degrees in packed arrays with a validity bit per
+//          zone, so the control pass compares integers and tests "no data" with one mask instead of isnan().
+// Definitions:
+// - ZONE_BIT(): Bit of a zone in the validity masks.
 // Function Prototypes:
 // - assignSensorValues(): Assigns sensor data to zones.
+// - toCentiDegrees(), fromCentiDegrees(): Convert between degrees and the stored representation.
+// - setZoneTemperature(), setZoneTarget(): Store a value; NAN clears the validity bit.
+// - getZoneTemperature(), getZoneTarget(): Return a value in degrees, NAN without data.
 
 
 #ifndef ZONES_MODULE_H
 #define ZONES_MODULE_H
 
 #include "config.h"
+#include <math.h>
+
+#define ZONE_BIT(index) ((uint16_t)(1u << (index)))
+
+static_assert(NUM_ZONES <= 16, "The zone validity masks hold 16 zones");
 
 // Function prototype for assigning sensor values to zones
-void assignSensorValues(float sensors[NUM_ZONES], float hums[NUM_ZONES], float pressures[NUM_ZONES], float vocs[NUM_ZONES]);
+void assignSensorValues(float sensors[NUM_SENSORS], float hums[NUM_SENSORS], float pressures[NUM_SENSORS], float vocs[NUM_SENSORS]);
+
+// Function to convert degrees to rounded centi-degrees, saturating at the int16 range
+constexpr int16_t toCentiDegrees(float degrees) {
+    return degrees >= 327.67f ? INT16_MAX
+         : degrees <= -327.68f ? INT16_MIN
+         : (int16_t)(degrees * 100.0f + (degrees < 0 ? -0.5f : 0.5f));
+}
+
+// Function to convert centi-degrees to degrees
+constexpr float fromCentiDegrees(int16_t centiDegrees) {
+    return centiDegrees / 100.0f;
+}
+
+// Function to store the temperature of a zone; NAN marks it as missing
+inline void setZoneTemperature(int zoneIndex, float degrees) {
+    if (isnan(degrees)) {
+        zoneState.temperatureValid &= ~ZONE_BIT(zoneIndex);
+    } else {
+        zoneState.temperature[zoneIndex] = toCentiDegrees(degrees);
+        zoneState.temperatureValid |= ZONE_BIT(zoneIndex);
+    }
+}
+
+// Function to store the target of a zone; NAN marks it as unset
+inline void setZoneTarget(int zoneIndex, float degrees) {
+    if (isnan(degrees)) {
+        zoneState.targetValid &= ~ZONE_BIT(zoneIndex);
+    } else {
+        zoneState.target[zoneIndex] = toCentiDegrees(degrees);
+        zoneState.targetValid |= ZONE_BIT(zoneIndex);
+    }
+}
+
+// Function to return the temperature of a zone in degrees; NAN without a measurement
+inline float getZoneTemperature(int zoneIndex) {
+    return (zoneState.temperatureValid & ZONE_BIT(zoneIndex)) ? fromCentiDegrees(zoneState.temperature[zoneIndex]) : NAN;
+}
+
+// Function to return the target of a zone in degrees; NAN if unset
+inline float getZoneTarget(int zoneIndex) {
+    return (zoneState.targetValid & ZONE_BIT(zoneIndex)) ? fromCentiDegrees(zoneState.target[zoneIndex]) : NAN;
+}
 
 #endif // ZONES_MODULE_H